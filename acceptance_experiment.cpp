@@ -0,0 +1,207 @@
+// Measures the acceptance ratio of each partitioning option (see partition.h) on
+// random tasksets and writes it as CSV, one row per total utilization.
+// Usage: acceptance_experiment [--name value ...] with the names
+//   seed N             experiment seed (1)
+//   tasksets N         tasksets per utilization (1000)
+//   cores N            number of cores (16)
+//   utilization a:b:s  total utilization from a to b in steps of s, as a fraction of the cores (0.05:1:0.05)
+//   periods a:b        period range in milliseconds, log-uniform (10:1000)
+//   deadline-ratio a:b deadline range as a fraction of the period (1:1)
+//   heavy-fraction f   probability that a task is heavy (0.2)
+//   heavy-util a:b     utilization range of heavy tasks (1:4)
+//   light-util a:b     utilization range of light tasks (0.01:0.5)
+//   span-ratio a:b     span of heavy tasks as a fraction of their work (0.05:0.3)
+//   options a,b,...    partitioning options to run (all)
+//   search-seconds s   time limit of each search of the optimal fit, 0 for none (1)
+//   output file        CSV file (standard output)
+// A taskset is accepted by an option if the partition is guaranteed schedulable.
+// The number of accepted tasksets whose light tasks would miss deadlines with
+// rate monotonic priorities on the same cores is reported for each option.
+// The tasksets are spread over the OpenMP threads, which share nothing but the
+// distribution, and each is generated from its own seed, so the output depends
+// only on the arguments, as long as no search of the optimal fit runs out of
+// time. The number of searches that do is reported for each option.
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <omp.h>
+#include "partition.h"
+#include "taskset_generator.h"
+#include "timespec_functions.h"
+
+enum rt_gomp_acceptance_experiment_error_codes
+{
+	RT_GOMP_ACCEPTANCE_EXPERIMENT_SUCCESS,
+	RT_GOMP_ACCEPTANCE_EXPERIMENT_ARG_PARSE_ERROR,
+	RT_GOMP_ACCEPTANCE_EXPERIMENT_FILE_OPEN_ERROR
+};
+
+template <typename T> static bool parse_value(const char *text, T *value)
+{
+	std::istringstream stream(text);
+	return stream >> *value && stream.peek() == EOF;
+}
+
+// Parses "a:b" or, if step is not NULL, "a:b:s"
+static bool parse_range(const char *text, double *min, double *max, double *step = NULL)
+{
+	std::istringstream stream(text);
+	char colon1, colon2;
+	if (!(stream >> *min >> colon1 >> *max) || colon1 != ':' || *max < *min) return false;
+	if (step == NULL) return stream.peek() == EOF;
+	return stream >> colon2 >> *step && colon2 == ':' && *step > 0 && stream.peek() == EOF;
+}
+
+static bool parse_options(const char *text, std::vector<partition_option_t> & options)
+{
+	std::istringstream stream(text);
+	std::string name;
+	while (std::getline(stream, name, ','))
+	{
+		const partition_option_t *option = find_partition_option(name.c_str());
+		if (option == NULL)
+		{
+			fprintf(stderr, "ERROR: Unknown partitioning option %s\n", name.c_str());
+			return false;
+		}
+		options.push_back(*option);
+	}
+	return !options.empty();
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned long seed = 1, num_tasksets = 1000;
+	double min_util = 0.05, max_util = 1.0, util_step = 0.05;
+	double min_period = 10, max_period = 1000;
+	double search_seconds = partition_default_search_seconds;
+	const char *output_filename = NULL;
+	std::vector<partition_option_t> options;
+
+	taskset_distribution_t distribution;
+	distribution.num_cores = 16;
+	distribution.heavy_fraction = 0.2;
+	distribution.min_heavy_util = 1;
+	distribution.max_heavy_util = 4;
+	distribution.min_light_util = 0.01;
+	distribution.max_light_util = 0.5;
+	distribution.min_span_ratio = 0.05;
+	distribution.max_span_ratio = 0.3;
+	distribution.min_deadline_ratio = 1;
+	distribution.max_deadline_ratio = 1;
+
+	bool valid = argc % 2 == 1;
+	for (int i = 1; valid && i + 1 < argc; i += 2)
+	{
+		const char *name = argv[i], *value = argv[i + 1];
+		if (strcmp(name, "--seed") == 0) valid = parse_value(value, &seed);
+		else if (strcmp(name, "--tasksets") == 0) valid = parse_value(value, &num_tasksets) && num_tasksets > 0;
+		else if (strcmp(name, "--cores") == 0) valid = parse_value(value, &distribution.num_cores) && distribution.num_cores > 0;
+		else if (strcmp(name, "--utilization") == 0) valid = parse_range(value, &min_util, &max_util, &util_step) && min_util > 0;
+		else if (strcmp(name, "--periods") == 0) valid = parse_range(value, &min_period, &max_period) && min_period > 0;
+		else if (strcmp(name, "--deadline-ratio") == 0) valid = parse_range(value, &distribution.min_deadline_ratio, &distribution.max_deadline_ratio) &&
+			distribution.min_deadline_ratio > 0 && distribution.max_deadline_ratio <= 1;
+		else if (strcmp(name, "--heavy-fraction") == 0) valid = parse_value(value, &distribution.heavy_fraction);
+		else if (strcmp(name, "--heavy-util") == 0) valid = parse_range(value, &distribution.min_heavy_util, &distribution.max_heavy_util);
+		else if (strcmp(name, "--light-util") == 0) valid = parse_range(value, &distribution.min_light_util, &distribution.max_light_util) && distribution.min_light_util > 0;
+		else if (strcmp(name, "--span-ratio") == 0) valid = parse_range(value, &distribution.min_span_ratio, &distribution.max_span_ratio);
+		else if (strcmp(name, "--options") == 0) valid = parse_options(value, options);
+		else if (strcmp(name, "--search-seconds") == 0) valid = parse_value(value, &search_seconds) && search_seconds >= 0;
+		else if (strcmp(name, "--output") == 0) output_filename = value;
+		else valid = false;
+	}
+	if (!valid)
+	{
+		fprintf(stderr, "ERROR: Invalid arguments, see the top of acceptance_experiment.cpp\n");
+		return RT_GOMP_ACCEPTANCE_EXPERIMENT_ARG_PARSE_ERROR;
+	}
+	if (options.empty()) options.assign(partition_options, partition_options + num_partition_options);
+	distribution.min_period = static_cast<int64_t>(min_period * nanosec_in_millisec);
+	distribution.max_period = static_cast<int64_t>(max_period * nanosec_in_millisec);
+
+	FILE *output = output_filename == NULL ? stdout : fopen(output_filename, "w");
+	if (output == NULL)
+	{
+		perror("ERROR: acceptance_experiment call to fopen failed");
+		return RT_GOMP_ACCEPTANCE_EXPERIMENT_FILE_OPEN_ERROR;
+	}
+
+	const unsigned num_points = static_cast<unsigned>((max_util - min_util) / util_step + 1e-9) + 1;
+	const unsigned num_options = options.size();
+	std::vector<unsigned long> accepted(num_points * num_options, 0), rm_rejected(num_options, 0), timed_out(num_options, 0);
+
+	timespec start, end, elapsed;
+	get_time(&start);
+
+	#pragma omp parallel
+	{
+		// Per thread counts and scratch space, merged at the end
+		std::vector<unsigned long> thread_accepted(num_points * num_options, 0), thread_rm_rejected(num_options, 0), thread_timed_out(num_options, 0);
+		partition_problem_t problem;
+		partition_result_t result;
+
+		#pragma omp for schedule(dynamic, 64) nowait
+		for (unsigned long i = 0; i < num_points * num_tasksets; ++i)
+		{
+			const unsigned point = i / num_tasksets;
+			const double total_util = (min_util + point * util_step) * distribution.num_cores;
+			generate_taskset(&distribution, total_util, taskset_seed(seed, point, i % num_tasksets), &problem);
+			problem.search_seconds = search_seconds;
+			for (unsigned k = 0; k < num_options; ++k)
+			{
+				partition_run(&problem, &options[k], &result);
+				if (options[k].fit == PARTITION_OPTIMAL_FIT && result.search_timed_out) thread_timed_out[k] += 1;
+				if (result.sched != PARTITION_SCHEDULABLE) continue;
+				thread_accepted[point * num_options + k] += 1;
+				if (!result.rm_schedulable) thread_rm_rejected[k] += 1;
+			}
+		}
+
+		#pragma omp critical
+		{
+			for (unsigned j = 0; j < accepted.size(); ++j) accepted[j] += thread_accepted[j];
+			for (unsigned k = 0; k < num_options; ++k)
+			{
+				rm_rejected[k] += thread_rm_rejected[k];
+				timed_out[k] += thread_timed_out[k];
+			}
+		}
+	}
+
+	get_time(&end);
+	ts_diff(start, end, elapsed);
+
+	fprintf(output, "utilization,normalized_utilization,tasksets");
+	for (unsigned k = 0; k < num_options; ++k) fprintf(output, ",%s", options[k].name);
+	fprintf(output, "\n");
+	for (unsigned point = 0; point < num_points; ++point)
+	{
+		const double normalized_util = min_util + point * util_step;
+		fprintf(output, "%g,%g,%lu", normalized_util * distribution.num_cores, normalized_util, num_tasksets);
+		for (unsigned k = 0; k < num_options; ++k)
+		{
+			fprintf(output, ",%.4f", 1.0 * accepted[point * num_options + k] / num_tasksets);
+		}
+		fprintf(output, "\n");
+	}
+	if (output != stdout) fclose(output);
+
+	for (unsigned k = 0; k < num_options; ++k)
+	{
+		if (rm_rejected[k] == 0) continue;
+		fprintf(stderr, "%s: %lu accepted tasksets would miss deadlines with rate monotonic priorities\n", options[k].name, rm_rejected[k]);
+	}
+	for (unsigned k = 0; k < num_options; ++k)
+	{
+		if (timed_out[k] == 0) continue;
+		fprintf(stderr, "%s: %lu searches ran out of time\n", options[k].name, timed_out[k]);
+	}
+
+	const double seconds = elapsed.tv_sec + elapsed.tv_nsec / 1e9;
+	fprintf(stderr, "Partitioned %lu tasksets with %u options on %d threads in %.2f s (%.0f tasksets per second)\n",
+		num_points * num_tasksets, num_options, omp_get_max_threads(), seconds, num_points * num_tasksets / seconds);
+	return RT_GOMP_ACCEPTANCE_EXPERIMENT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+#!/usr/bin/python
+
+import io
+import sys
+import contextlib
+
+#./admission_report.py taskset [taskset ...]
+#compares the admission tests for light tasks (see original() in lib_cluster.py):
+#for each .rtpt file (given by its prefix), the fewest cores on which the
+#partition is guaranteed schedulable with the utilization bound and with exact
+#response time analysis, and the number of cores that the analysis saves.
+#The bound is applied to scaled periods, so the last column counts the cores of
+#the bound's partition on which response time analysis finds a deadline miss.
+import lib_cluster
+from lib_cluster import *
+from cluster import readinput
+
+#fewest cores that give a guaranteed schedulable partition (option 0, no load
+#balancing) with the current admission test, or 0 if there is none, and the
+#partition on that many cores
+def min_cores(info):
+	#every heavy task fits on its own cores and every light task on one core
+	maxcores = 0
+	for prog in info:
+		if prog[2] >= 1.0:
+			maxcores += max(2, int(math.ceil(1.0*(prog[3]-prog[4])/(deadline(prog)-prog[4]))))
+		else:
+			maxcores += 1
+	for corenum in range(1, maxcores+1):
+		#cluster_partition prints the clusters of heavy tasks
+		with contextlib.redirect_stdout(io.StringIO()):
+			(sched, corestr, outinfo) = cluster_partition(copy.deepcopy(info), len(info), corenum, 0)
+		if sched == 0:
+			return corenum, corestr
+	return 0, []
+
+#number of single cores in corestr whose tasks miss a deadline under their priorities
+def unsafe_cores(corestr):
+	unsafe = 0
+	for progs in corestr:
+		if len(progs) < 2 or progs[0][6] != progs[0][7]:
+			continue
+		core = RTACore()
+		for prog in progs:
+			core.force_add(prog, prog[5])
+		if not core.schedulable():
+			unsafe += 1
+	return unsafe
+
+def admission_report(inputnames):
+	if lib_cluster.libpartition is None:
+		print('libpartition.so not found, run make first')
+		return 1
+	print('%-24s %6s %12s %10s %6s %12s' % ('taskset', 'tasks', 'bound cores', 'rta cores', 'saved', 'bound unsafe'))
+	total = [0, 0, 0]
+	for inputname in inputnames:
+		(info, corenum, rawinfo) = readinput(inputname)
+		if info == []:
+			print('%-24s invalid' % inputname)
+			continue
+		lib_cluster.deadlines = rawinfo[4]
+		cores = []
+		for test in ['bound', 'rta']:
+			lib_cluster.admission = test
+			(corenum, corestr) = min_cores(info)
+			cores.append(corenum)
+			if test == 'bound':
+				unsafe = unsafe_cores(corestr)
+		lib_cluster.admission = 'rta'
+		if 0 in cores:
+			print('%-24s %6d %12d %10d %6s %12d' % (inputname, len(info), cores[0], cores[1], '-', unsafe))
+			continue
+		total[0] += cores[0]
+		total[1] += cores[1]
+		total[2] += unsafe
+		print('%-24s %6d %12d %10d %6d %12d' % (inputname, len(info), cores[0], cores[1], cores[0]-cores[1], unsafe))
+	print('%-24s %6s %12d %10d %6d %12d' % ('total', '', total[0], total[1], total[0]-total[1], total[2]))
+	return 0
+
+if __name__ == '__main__':
+	if len(sys.argv) < 2:
+		print('Usage: admission_report.py taskset [taskset ...]')
+		sys.exit(1)
+	sys.exit(admission_report(sys.argv[1:]))
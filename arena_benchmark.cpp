@@ -0,0 +1,124 @@
+// Compares TLB misses and running time of a random access workload on task arena
+// memory backed by 4 KB pages and by huge pages.
+// Usage: arena_benchmark [arena_megabytes [accesses_per_job [num_jobs]]]
+// The dTLB load misses are counted with perf_event_open. If the processor or
+// kernel does not expose the counter, only the running times are reported.
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <sstream>
+#include <omp.h>
+#include "task_arena.h"
+#include "timespec_functions.h"
+
+enum rt_gomp_arena_benchmark_error_codes
+{
+	RT_GOMP_ARENA_BENCHMARK_SUCCESS,
+	RT_GOMP_ARENA_BENCHMARK_ARG_PARSE_ERROR,
+	RT_GOMP_ARENA_BENCHMARK_ARENA_ERROR
+};
+
+// Opens a counter of data TLB load misses for the calling thread in user mode. Returns -1 on failure.
+static int open_dtlb_miss_counter()
+{
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HW_CACHE;
+	attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// Reads random doubles from the arena. The index sequence is the same for every job.
+static double random_reads(const double *data, size_t num_doubles, unsigned long num_accesses)
+{
+	uint64_t state = 88172645463325252ULL;
+	double sum = 0;
+	for (unsigned long i = 0; i < num_accesses; ++i)
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		sum += data[state % num_doubles];
+	}
+	return sum;
+}
+
+static int benchmark(size_t arena_bytes, unsigned long num_accesses, unsigned num_jobs, int flags)
+{
+	task_arena_t arena;
+	if (task_arena_create(&arena, arena_bytes, flags | TASK_ARENA_PREFAULT) != 0)
+	{
+		return RT_GOMP_ARENA_BENCHMARK_ARENA_ERROR;
+	}
+	
+	const size_t num_doubles = arena.size / sizeof(double);
+	double *data = static_cast<double *>(task_arena_alloc(&arena, num_doubles * sizeof(double)));
+	for (size_t i = 0; i < num_doubles; ++i) data[i] = i;
+	
+	int counter = open_dtlb_miss_counter();
+	timespec start, finish, runtime, total = { 0, 0 }, wcet = { 0, 0 };
+	volatile double sink = 0;
+	
+	if (counter != -1)
+	{
+		ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+		ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+	}
+	for (unsigned j = 0; j < num_jobs; ++j)
+	{
+		get_time(&start);
+		sink = sink + random_reads(data, num_doubles, num_accesses);
+		get_time(&finish);
+		ts_diff(start, finish, runtime);
+		total = total + runtime;
+		if (runtime > wcet) wcet = runtime;
+	}
+	
+	long long misses = -1;
+	if (counter != -1)
+	{
+		ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+		if (read(counter, &misses, sizeof(misses)) != sizeof(misses)) misses = -1;
+		close(counter);
+	}
+	
+	printf("%-24s ", task_arena_page_kind_name(arena.page_kind));
+	std::cout << "mean " << total / num_jobs << " secs, wcet " << wcet << " secs, ";
+	if (misses >= 0) printf("dTLB load misses per job %lld\n", misses / num_jobs);
+	else printf("dTLB load misses not available\n");
+	
+	task_arena_destroy(&arena);
+	return RT_GOMP_ARENA_BENCHMARK_SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t arena_megabytes = 512;
+	unsigned long num_accesses = 10000000;
+	unsigned num_jobs = 10;
+	if (!(
+		(argc <= 1 || (std::istringstream(argv[1]) >> arena_megabytes && arena_megabytes > 0)) &&
+		(argc <= 2 || (std::istringstream(argv[2]) >> num_accesses)) &&
+		(argc <= 3 || (std::istringstream(argv[3]) >> num_jobs && num_jobs > 0))
+	))
+	{
+		fprintf(stderr, "ERROR: Cannot parse arguments\n");
+		return RT_GOMP_ARENA_BENCHMARK_ARG_PARSE_ERROR;
+	}
+	
+	printf("%zu MB arena, %lu random reads per job, %u jobs\n", arena_megabytes, num_accesses, num_jobs);
+	
+	const size_t arena_bytes = arena_megabytes * 1024 * 1024;
+	int ret_val = benchmark(arena_bytes, num_accesses, num_jobs, TASK_ARENA_SMALL_PAGES);
+	if (ret_val == 0) ret_val = benchmark(arena_bytes, num_accesses, num_jobs, 0);
+	return ret_val;
+}
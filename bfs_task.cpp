@@ -0,0 +1,199 @@
+// A breadth first search task over a random graph that uses OpenMP
+// Call the functions with the following arguments in argv: executable_name num_vertices avg_degree [seed]
+// Each job computes the BFS level of every vertex from vertex 0 with a level synchronous
+// traversal. In each level every thread scans its range of vertices for the current
+// frontier and claims unvisited neighbors with compare-and-swap, so the work per level,
+// the memory accesses and the contention are irregular and data dependent.
+// finalize checks the levels against a serial BFS.
+
+#include <omp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sstream>
+#include <new>
+#include "task.h"
+#include "first_touch.h"
+
+size_t num_vertices, avg_degree;
+unsigned seed = 1;
+size_t *adjacency_start, *adjacency;
+long *level;
+int more_levels[3];
+unsigned jobs_completed = 0;
+
+enum rt_gomp_bfs_task_error_codes
+{
+	RT_GOMP_BFS_TASK_SUCCESS,
+	RT_GOMP_BFS_TASK_INVALID_ARGUMENTS,
+	RT_GOMP_BFS_TASK_MEM_ALLOC_ERROR,
+	RT_GOMP_BFS_TASK_VERIFY_ERROR
+};
+
+int init(int argc, char *argv[])
+{
+	if (!(
+		(argc == 3 || argc == 4) &&
+		std::istringstream(argv[1]) >> num_vertices && num_vertices > 0 &&
+		std::istringstream(argv[2]) >> avg_degree &&
+		(argc == 3 || std::istringstream(argv[3]) >> seed)
+	))
+	{
+		fprintf(stderr, "ERROR: Invalid initialization arguments");
+		return RT_GOMP_BFS_TASK_INVALID_ARGUMENTS;
+	}
+
+	// Build a random directed graph in CSR form. The first edge of every vertex
+	// forms a ring through all vertices, which keeps the graph connected, and is
+	// followed by between 0 and twice the average number of random edges.
+	adjacency_start = new (std::nothrow) size_t[num_vertices + 1];
+	if (!adjacency_start)
+	{
+		fprintf(stderr, "ERROR: Memory allocation failed");
+		return RT_GOMP_BFS_TASK_MEM_ALLOC_ERROR;
+	}
+
+	srand48(seed);
+	adjacency_start[0] = 0;
+	for (size_t v = 0; v < num_vertices; ++v)
+	{
+		adjacency_start[v + 1] = adjacency_start[v] + 1 + lrand48() % (2 * avg_degree + 1);
+	}
+
+	adjacency = new (std::nothrow) size_t[adjacency_start[num_vertices]];
+	level = new (std::nothrow) long[num_vertices];
+	if (!adjacency || !level)
+	{
+		fprintf(stderr, "ERROR: Memory allocation failed");
+		return RT_GOMP_BFS_TASK_MEM_ALLOC_ERROR;
+	}
+
+	// Each thread scans the adjacency lists of its own range of vertices in run.
+	// Level updates are data dependent, so they are simply spread over the threads.
+	#pragma omp parallel
+	{
+		size_t begin, end;
+		omp_static_range(num_vertices, 1, &begin, &end);
+		memset(adjacency + adjacency_start[begin], 0, (adjacency_start[end] - adjacency_start[begin]) * sizeof(size_t));
+	}
+	first_touch(level, num_vertices, sizeof(long));
+
+	for (size_t v = 0; v < num_vertices; ++v)
+	{
+		adjacency[adjacency_start[v]] = (v + 1) % num_vertices;
+		for (size_t k = adjacency_start[v] + 1; k < adjacency_start[v + 1]; ++k)
+		{
+			adjacency[k] = lrand48() % num_vertices;
+		}
+	}
+
+	return 0;
+}
+
+int run(int argc, char *argv[])
+{
+	#pragma omp parallel
+	{
+		const int thread_num = omp_get_thread_num();
+		size_t begin, end;
+		omp_static_range(num_vertices, 1, &begin, &end);
+		for (size_t v = begin; v < end; ++v) level[v] = -1;
+
+		#pragma omp barrier
+		#pragma omp single
+		{
+			level[0] = 0;
+			more_levels[0] = 0;
+		}
+
+		for (long depth = 0; ; ++depth)
+		{
+			// The flag for the next level is cleared during this level. Using three
+			// flags ensures no thread is still reading a flag when it is cleared.
+			if (thread_num == 0) more_levels[(depth + 1) % 3] = 0;
+
+			bool claimed = false;
+			for (size_t u = begin; u < end; ++u)
+			{
+				if (level[u] != depth) continue;
+				for (size_t k = adjacency_start[u]; k < adjacency_start[u + 1]; ++k)
+				{
+					const size_t v = adjacency[k];
+					if (level[v] == -1 && __sync_bool_compare_and_swap(&level[v], -1, depth + 1))
+					{
+						claimed = true;
+					}
+				}
+			}
+
+			if (claimed)
+			{
+				#pragma omp atomic write
+				more_levels[depth % 3] = 1;
+			}
+
+			#pragma omp barrier
+			int more;
+			#pragma omp atomic read
+			more = more_levels[depth % 3];
+			if (!more) break;
+		}
+	}
+
+	jobs_completed += 1;
+	return 0;
+}
+
+int finalize(int argc, char *argv[])
+{
+	int ret_val = RT_GOMP_BFS_TASK_SUCCESS;
+
+	if (jobs_completed > 0)
+	{
+		long *reference = new (std::nothrow) long[num_vertices];
+		size_t *queue = new (std::nothrow) size_t[num_vertices];
+		if (!reference || !queue)
+		{
+			fprintf(stderr, "ERROR: Memory allocation failed");
+			return RT_GOMP_BFS_TASK_MEM_ALLOC_ERROR;
+		}
+
+		for (size_t v = 0; v < num_vertices; ++v) reference[v] = -1;
+		reference[0] = 0;
+		queue[0] = 0;
+		size_t head = 0, tail = 1;
+		while (head < tail)
+		{
+			const size_t u = queue[head++];
+			for (size_t k = adjacency_start[u]; k < adjacency_start[u + 1]; ++k)
+			{
+				const size_t v = adjacency[k];
+				if (reference[v] == -1)
+				{
+					reference[v] = reference[u] + 1;
+					queue[tail++] = v;
+				}
+			}
+		}
+
+		for (size_t v = 0; v < num_vertices; ++v)
+		{
+			if (level[v] != reference[v])
+			{
+				fprintf(stderr, "ERROR: bfs level of vertex %zu = %ld, expected %ld\n", v, level[v], reference[v]);
+				ret_val = RT_GOMP_BFS_TASK_VERIFY_ERROR;
+				break;
+			}
+		}
+
+		delete[] reference;
+		delete[] queue;
+	}
+
+	delete[] adjacency_start;
+	delete[] adjacency;
+	delete[] level;
+	return ret_val;
+}
+
+task_t task = { init, run, finalize };
@@ -0,0 +1,51 @@
+#include "budget_reservation.h"
+#include <errno.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+
+// The kernel's struct sched_attr, which older C libraries do not declare
+typedef struct
+{
+	uint32_t size;
+	uint32_t sched_policy;
+	uint64_t sched_flags;
+	int32_t sched_nice;
+	uint32_t sched_priority;
+	uint64_t sched_runtime;
+	uint64_t sched_deadline;
+	uint64_t sched_period;
+}
+deadline_attr_t;
+
+static uint64_t to_ns(const timespec & ts)
+{
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+int reserve_budget(const timespec & budget, const timespec & period)
+{
+	if (to_ns(budget) < static_cast<uint64_t>(min_budget_ns))
+	{
+		errno = EINVAL;
+		return RT_GOMP_BUDGET_RESERVATION_BUDGET_TOO_SMALL_ERROR;
+	}
+
+	deadline_attr_t attr = {};
+	attr.size = sizeof(attr);
+	attr.sched_policy = SCHED_DEADLINE;
+	attr.sched_runtime = to_ns(budget);
+	attr.sched_deadline = to_ns(period);
+	attr.sched_period = to_ns(period);
+
+	// A pid of zero refers to the calling thread
+	if (syscall(SYS_sched_setattr, 0, &attr, 0) != 0)
+	{
+		return RT_GOMP_BUDGET_RESERVATION_SETATTR_FAILED_ERROR;
+	}
+	return RT_GOMP_BUDGET_RESERVATION_SUCCESS;
+}
@@ -0,0 +1,38 @@
+#ifndef RT_GOMP_BUDGET_RESERVATION_H
+#define RT_GOMP_BUDGET_RESERVATION_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Budget reservations for semi-federated tasks (see partition.h), which share
+// the last core of their cluster with light tasks. The task's thread on that
+// core runs under SCHED_DEADLINE with the budget as its runtime and the budget
+// period as its deadline and period, so it gets its budget in every budget
+// period but can never take more of the core than that. SCHED_DEADLINE preempts
+// every SCHED_FIFO task, which the response time analysis of the light tasks on
+// the core accounts for (see rta.h).
+//
+// Linux only accepts SCHED_DEADLINE for a thread whose affinity spans its whole
+// root domain, so the shared core must be a cpuset partition of its own (for
+// example cpuset.cpus.partition set to "isolated" for that core). Budget spent
+// spinning in OpenMP barriers counts too, so tasks with a budget should run
+// with OMP_WAIT_POLICY=passive.
+
+enum rt_gomp_budget_reservation_error_codes
+{
+	RT_GOMP_BUDGET_RESERVATION_SUCCESS,
+	RT_GOMP_BUDGET_RESERVATION_SETATTR_FAILED_ERROR,
+	RT_GOMP_BUDGET_RESERVATION_BUDGET_TOO_SMALL_ERROR
+};
+
+// The kernel rejects runtimes below 1 << DL_SCALE ns, so the partitioner never
+// gives a semi-federated task a smaller budget (see partition.h)
+static const int64_t min_budget_ns = 1024;
+
+// Runs the calling thread under SCHED_DEADLINE with budget runtime every period.
+// A budget below min_budget_ns is refused with errno EINVAL rather than raised,
+// since the analysis did not account for more. On failure errno is set by
+// sched_setattr and the thread is unchanged.
+int reserve_budget(const timespec & budget, const timespec & period);
+
+#endif /* RT_GOMP_BUDGET_RESERVATION_H */
@@ -0,0 +1,99 @@
+// An example of tasks exchanging data through a task channel (see task_channel.h)
+// Call the functions with the following arguments in argv:
+//     executable_name producer channel_name num_doubles [num_consumers]
+//     executable_name consumer channel_name num_doubles [num_consumers]
+// Each producer job fills its message with its job number in parallel. Each consumer
+// job reads the message sampled at its release and checks that all elements agree,
+// which would fail if a message could change while it is read, and that messages
+// never go back in time. finalize reports how many distinct messages were seen.
+
+#include <omp.h>
+#include <stdio.h>
+#include <string.h>
+#include <sstream>
+#include <string>
+#include "task.h"
+#include "task_channel.h"
+
+std::string channel_name;
+size_t num_doubles;
+unsigned num_consumers = 1;
+task_channel_t channel;
+task_channel_role role;
+unsigned long jobs_completed = 0, messages_seen = 0, last_sequence = 0, errors = 0;
+
+enum rt_gomp_channel_task_error_codes
+{
+	RT_GOMP_CHANNEL_TASK_SUCCESS,
+	RT_GOMP_CHANNEL_TASK_INVALID_ARGUMENTS,
+	RT_GOMP_CHANNEL_TASK_CHANNEL_ERROR,
+	RT_GOMP_CHANNEL_TASK_VERIFY_ERROR
+};
+
+int init(int argc, char *argv[])
+{
+	if (!(
+		(argc == 4 || argc == 5) &&
+		(strcmp(argv[1], "producer") == 0 || strcmp(argv[1], "consumer") == 0) &&
+		std::istringstream(argv[2]) >> channel_name &&
+		std::istringstream(argv[3]) >> num_doubles && num_doubles > 0 &&
+		(argc == 4 || std::istringstream(argv[4]) >> num_consumers)
+	))
+	{
+		fprintf(stderr, "ERROR: Invalid initialization arguments");
+		return RT_GOMP_CHANNEL_TASK_INVALID_ARGUMENTS;
+	}
+
+	role = (strcmp(argv[1], "producer") == 0) ? TASK_CHANNEL_PRODUCER : TASK_CHANNEL_CONSUMER;
+	if (task_channel_open(&channel, channel_name.c_str(), num_doubles * sizeof(double), num_consumers, role) != 0)
+	{
+		return RT_GOMP_CHANNEL_TASK_CHANNEL_ERROR;
+	}
+	return 0;
+}
+
+int run(int argc, char *argv[])
+{
+	jobs_completed += 1;
+
+	if (role == TASK_CHANNEL_PRODUCER)
+	{
+		double *message = static_cast<double *>(task_channel_write_buffer(&channel));
+		#pragma omp parallel for schedule(static)
+		for (size_t i = 0; i < num_doubles; ++i)
+		{
+			message[i] = jobs_completed;
+		}
+		return 0;
+	}
+
+	const double *message = static_cast<const double *>(task_channel_read_buffer(&channel));
+	const unsigned long sequence = task_channel_read_sequence(&channel);
+	unsigned long mismatches = 0;
+	#pragma omp parallel for schedule(static) reduction(+:mismatches)
+	for (size_t i = 0; i < num_doubles; ++i)
+	{
+		if (message[i] != message[0]) mismatches += 1;
+	}
+
+	if (mismatches > 0 || sequence < last_sequence || (sequence > 0 && message[0] != sequence))
+	{
+		errors += 1;
+	}
+	if (sequence != last_sequence) messages_seen += 1;
+	last_sequence = sequence;
+	return 0;
+}
+
+int finalize(int argc, char *argv[])
+{
+	if (role == TASK_CHANNEL_CONSUMER)
+	{
+		fprintf(stderr, "Consumer of channel %s saw %lu messages in %lu jobs, %lu inconsistent\n",
+		        channel_name.c_str(), messages_seen, jobs_completed, errors);
+	}
+	task_channel_close(&channel, channel_name.c_str());
+	return errors == 0 ? RT_GOMP_CHANNEL_TASK_SUCCESS : RT_GOMP_CHANNEL_TASK_VERIFY_ERROR;
+}
+
+task_t task = { init, run, finalize };
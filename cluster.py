@@ -9,22 +9,38 @@ import sys
 #outinfo: ['prog_name', period, util, worst_case, span, *priority, *firstc, *lastc]
 #(sched, corestr, outinfo) = cluster_partition(info, prognum, corenum)
 from lib_cluster import *
+import lib_cluster
 #INPUT file:
 #Input format for Python script (real-time parallel taskset file .rtpt):
 #A: system_first_core system_last_core
 #B: task_program_name task_arg1 task_arg2 task_arg3 ...
-#C: work_sec work_ns span_sec span_ns period_sec period_ns deadline_sec deadline_ns relative_release_sec relative_release_ns num_iters
+#C: work_sec work_ns span_sec span_ns period_sec period_ns deadline_sec deadline_ns relative_release_sec relative_release_ns num_iters [resource:requests:cs_sec:cs_ns ...] [memory:mb]
+#line C may end with one annotation per shared resource (see resource_lock.h) the task uses:
+#the number of requests per job and the longest critical section
+#memory:mb gives the memory traffic of a job in MB, as measured by the
+#_utilization programs, for partition_explorer to spread memory bound tasks
+#over the NUMA nodes (see partition.h); this script ignores it
+#the deadline may be shorter than the period, which needs libpartition.so for
+#the response time analysis of light tasks
 
 #OUTPUT file:
 #Output format for Python script (real-time parallel schedule file .rtps):
 #A: system_first_core system_last_core
 #B: task_program_name task_arg1 task_arg2 task_arg3 ...
 #C: work_sec work_ns span_sec span_ns period_sec period_ns deadline_sec deadline_ns relative_release_sec relative_release_ns num_iters
-#D: task_first_core task_last_core task_priority
+#D: task_first_core task_last_core task_priority [budget_sec budget_ns budget_period_sec budget_period_ns] [budget_sec:budget_ns:core:priority ...]
+#a budget on line D marks a semi-federated task (see partition.h): its thread on
+#task_last_core runs under a reservation of the budget every budget period (see
+#budget_reservation.h) and shares that core with light tasks. Colon separated
+#migrations mark a light task split over several cores by partition_explorer:
+#each job moves to core at priority once it has run for the budget (see
+#job_migration.h). This script does not split tasks.
 
 #read the input file
 #provide the prefix only to inputname
 #generate info: ['prog_name', period, util, worst_case, span]
+#rawinfo[3] holds the shared resources: {'prog_name': [[resource_name, requests, cs], ]}
+#rawinfo[4] holds the deadlines shorter than the period: {'prog_name': deadline}
 def readinput(inputname):
 	error = 0
 	#open input file
@@ -53,7 +69,7 @@ def readinput(inputname):
 	numtask = 0
 	count = 0
 	info = []
-	rawinfo = [[],[],[firstc, lastc]]
+	rawinfo = [[],[],[firstc, lastc],{},{}]
 	while i < len(infile):
 		line = re.findall(r'\S+', infile[i])
 		#line B
@@ -68,22 +84,39 @@ def readinput(inputname):
 		elif line and count == 1:
 			count = 0
 			rawinfo[1].append([name]+line)
-			if len(line) != 11:
+			if len(line) < 11:
 				print('Invalid paraneters:', infile[i])
 				error = 1
+				line += ['0']*(11-len(line))
+			#resource annotations
+			for each in line[11:]:
+				if re.match(r'^memory:\d+(\.\d*)?$', each):
+					continue
+				res = re.match(r'^(?P<res>[^:]+):(?P<requests>\d+):(?P<cs_sec>\d+):(?P<cs_ns>\d+)$', each)
+				if res:
+					cs = int(res.group('cs_sec'))*1000000000+int(res.group('cs_ns'))
+					rawinfo[3].setdefault(name, []).append([res.group('res'), int(res.group('requests')), cs])
+				else:
+					print('Invalid resource, should be resource:requests:cs_sec:cs_ns:', each)
+					error = 1
 #C: work_sec work_ns span_sec span_ns period_sec period_ns deadline_sec deadline_ns relative_release_sec relative_release_ns num_iters
 			#get work, period, span
 			work = int(line[0])*1000000000+int(line[1])
 			span = int(line[2])*1000000000+int(line[3])
 			period = int(line[4])*1000000000+int(line[5])
 			deadline = int(line[6])*1000000000+int(line[7])
-			if period != deadline:
-				print('period not equal deadline:', infile[i])
+			if deadline > period or deadline <= 0:
+				print('deadline not within period:', infile[i])
 				error = 1
+			elif deadline < period:
+				if lib_cluster.libpartition is None:
+					print('constrained deadline needs libpartition.so:', infile[i])
+					error = 1
+				rawinfo[4][name] = deadline
 			util = 1.0*work/period
 			#print(util)
-			if util >= 1.0 and 2*span > period:
-				print('critical path length too long:', span, period)
+			if util >= 1.0 and 2*span > deadline:
+				print('critical path length too long:', span, deadline)
 				error = 1
 			#info: ['prog_name', period, util, worst_case, span]
 			prog = [name, period, util, work, span]
@@ -106,6 +139,70 @@ def readinput(inputname):
 		#print(rawinfo)
 		return info, corenum, rawinfo
 
+#partition with the given balance option
+#option 3 falls back to options 4 and 2 if it cannot guarantee schedulability
+def choose_partition(info, prognum, corenum, balance):
+	if balance != 3:
+		return cluster_partition(info, prognum, corenum, balance)
+
+	info1 = copy.deepcopy(info)
+	info2 = copy.deepcopy(info)
+	(sched, corestr, outinfo) = cluster_partition(info, prognum, corenum, 3)
+	if sched != 0:
+		(sched1, corestr1, outinfo1) = cluster_partition(info1, prognum, corenum, 4)
+		if sched1 == 0 or (sched == 2 and sched1 == 1):
+		#if sched1 == 0 or (sched2 == 2 and sched1 < 2):
+			#print("!", sched1)
+			if sched == 2:
+				sched = 1
+			corestr = corestr1
+			outinfo = outinfo1
+		elif sched1 == 2:
+			(sched2, corestr2, outinfo2) = cluster_partition(info2, prognum, corenum, 2)
+			if sched2 == 0 or (sched == 2 and sched2 == 1):
+				#print("!!", sched2)
+				if sched == 2:
+					sched = 1
+				corestr = corestr2
+				outinfo = outinfo2
+				#print(sched, sched1, sched2)
+	return sched, corestr, outinfo
+
+#partition a task set that shares resources
+#the partition is tested with the blocking it causes; if the test fails, the
+#tasks are partitioned again with their work inflated by the delays of the
+#last partition, until the test passes or the delays stop changing
+	#0: Guaranteed schedulable, including blocking.
+	#1: Not guaranteed schedulable, partition available, may try.
+	#2: Not schedulable, no partition available.
+def blocking_partition(info, prognum, corenum, balance, resources):
+	inflated = copy.deepcopy(info)
+	lastdelays = None
+	for iteration in range(0, 10):
+		(sched, corestr, outinfo) = choose_partition(copy.deepcopy(inflated), prognum, corenum, balance)
+		if sched == 2 or outinfo == []:
+			return sched, corestr, outinfo
+		(schedulable, delays) = blocking_analysis(outinfo, resources, corenum)
+		if schedulable or delays == lastdelays:
+			break
+		lastdelays = delays
+		inflated = inflate_info(info, delays)
+
+	#the partition carries the inflated work, report the original one
+	original = {}
+	for prog in info:
+		original[prog[0]] = prog
+	for prog in outinfo:
+		prog[2:5] = original[prog[0]][2:5]
+
+	for name in sorted(delays):
+		(spin, blocking, response) = delays[name]
+		print('%s: spinning %d ns, local blocking %d ns, response time bound %d ns' % (name, spin, blocking, response))
+	if schedulable:
+		return 0, corestr, outinfo
+	print('Blocking on shared resources exceeds the deadlines.')
+	return 1, corestr, outinfo
+
 #partition the task set
 #info: ['prog_name', period, util, worst_case, span]
 def partition(inputname, rawinfo, info, corenum, balance):
@@ -120,31 +217,13 @@ def partition(inputname, rawinfo, info, corenum, balance):
 
 	#outinfo: ['prog_name', period, util, worst_case, span, *priority, *firstc, *lastc]
 
-	if balance != 3:
-		(sched, corestr, outinfo) = cluster_partition(info, prognum, corenum, balance)
+	#firstc and lastc are relative to the first core, the topology is not
+	lib_cluster.topology_firstcpu = rawinfo[2][0]
+	lib_cluster.deadlines = rawinfo[4]
+	if rawinfo[3]:
+		(sched, corestr, outinfo) = blocking_partition(info, prognum, corenum, balance, rawinfo[3])
 	else:
-		info1 = copy.deepcopy(info)
-		info2 = copy.deepcopy(info)
-		(sched, corestr, outinfo) = cluster_partition(info, prognum, corenum, 3)
-		if sched != 0:
-			(sched1, corestr1, outinfo1) = cluster_partition(info1, prognum, corenum, 4)
-			if sched1 == 0 or (sched == 2 and sched1 == 1):
-			#if sched1 == 0 or (sched2 == 2 and sched1 < 2):
-				#print("!", sched1)
-				if sched == 2:
-					sched = 1
-				corestr = corestr1
-				outinfo = outinfo1
-			elif sched1 == 2:
-				(sched2, corestr2, outinfo2) = cluster_partition(info2, prognum, corenum, 2)
-				if sched2 == 0 or (sched == 2 and sched2 == 1):
-					#print("!!", sched2)
-					if sched == 2:
-						sched = 1
-					corestr = corestr2
-					outinfo = outinfo2
-					#print(sched, sched1, sched2)
-
+		(sched, corestr, outinfo) = choose_partition(info, prognum, corenum, balance)
 
 	#print(sched, outinfo)
 
@@ -162,6 +241,12 @@ def partition(inputname, rawinfo, info, corenum, balance):
 	else:
 		options = 0
 		print('Guaranteed schedulable.')
+		#light tasks get optimal priorities, which may accept what rate monotonic ones would not
+		if lib_cluster.libpartition is not None:
+			lightcores = sorted(set([prog[6] for prog in outinfo if prog[6] == prog[7]]))
+			rmcores = rm_unschedulable_cores(corestr, lightcores)
+			if rmcores:
+				print('Rate monotonic priorities would miss deadlines on cores: '+' '.join([str(rawinfo[2][0]+c) for c in rmcores]))
 	p2 = open(inputname+'.rtps', 'w');
 	#if guaranteed, first line is 1
 	#if not guaranteed, first line is 0
@@ -203,8 +288,12 @@ def partition(inputname, rawinfo, info, corenum, balance):
 
 
 #./cluster.py egtaskset [balance]
+#./cluster.py egtaskset socket [topology]
 #provide only the prefix of input .rtpt file name, and it will automatically generate corresponding .rtps file
 #with balance option, it will do additional load balancing
+#with socket option, heavy task clusters are kept within the smallest cache or
+#NUMA domain that holds them, on the topology of this machine or in the given
+#topology file (see topology.h)
 	#0: Guaranteed schedulable.
 	#1: Not guaranteed schedulable, partition available, may try.
 	#2: Not schedulable, no partition available.
@@ -214,6 +303,7 @@ def run_cluster():
 	inputname = 'egtaskset'
 	inputname = sys.argv[1]
 	print(inputname)
+	print('Admission test: '+lib_cluster.admission_name())
 	(info, corenum, rawinfo) = readinput(inputname)
 	balance = 3
 	if len(sys.argv) > 2:
@@ -225,8 +315,11 @@ def run_cluster():
 			balance = 5
 		elif sys.argv[2] == 'socket':
 			balance = 6
+			if len(sys.argv) > 3:
+				lib_cluster.topology_file = sys.argv[3]
 	partition(inputname, rawinfo, info, corenum, balance)
-run_cluster()
+if __name__ == '__main__':
+	run_cluster()
 
 
 
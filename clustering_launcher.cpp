@@ -33,8 +33,11 @@ int main(int argc, char *argv[])
 	// Define the number of timing parameters to skip on the second line for each task
 	const unsigned num_skipped_timing_params = 4;
 	
-	// Define the number of partition parameters that should appear on the third line for each task
+	// Define the number of partition parameters that should appear on the third line for each task,
+	// and the optional budget parameters of a semi-federated task that may follow them. The
+	// migrations of a split task may follow as well (see job_migration.h).
 	const unsigned num_partition_params = 3;
+	const unsigned num_budget_params = 4;
 	
 	// Define the name of the barrier used for synchronizing tasks after creation
 	const std::string barrier_name = "RT_GOMP_CLUSTERING_BARRIER";
@@ -223,13 +226,40 @@ int main(int argc, char *argv[])
 				}
 			}
 			
-			// Check for extra partition parameters
-			if (task_partition_stream >> partition_param)
+			// Add the budget parameters, which are zero for tasks without a budget,
+			// and then the migrations of a split task, which contain colons, joined
+			// into one argument that is "-" for tasks that do not migrate
+			unsigned num_budget_params_read = 0;
+			std::string migrations;
+			while (task_partition_stream >> partition_param)
 			{
-				fprintf(stderr, "ERROR: Too many partition parameters were provided for task %s", program_name.c_str());
+				if (partition_param.find(':') != std::string::npos)
+				{
+					migrations += (migrations.empty() ? "" : ",") + partition_param;
+				}
+				else if (num_budget_params_read < num_budget_params && migrations.empty())
+				{
+					task_manager_argvector.push_back(partition_param);
+					num_budget_params_read += 1;
+				}
+				else
+				{
+					fprintf(stderr, "ERROR: Too many partition parameters were provided for task %s", program_name.c_str());
+					kill(0, SIGTERM);
+					return RT_GOMP_CLUSTERING_LAUNCHER_FILE_PARSE_ERROR;
+				}
+			}
+			if (num_budget_params_read != 0 && num_budget_params_read != num_budget_params)
+			{
+				fprintf(stderr, "ERROR: Incomplete budget parameters were provided for task %s", program_name.c_str());
 				kill(0, SIGTERM);
 				return RT_GOMP_CLUSTERING_LAUNCHER_FILE_PARSE_ERROR;
 			}
+			for (; num_budget_params_read < num_budget_params; ++num_budget_params_read)
+			{
+				task_manager_argvector.push_back("0");
+			}
+			task_manager_argvector.push_back(migrations.empty() ? "-" : migrations);
 			
 			// Skip the first few timing parameters that were only needed by the scheduler
 			std::string timing_param;
@@ -258,8 +288,15 @@ int main(int argc, char *argv[])
 				}
 			}
 			
-			// Check for extra timing parameters
-			if (task_timing_stream >> timing_param)
+			// Check for extra timing parameters. Resource annotations of the form
+			// resource:requests:cs_sec:cs_ns and a memory:mb annotation may follow,
+			// but only the scheduler uses them.
+			bool extra_timing_params = false;
+			while (task_timing_stream >> timing_param)
+			{
+				if (timing_param.find(':') == std::string::npos) extra_timing_params = true;
+			}
+			if (extra_timing_params)
 			{
 				fprintf(stderr, "ERROR: Too many timing parameters were provided for task %s", program_name.c_str());
 				kill(0, SIGTERM);
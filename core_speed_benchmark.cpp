@@ -0,0 +1,193 @@
+// Measures the relative speed of every online cpu for partition_explorer.
+// Usage: core_speed_benchmark [reference_cpu [num_repetitions]] > machine.topo
+// Each cpu in turn runs a fixed job pinned to it: a chain of dependent floating
+// point operations, which runs at the cpu's clock, and the matrix-vector kernel
+// of simple_task on a matrix that fits in the L2 cache, which also depends on
+// its vector units and caches. The shortest of num_repetitions runs is kept, so
+// that interrupts do not count against a cpu. A cpu's speed is the time of the
+// reference cpu divided by its own, where the reference is the cpu that task
+// timings were measured on, or by default the fastest cpu. Then all the cpus of
+// each NUMA node together run a STREAM style triad on memory of their node for
+// the node's memory bandwidth. The topology of this machine is written to
+// standard output with the speeds and bandwidths (see topology.h).
+
+#include <math.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <vector>
+#include <omp.h>
+#include "matvec.h"
+#include "timespec_functions.h"
+#include "topology.h"
+
+enum rt_gomp_core_speed_benchmark_error_codes
+{
+	RT_GOMP_CORE_SPEED_BENCHMARK_SUCCESS,
+	RT_GOMP_CORE_SPEED_BENCHMARK_ARG_PARSE_ERROR,
+	RT_GOMP_CORE_SPEED_BENCHMARK_MEM_ALLOC_ERROR,
+	RT_GOMP_CORE_SPEED_BENCHMARK_TOPOLOGY_ERROR,
+	RT_GOMP_CORE_SPEED_BENCHMARK_CORE_BIND_ERROR
+};
+
+// 256 x 256 doubles take 512 KB
+static const size_t matrix_size = 256;
+static const unsigned num_matvecs = 1000;
+static const unsigned long chain_length = 10000000;
+// Each array of the triad takes 32 MB, far more than a last level cache
+static const size_t triad_length = 4 * 1024 * 1024;
+
+// A chain of dependent multiply-adds, each waiting for the one before
+static double dependent_chain(double x)
+{
+	for (unsigned long i = 0; i < chain_length; ++i) x = x * 0.999999 + 1e-7;
+	return x;
+}
+
+// Memory bandwidth in MB/s of a triad a = b + s*c run by one thread on each of
+// the given cpus, each thread on the part of the arrays that it touched first,
+// so that its pages are on the thread's node. Returns 0 if it cannot run.
+static double triad_bandwidth(const std::vector<unsigned> & cpus, unsigned num_repetitions)
+{
+	double *a = static_cast<double *>(malloc(triad_length * sizeof(double)));
+	double *b = static_cast<double *>(malloc(triad_length * sizeof(double)));
+	double *c = static_cast<double *>(malloc(triad_length * sizeof(double)));
+	double best = HUGE_VAL;
+	bool bound = true;
+	if (a && b && c)
+	{
+		#pragma omp parallel num_threads(cpus.size()) reduction(&&:bound)
+		{
+			cpu_set_t mask;
+			CPU_ZERO(&mask);
+			CPU_SET(cpus[omp_get_thread_num()], &mask);
+			if (sched_setaffinity(0, sizeof(mask), &mask) != 0) bound = false;
+
+			#pragma omp for schedule(static)
+			for (size_t i = 0; i < triad_length; ++i)
+			{
+				a[i] = 0;
+				b[i] = 1;
+				c[i] = 2;
+			}
+			// The first run is a warm up, as for the speeds
+			timespec start, finish, runtime;
+			for (unsigned r = 0; r <= num_repetitions; ++r)
+			{
+				#pragma omp master
+				get_time(&start);
+				#pragma omp for schedule(static)
+				for (size_t i = 0; i < triad_length; ++i) a[i] = b[i] + 3.0 * c[i];
+				#pragma omp master
+				{
+					get_time(&finish);
+					ts_diff(start, finish, runtime);
+					if (r > 0) best = std::min(best, runtime.tv_sec + runtime.tv_nsec / 1e9);
+				}
+				#pragma omp barrier
+			}
+		}
+	}
+	free(a);
+	free(b);
+	free(c);
+	if (!a || !b || !c || !bound) return 0;
+	return 3 * triad_length * sizeof(double) / best / 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+	int reference_cpu = -1;
+	unsigned num_repetitions = 5;
+	if ((argc > 1 && !(std::istringstream(argv[1]) >> reference_cpu && reference_cpu >= 0)) ||
+		(argc > 2 && !(std::istringstream(argv[2]) >> num_repetitions && num_repetitions > 0)) || argc > 3)
+	{
+		fprintf(stderr, "Usage: core_speed_benchmark [reference_cpu [num_repetitions]] > machine.topo\n");
+		return RT_GOMP_CORE_SPEED_BENCHMARK_ARG_PARSE_ERROR;
+	}
+
+	topology_t topology;
+	if (read_topology(&topology) != RT_GOMP_TOPOLOGY_SUCCESS) return RT_GOMP_CORE_SPEED_BENCHMARK_TOPOLOGY_ERROR;
+	if (reference_cpu >= 0 && topology_find_cpu(&topology, reference_cpu) == NULL)
+	{
+		fprintf(stderr, "ERROR: Reference cpu %d is not online\n", reference_cpu);
+		return RT_GOMP_CORE_SPEED_BENCHMARK_ARG_PARSE_ERROR;
+	}
+
+	const size_t row_stride = matvec_row_stride(matrix_size);
+	double *matrix = matvec_alloc(matrix_size * row_stride);
+	double *vector = matvec_alloc(matrix_size);
+	double *result = matvec_alloc(matrix_size);
+	if (!matrix || !vector || !result)
+	{
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		return RT_GOMP_CORE_SPEED_BENCHMARK_MEM_ALLOC_ERROR;
+	}
+	srand48(matrix_size);
+	for (size_t i = 0; i < matrix_size * row_stride; ++i) matrix[i] = drand48() - 0.5;
+	for (size_t i = 0; i < matrix_size; ++i) vector[i] = drand48() - 0.5;
+	matvec_kernel_t kernel = matvec_get_kernel(MATVEC_KERNEL_AUTO, NULL);
+
+	std::vector<double> times(topology.cpus.size());
+	// Results are kept so that the job is not optimized away
+	volatile double sink = 0;
+	for (unsigned i = 0; i < topology.cpus.size(); ++i)
+	{
+		cpu_set_t mask;
+		CPU_ZERO(&mask);
+		CPU_SET(topology.cpus[i].cpu, &mask);
+		if (sched_setaffinity(0, sizeof(mask), &mask) != 0)
+		{
+			perror("ERROR: Could not bind to a cpu");
+			return RT_GOMP_CORE_SPEED_BENCHMARK_CORE_BIND_ERROR;
+		}
+
+		// The first run warms up the caches and the clock of the cpu
+		for (unsigned r = 0; r <= num_repetitions; ++r)
+		{
+			timespec start, finish, runtime;
+			get_time(&start);
+			sink += dependent_chain(sink);
+			for (unsigned k = 0; k < num_matvecs; ++k)
+			{
+				kernel(matrix, row_stride, vector, result, 0, matrix_size, matrix_size);
+				sink += result[k % matrix_size];
+			}
+			get_time(&finish);
+			ts_diff(start, finish, runtime);
+			const double secs = runtime.tv_sec + runtime.tv_nsec / 1e9;
+			if (r == 1 || (r > 1 && secs < times[i])) times[i] = secs;
+		}
+		fprintf(stderr, "cpu %u: %.6f secs\n", topology.cpus[i].cpu, times[i]);
+	}
+
+	double reference_time = times[0];
+	for (unsigned i = 0; i < topology.cpus.size(); ++i)
+	{
+		if (reference_cpu < 0 ? times[i] < reference_time : topology.cpus[i].cpu == static_cast<unsigned>(reference_cpu)) reference_time = times[i];
+	}
+	for (unsigned i = 0; i < topology.cpus.size(); ++i) topology.cpus[i].speed = reference_time / times[i];
+
+	std::map<int, std::vector<unsigned> > cpus_of_node;
+	for (unsigned i = 0; i < topology.cpus.size(); ++i) cpus_of_node[topology.cpus[i].node].push_back(topology.cpus[i].cpu);
+	for (std::map<int, std::vector<unsigned> >::const_iterator it = cpus_of_node.begin(); it != cpus_of_node.end(); ++it)
+	{
+		const double bandwidth = triad_bandwidth(it->second, num_repetitions);
+		if (bandwidth == 0)
+		{
+			fprintf(stderr, "ERROR: Could not measure the memory bandwidth of node %d\n", it->first);
+			return RT_GOMP_CORE_SPEED_BENCHMARK_MEM_ALLOC_ERROR;
+		}
+		topology.node_bandwidth[it->first] = bandwidth;
+		fprintf(stderr, "node %d: %.0f MB/s\n", it->first, bandwidth);
+	}
+
+	write_topology_file(stdout, &topology);
+	free(matrix);
+	free(vector);
+	free(result);
+	return RT_GOMP_CORE_SPEED_BENCHMARK_SUCCESS;
+}
@@ -0,0 +1,145 @@
+// A radix-2 complex fast Fourier transform task that uses OpenMP
+// Call the functions with the following arguments in argv: executable_name log2_size
+// Each job transforms 2^log2_size complex points out of place: a parallel bit reversal
+// followed by log2_size butterfly stages separated by barriers, with strided accesses
+// that grow with each stage. finalize compares a sample of output bins to a direct DFT.
+
+#include <omp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <complex>
+#include <sstream>
+#include <new>
+#include "task.h"
+#include "first_touch.h"
+
+typedef std::complex<double> complex_t;
+
+unsigned log2_size;
+size_t size;
+complex_t *input, *output, *twiddles;
+size_t *bit_reversed;
+unsigned jobs_completed = 0;
+
+enum rt_gomp_fft_task_error_codes
+{
+	RT_GOMP_FFT_TASK_SUCCESS,
+	RT_GOMP_FFT_TASK_INVALID_ARGUMENTS,
+	RT_GOMP_FFT_TASK_MEM_ALLOC_ERROR,
+	RT_GOMP_FFT_TASK_VERIFY_ERROR
+};
+
+int init(int argc, char *argv[])
+{
+	if (!(
+		argc == 2 &&
+		std::istringstream(argv[1]) >> log2_size && log2_size >= 1 && log2_size < 32
+	))
+	{
+		fprintf(stderr, "ERROR: Invalid initialization arguments");
+		return RT_GOMP_FFT_TASK_INVALID_ARGUMENTS;
+	}
+	size = size_t(1) << log2_size;
+
+	// Use malloc rather than new for the complex arrays because new would run the
+	// complex_t constructors and fault in every page from this thread
+	input = static_cast<complex_t *>(malloc(size * sizeof(complex_t)));
+	output = static_cast<complex_t *>(malloc(size * sizeof(complex_t)));
+	twiddles = static_cast<complex_t *>(malloc(size / 2 * sizeof(complex_t)));
+	bit_reversed = new (std::nothrow) size_t[size];
+	if (!input || !output || !twiddles || !bit_reversed)
+	{
+		fprintf(stderr, "ERROR: Memory allocation failed");
+		return RT_GOMP_FFT_TASK_MEM_ALLOC_ERROR;
+	}
+
+	first_touch(input, size, sizeof(complex_t));
+	first_touch(output, size, sizeof(complex_t));
+	first_touch(bit_reversed, size, sizeof(size_t));
+	first_touch(twiddles, size / 2, sizeof(complex_t));
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		input[i] = complex_t(sin(0.001 * i) + ((i * 7919) % 101) / 101.0, cos(0.003 * i));
+
+		size_t reversed = 0;
+		for (unsigned b = 0; b < log2_size; ++b)
+		{
+			if (i & (size_t(1) << b)) reversed |= size_t(1) << (log2_size - 1 - b);
+		}
+		bit_reversed[i] = reversed;
+	}
+	for (size_t k = 0; k < size / 2; ++k)
+	{
+		twiddles[k] = std::polar(1.0, -2.0 * M_PI * k / size);
+	}
+
+	return 0;
+}
+
+int run(int argc, char *argv[])
+{
+	#pragma omp parallel
+	{
+		size_t begin, end;
+		omp_static_range(size, 1, &begin, &end);
+		for (size_t i = begin; i < end; ++i)
+		{
+			output[i] = input[bit_reversed[i]];
+		}
+
+		// Each stage has size/2 butterflies, which are split evenly between the threads
+		for (unsigned stage = 1; stage <= log2_size; ++stage)
+		{
+			#pragma omp barrier
+			const size_t half = size_t(1) << (stage - 1);
+			const size_t twiddle_stride = size >> stage;
+			omp_static_range(size / 2, 1, &begin, &end);
+			for (size_t b = begin; b < end; ++b)
+			{
+				const size_t group = b / half;
+				const size_t k = b % half;
+				const size_t top = group * 2 * half + k;
+				const complex_t t = twiddles[k * twiddle_stride] * output[top + half];
+				output[top + half] = output[top] - t;
+				output[top] = output[top] + t;
+			}
+		}
+	}
+
+	jobs_completed += 1;
+	return 0;
+}
+
+int finalize(int argc, char *argv[])
+{
+	int ret_val = RT_GOMP_FFT_TASK_SUCCESS;
+
+	// Compare a sample of bins with a direct evaluation of the DFT
+	const unsigned num_samples = jobs_completed > 0 ? 16 : 0;
+	for (unsigned s = 0; s < num_samples; ++s)
+	{
+		const size_t bin = (s * 2654435761u) % size;
+		complex_t expected = 0;
+		for (size_t i = 0; i < size; ++i)
+		{
+			expected += input[i] * std::polar(1.0, -2.0 * M_PI * ((bin * i) % size) / size);
+		}
+		if (std::abs(output[bin] - expected) > 1e-8 * size)
+		{
+			fprintf(stderr, "ERROR: fft bin %zu = (%g, %g), expected (%g, %g)\n", bin,
+			        output[bin].real(), output[bin].imag(), expected.real(), expected.imag());
+			ret_val = RT_GOMP_FFT_TASK_VERIFY_ERROR;
+			break;
+		}
+	}
+
+	free(input);
+	free(output);
+	free(twiddles);
+	delete[] bit_reversed;
+	return ret_val;
+}
+
+task_t task = { init, run, finalize };
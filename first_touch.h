@@ -0,0 +1,130 @@
+#ifndef RT_GOMP_FIRST_TOUCH_H
+#define RT_GOMP_FIRST_TOUCH_H
+
+// Helpers for placing task data in memory close to the threads that use it.
+//
+// Linux allocates a physical page on the NUMA node of the thread that first
+// writes to it. task_manager binds OpenMP thread i to the i-th core of the
+// task's cluster before calling task.init, so if init writes each piece of data
+// from the same thread that will process it in run, the pages are faulted in
+// on the cluster's node during init and never inside the timed region.
+//
+// To get matching placement, run should divide its work with omp_static_range
+// (or an OpenMP "schedule(static)" loop over the same items) and init should
+// call first_touch with the same number of items and granularity.
+
+#include <sched.h>
+#include <errno.h>
+#include <string.h>
+#include <stddef.h>
+#include <omp.h>
+#include "numa_placement.h"
+
+// Computes the calling thread's share [*begin, *end) of num_items items when the
+// items are divided into contiguous ranges over the threads of the current
+// parallel region. Ranges are multiples of granularity items (except at the end)
+// and differ in size by at most one granule. Must be called from inside a
+// parallel region.
+inline void omp_static_range(size_t num_items, size_t granularity, size_t *begin, size_t *end)
+{
+	const size_t num_threads = omp_get_num_threads();
+	const size_t thread_num = omp_get_thread_num();
+	const size_t num_granules = (num_items + granularity - 1) / granularity;
+
+	// Spread the granules as evenly as possible, giving the remainder to the first threads
+	const size_t base = num_granules / num_threads;
+	const size_t extra = num_granules % num_threads;
+	const size_t first = thread_num * base + (thread_num < extra ? thread_num : extra);
+	const size_t count = base + (thread_num < extra ? 1 : 0);
+
+	*begin = first * granularity < num_items ? first * granularity : num_items;
+	*end = (first + count) * granularity < num_items ? (first + count) * granularity : num_items;
+}
+
+// Zero fills num_items items of item_size bytes in parallel, each thread writing
+// the range that omp_static_range assigns it for the same granularity.
+inline void first_touch(void *data, size_t num_items, size_t item_size, size_t granularity = 1)
+{
+	#pragma omp parallel
+	{
+		size_t begin, end;
+		omp_static_range(num_items, granularity, &begin, &end);
+		if (end > begin)
+		{
+			memset(static_cast<char *>(data) + begin * item_size, 0, (end - begin) * item_size);
+		}
+	}
+}
+
+// Binds OpenMP thread i of the default team to core first_core + i, wrapping
+// around the cores first_core..last_core. Returns 0, or the errno of a thread
+// that failed to bind, since errno is per thread and the caller's own is not
+// that of the failure.
+inline int bind_omp_threads(unsigned first_core, unsigned last_core)
+{
+	int error = 0;
+	const unsigned num_cores = last_core - first_core + 1;
+
+	#pragma omp parallel
+	{
+		cpu_set_t mask;
+		CPU_ZERO(&mask);
+		CPU_SET(first_core + omp_get_thread_num() % num_cores, &mask);
+
+		// A pid of zero refers to the calling thread
+		if (sched_setaffinity(0, sizeof(mask), &mask) != 0)
+		{
+			const int thread_error = errno;
+			#pragma omp critical
+			error = thread_error;
+		}
+	}
+
+	return error;
+}
+
+// Sets the memory policy of every OpenMP thread of the default team, since a
+// policy only applies to the thread that sets it and the threads that it creates
+// afterwards. Returns 0, or the errno of a thread that failed, as
+// bind_omp_threads does.
+inline int set_omp_memory_policy(int mode, const numa_node_mask_t *nodes)
+{
+	int error = 0;
+
+	#pragma omp parallel
+	{
+		if (set_numa_memory_policy(mode, nodes) != 0)
+		{
+			const int thread_error = errno;
+			#pragma omp critical
+			error = thread_error;
+		}
+	}
+
+	return error;
+}
+
+// Stores in nodes the NUMA nodes of the cores that the OpenMP threads of the
+// default team run on, which after bind_omp_threads are the nodes that
+// first_touch places data on. Returns the error of read_numa_node_of_cpus.
+inline int omp_thread_nodes(numa_node_mask_t *nodes)
+{
+	std::vector<unsigned> node_of_cpu;
+	const int ret_val = read_numa_node_of_cpus(node_of_cpu);
+	numa_node_mask_clear(nodes);
+	if (ret_val != RT_GOMP_NUMA_PLACEMENT_SUCCESS) return ret_val;
+
+	#pragma omp parallel
+	{
+		const int cpu = sched_getcpu();
+		if (cpu >= 0 && static_cast<unsigned>(cpu) < node_of_cpu.size())
+		{
+			#pragma omp critical
+			numa_node_mask_set(nodes, node_of_cpu[cpu]);
+		}
+	}
+
+	return RT_GOMP_NUMA_PLACEMENT_SUCCESS;
+}
+
+#endif /* RT_GOMP_FIRST_TOUCH_H */
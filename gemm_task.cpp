@@ -0,0 +1,135 @@
+// A dense matrix-matrix multiplication task (C = A * B) that uses OpenMP
+// Call the functions with the following arguments in argv: executable_name n [block_size]
+// All matrices are n x n. Each thread computes a contiguous range of rows of C using
+// square cache blocks of block_size (default 64). Compute bound with regular parallelism.
+// finalize checks a sample of the entries of C against a direct computation.
+
+#include <omp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <sstream>
+#include <new>
+#include "task.h"
+#include "first_touch.h"
+
+size_t n, block_size = 64;
+double *A, *B, *C;
+unsigned jobs_completed = 0;
+
+enum rt_gomp_gemm_task_error_codes
+{
+	RT_GOMP_GEMM_TASK_SUCCESS,
+	RT_GOMP_GEMM_TASK_INVALID_ARGUMENTS,
+	RT_GOMP_GEMM_TASK_MEM_ALLOC_ERROR,
+	RT_GOMP_GEMM_TASK_VERIFY_ERROR
+};
+
+int init(int argc, char *argv[])
+{
+	if (!(
+		(argc == 2 || argc == 3) &&
+		std::istringstream(argv[1]) >> n && n > 0 &&
+		(argc == 2 || (std::istringstream(argv[2]) >> block_size && block_size > 0))
+	))
+	{
+		fprintf(stderr, "ERROR: Invalid initialization arguments");
+		return RT_GOMP_GEMM_TASK_INVALID_ARGUMENTS;
+	}
+
+	A = new (std::nothrow) double[n*n];
+	B = new (std::nothrow) double[n*n];
+	C = new (std::nothrow) double[n*n];
+	if (!A || !B || !C)
+	{
+		fprintf(stderr, "ERROR: Memory allocation failed");
+		return RT_GOMP_GEMM_TASK_MEM_ALLOC_ERROR;
+	}
+
+	// A and C are split by rows as in run; every thread reads all of B
+	first_touch(A, n, n*sizeof(double), block_size);
+	first_touch(C, n, n*sizeof(double), block_size);
+	first_touch(B, n*n, sizeof(double));
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		for (size_t j = 0; j < n; ++j)
+		{
+			A[i*n + j] = ((i * 7 + j * 3) % 17) / 17.0 - 0.5;
+			B[i*n + j] = ((i * 5 + j * 11) % 13) / 13.0 - 0.5;
+		}
+	}
+
+	return 0;
+}
+
+int run(int argc, char *argv[])
+{
+	#pragma omp parallel
+	{
+		size_t row_begin, row_end;
+		omp_static_range(n, block_size, &row_begin, &row_end);
+
+		for (size_t i = row_begin; i < row_end; ++i)
+		{
+			for (size_t j = 0; j < n; ++j) C[i*n + j] = 0;
+		}
+
+		for (size_t ii = row_begin; ii < row_end; ii += block_size)
+		{
+			const size_t i_end = ii + block_size < row_end ? ii + block_size : row_end;
+			for (size_t kk = 0; kk < n; kk += block_size)
+			{
+				const size_t k_end = kk + block_size < n ? kk + block_size : n;
+				for (size_t jj = 0; jj < n; jj += block_size)
+				{
+					const size_t j_end = jj + block_size < n ? jj + block_size : n;
+					for (size_t i = ii; i < i_end; ++i)
+					{
+						double *c_row = C + i*n;
+						for (size_t k = kk; k < k_end; ++k)
+						{
+							const double a = A[i*n + k];
+							const double *b_row = B + k*n;
+							for (size_t j = jj; j < j_end; ++j)
+							{
+								c_row[j] += a * b_row[j];
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	jobs_completed += 1;
+	return 0;
+}
+
+int finalize(int argc, char *argv[])
+{
+	int ret_val = RT_GOMP_GEMM_TASK_SUCCESS;
+
+	// Check a deterministic sample of entries, including the corners
+	const unsigned num_samples = jobs_completed > 0 ? 64 : 0;
+	for (unsigned s = 0; s < num_samples; ++s)
+	{
+		const size_t i = (s == 0) ? 0 : (s == 1) ? n - 1 : (s * 2654435761u) % n;
+		const size_t j = (s == 0) ? 0 : (s == 1) ? n - 1 : (s * 40503u + 17) % n;
+		double expected = 0;
+		for (size_t k = 0; k < n; ++k) expected += A[i*n + k] * B[k*n + j];
+		if (fabs(C[i*n + j] - expected) > 1e-9 * (1.0 + fabs(expected)) * n)
+		{
+			fprintf(stderr, "ERROR: gemm result C[%zu][%zu] = %g, expected %g\n", i, j, C[i*n + j], expected);
+			ret_val = RT_GOMP_GEMM_TASK_VERIFY_ERROR;
+			break;
+		}
+	}
+
+	delete[] A;
+	delete[] B;
+	delete[] C;
+	return ret_val;
+}
+
+task_t task = { init, run, finalize };
@@ -0,0 +1,236 @@
+#include "job_counters.h"
+#include "timespec_functions.h"
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <omp.h>
+
+// Jobs that missed their deadlines beyond this many are only counted
+static const size_t max_missed_jobs_reported = 16;
+
+typedef struct
+{
+	__u32 type;
+	__u64 config;
+}
+event_spec_t;
+
+static const event_spec_t event_specs[NUM_JOB_COUNTERS] =
+{
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+	{ PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+	{ PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS },
+	{ PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS }
+};
+
+// The layout of a group read with PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING
+typedef struct
+{
+	__u64 nr;
+	__u64 time_enabled;
+	__u64 time_running;
+	__u64 values[NUM_JOB_COUNTERS];
+}
+group_read_t;
+
+static int open_event(job_counter counter, pid_t tid, int group_fd, bool exclude_kernel)
+{
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = event_specs[counter].type;
+	attr.config = event_specs[counter].config;
+	attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	attr.exclude_kernel = exclude_kernel;
+	attr.exclude_hv = 1;
+	return syscall(SYS_perf_event_open, &attr, tid, -1, group_fd, 0);
+}
+
+// Opens the group of one thread. The first thread decides which counters are
+// available; the others must be able to open the same ones.
+static int open_group(job_counters_t *counters, pid_t tid, bool first_thread, bool exclude_kernel)
+{
+	int leader = -1;
+	for (int c = 0; c < NUM_JOB_COUNTERS; ++c)
+	{
+		if (!first_thread && !counters->available[c]) continue;
+
+		const int fd = open_event(static_cast<job_counter>(c), tid, leader, exclude_kernel);
+		if (fd == -1)
+		{
+			if (first_thread) continue;
+			return RT_GOMP_JOB_COUNTERS_OPEN_FAILED_ERROR;
+		}
+
+		if (first_thread)
+		{
+			counters->available[c] = true;
+			counters->num_available += 1;
+		}
+		if (leader == -1) leader = fd;
+		counters->fds.push_back(fd);
+	}
+
+	if (leader == -1) return RT_GOMP_JOB_COUNTERS_UNAVAILABLE_ERROR;
+	counters->leaders.push_back(leader);
+	return RT_GOMP_JOB_COUNTERS_SUCCESS;
+}
+
+int job_counters_open(job_counters_t *counters)
+{
+	counters->leaders.clear();
+	counters->fds.clear();
+	counters->num_available = 0;
+	for (int c = 0; c < NUM_JOB_COUNTERS; ++c) counters->available[c] = false;
+
+	std::vector<pid_t> tids(omp_get_max_threads());
+	#pragma omp parallel
+	{
+		tids[omp_get_thread_num()] = syscall(SYS_gettid);
+	}
+
+	// Kernel activity such as context switches and page faults is only counted
+	// with enough privileges. Otherwise fall back to counting user space.
+	bool exclude_kernel = false;
+	int ret_val = open_group(counters, tids[0], true, exclude_kernel);
+	if (ret_val != 0)
+	{
+		exclude_kernel = true;
+		ret_val = open_group(counters, tids[0], true, exclude_kernel);
+	}
+
+	for (size_t t = 1; t < tids.size() && ret_val == 0; ++t)
+	{
+		ret_val = open_group(counters, tids[t], false, exclude_kernel);
+	}
+
+	if (ret_val != 0) job_counters_close(counters);
+	return ret_val;
+}
+
+void job_counters_close(job_counters_t *counters)
+{
+	for (size_t i = 0; i < counters->fds.size(); ++i)
+	{
+		close(counters->fds[i]);
+	}
+	counters->fds.clear();
+	counters->leaders.clear();
+}
+
+void job_counters_read(const job_counters_t *counters, job_counts_t *counts)
+{
+	memset(counts, 0, sizeof(*counts));
+
+	for (size_t t = 0; t < counters->leaders.size(); ++t)
+	{
+		group_read_t group;
+		if (read(counters->leaders[t], &group, sizeof(group)) <= 0) continue;
+
+		// Scale the counts up if the PMU had to multiplex the group
+		const double scale = (group.time_running > 0 && group.time_running < group.time_enabled) ?
+		                     (double) group.time_enabled / group.time_running : 1.0;
+
+		unsigned v = 0;
+		for (int c = 0; c < NUM_JOB_COUNTERS && v < group.nr; ++c)
+		{
+			if (!counters->available[c]) continue;
+			counts->values[c] += scale == 1.0 ? group.values[v] : (unsigned long long) (group.values[v] * scale);
+			v += 1;
+		}
+	}
+}
+
+const char *job_counter_name(job_counter counter)
+{
+	switch (counter)
+	{
+		case JOB_COUNTER_CYCLES: return "cycles";
+		case JOB_COUNTER_INSTRUCTIONS: return "instructions";
+		case JOB_COUNTER_LLC_MISSES: return "LLC misses";
+		case JOB_COUNTER_CONTEXT_SWITCHES: return "context switches";
+		case JOB_COUNTER_MIGRATIONS: return "migrations";
+		case JOB_COUNTER_PAGE_FAULTS: return "page faults";
+		default: return "unknown";
+	}
+}
+
+void job_counter_stats_init(job_counter_stats_t *stats)
+{
+	stats->num_jobs = 0;
+	memset(stats->total, 0, sizeof(stats->total));
+	memset(stats->max, 0, sizeof(stats->max));
+	stats->longest_job = 0;
+	stats->longest_runtime.tv_sec = 0;
+	stats->longest_runtime.tv_nsec = 0;
+	memset(&stats->longest_counts, 0, sizeof(stats->longest_counts));
+	stats->missed_jobs.clear();
+	stats->missed_runtimes.clear();
+	stats->missed_counts.clear();
+}
+
+void job_counter_stats_add(job_counter_stats_t *stats, const job_counts_t *before, const job_counts_t *after,
+                           const timespec & runtime, bool missed_deadline)
+{
+	job_counts_t job;
+	for (int c = 0; c < NUM_JOB_COUNTERS; ++c)
+	{
+		job.values[c] = after->values[c] - before->values[c];
+		stats->total[c] += job.values[c];
+		if (job.values[c] > stats->max[c]) stats->max[c] = job.values[c];
+	}
+
+	if (runtime > stats->longest_runtime)
+	{
+		stats->longest_job = stats->num_jobs;
+		stats->longest_runtime = runtime;
+		stats->longest_counts = job;
+	}
+
+	if (missed_deadline && stats->missed_jobs.size() < max_missed_jobs_reported)
+	{
+		stats->missed_jobs.push_back(stats->num_jobs);
+		stats->missed_runtimes.push_back(runtime);
+		stats->missed_counts.push_back(job);
+	}
+
+	stats->num_jobs += 1;
+}
+
+// Prints the available counts of one job
+static void print_counts(const job_counters_t *counters, const job_counts_t *counts)
+{
+	for (int c = 0; c < NUM_JOB_COUNTERS; ++c)
+	{
+		if (counters->available[c]) std::cerr << ", " << job_counter_name(static_cast<job_counter>(c)) << " " << counts->values[c];
+	}
+	std::cerr << std::endl;
+}
+
+void report_job_counters(const char *task_name, const job_counters_t *counters, const job_counter_stats_t *stats)
+{
+	if (stats->num_jobs == 0) return;
+
+	for (int c = 0; c < NUM_JOB_COUNTERS; ++c)
+	{
+		if (!counters->available[c]) continue;
+		std::cerr << "Job " << job_counter_name(static_cast<job_counter>(c)) << " for task " << task_name
+		          << ": mean " << stats->total[c] / stats->num_jobs << ", max " << stats->max[c] << std::endl;
+	}
+
+	std::cerr << "Longest job of task " << task_name << ": job " << stats->longest_job << ", "
+	          << stats->longest_runtime << " secs";
+	print_counts(counters, &stats->longest_counts);
+
+	for (size_t i = 0; i < stats->missed_jobs.size(); ++i)
+	{
+		std::cerr << "Deadline miss of task " << task_name << ": job " << stats->missed_jobs[i] << ", "
+		          << stats->missed_runtimes[i] << " secs";
+		print_counts(counters, &stats->missed_counts[i]);
+	}
+}
@@ -0,0 +1,89 @@
+#ifndef RT_GOMP_JOB_COUNTERS_H
+#define RT_GOMP_JOB_COUNTERS_H
+
+#include <time.h>
+#include <vector>
+
+// Per-job performance counters, so that an overrun can be traced to its cause.
+//
+// A group of perf events is opened for each OpenMP thread of the task: cycles,
+// instructions and last level cache misses from the PMU, and context switches,
+// CPU migrations and page faults from the kernel. Events that cannot be opened
+// are left out, so on machines or virtual machines without hardware counters
+// only the software events are counted. task_manager reads each group with a
+// single read before and after every call to task.run and sums the differences
+// over the threads.
+
+enum rt_gomp_job_counters_error_codes
+{
+	RT_GOMP_JOB_COUNTERS_SUCCESS,
+	RT_GOMP_JOB_COUNTERS_UNAVAILABLE_ERROR,
+	RT_GOMP_JOB_COUNTERS_OPEN_FAILED_ERROR
+};
+
+enum job_counter
+{
+	JOB_COUNTER_CYCLES,
+	JOB_COUNTER_INSTRUCTIONS,
+	JOB_COUNTER_LLC_MISSES,
+	JOB_COUNTER_CONTEXT_SWITCHES,
+	JOB_COUNTER_MIGRATIONS,
+	JOB_COUNTER_PAGE_FAULTS,
+	NUM_JOB_COUNTERS
+};
+
+typedef struct
+{
+	unsigned long long values[NUM_JOB_COUNTERS];
+}
+job_counts_t;
+
+typedef struct
+{
+	// The group leader of each thread; the other events are read through it
+	std::vector<int> leaders;
+	std::vector<int> fds;
+	bool available[NUM_JOB_COUNTERS];
+	unsigned num_available;
+}
+job_counters_t;
+
+// Opens a counter group for each thread of the default OpenMP team. Must be
+// called by the initial thread, outside of any parallel region.
+int job_counters_open(job_counters_t *counters);
+void job_counters_close(job_counters_t *counters);
+
+// Reads the counts of all threads, summed. Counters that are not available read as zero.
+void job_counters_read(const job_counters_t *counters, job_counts_t *counts);
+
+const char *job_counter_name(job_counter counter);
+
+// Per-job statistics of the counters, with the counts of the jobs that missed
+// their deadlines kept for the report
+typedef struct
+{
+	unsigned long num_jobs;
+	unsigned long long total[NUM_JOB_COUNTERS];
+	unsigned long long max[NUM_JOB_COUNTERS];
+	// The job with the longest running time
+	unsigned long longest_job;
+	timespec longest_runtime;
+	job_counts_t longest_counts;
+	// The first jobs that missed their deadlines
+	std::vector<unsigned long> missed_jobs;
+	std::vector<timespec> missed_runtimes;
+	std::vector<job_counts_t> missed_counts;
+}
+job_counter_stats_t;
+
+void job_counter_stats_init(job_counter_stats_t *stats);
+
+// Adds the counts between before and after for a job with the given running time
+void job_counter_stats_add(job_counter_stats_t *stats, const job_counts_t *before, const job_counts_t *after,
+                           const timespec & runtime, bool missed_deadline);
+
+// Prints the mean and maximum per job, the counts of the longest job and of the
+// jobs that missed their deadlines, for the end of run report of a task
+void report_job_counters(const char *task_name, const job_counters_t *counters, const job_counter_stats_t *stats);
+
+#endif /* RT_GOMP_JOB_COUNTERS_H */
@@ -0,0 +1,146 @@
+#include "job_migration.h"
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <omp.h>
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+// The signal of the budget timer
+static const int migration_signal = SIGRTMIN;
+
+// Where the task runs in each part, the first part at index 0, with the
+// affinity masks built in advance so that the signal handler only makes
+// system calls
+static std::vector<cpu_set_t> part_masks;
+static std::vector<int> part_priorities;
+static std::vector<timespec> part_budgets;
+static std::vector<pid_t> thread_ids;
+static timer_t budget_timer;
+// Only changed by the main thread, which is the one that handles the signal
+static volatile sig_atomic_t current_part = 0;
+static volatile sig_atomic_t job_active = 0;
+
+// Moves every thread of the task to the core and priority of a part
+static void move_to_part(unsigned part)
+{
+	sched_param sp;
+	sp.sched_priority = part_priorities[part];
+	for (unsigned t = 0; t < thread_ids.size(); ++t)
+	{
+		sched_setscheduler(thread_ids[t], SCHED_FIFO, &sp);
+		sched_setaffinity(thread_ids[t], sizeof(cpu_set_t), &part_masks[part]);
+	}
+}
+
+static void arm_budget(unsigned part)
+{
+	itimerspec value = {};
+	if (part < part_budgets.size()) value.it_value = part_budgets[part];
+	timer_settime(budget_timer, 0, &value, NULL);
+}
+
+// The budget of the current part is used up: move on to the next one
+static void budget_handler(int)
+{
+	if (!job_active || current_part + 1 >= static_cast<sig_atomic_t>(part_masks.size())) return;
+	current_part = current_part + 1;
+	move_to_part(current_part);
+	arm_budget(current_part);
+}
+
+int parse_job_migrations(const char *text, std::vector<job_migration_t> & migrations)
+{
+	migrations.clear();
+	std::string rest(text);
+	if (rest == "-") return RT_GOMP_JOB_MIGRATION_SUCCESS;
+
+	while (!rest.empty())
+	{
+		const size_t end = rest.find(',');
+		const std::string token = rest.substr(0, end);
+		long long budget_sec, budget_ns;
+		job_migration_t migration;
+		char trailing;
+		if (sscanf(token.c_str(), "%lld:%lld:%u:%d%c", &budget_sec, &budget_ns, &migration.core, &migration.priority, &trailing) != 4 ||
+			budget_sec < 0 || budget_ns < 0 || budget_ns >= 1000000000)
+		{
+			fprintf(stderr, "ERROR: Invalid migration %s, should be budget_sec:budget_ns:core:priority\n", token.c_str());
+			return RT_GOMP_JOB_MIGRATION_PARSE_ERROR;
+		}
+		migration.budget.tv_sec = budget_sec;
+		migration.budget.tv_nsec = budget_ns;
+		migrations.push_back(migration);
+		rest = end == std::string::npos ? "" : rest.substr(end + 1);
+	}
+	return RT_GOMP_JOB_MIGRATION_SUCCESS;
+}
+
+int job_migration_init(unsigned first_core, int first_priority, const std::vector<job_migration_t> & migrations)
+{
+	if (migrations.empty()) return RT_GOMP_JOB_MIGRATION_SUCCESS;
+
+	part_masks.assign(migrations.size() + 1, cpu_set_t());
+	part_priorities.assign(1, first_priority);
+	part_budgets.clear();
+	for (unsigned k = 0; k <= migrations.size(); ++k)
+	{
+		CPU_ZERO(&part_masks[k]);
+		CPU_SET(k == 0 ? first_core : migrations[k - 1].core, &part_masks[k]);
+		if (k == 0) continue;
+		part_priorities.push_back(migrations[k - 1].priority);
+		part_budgets.push_back(migrations[k - 1].budget);
+	}
+
+	thread_ids.assign(omp_get_max_threads(), 0);
+	#pragma omp parallel
+	{
+		thread_ids[omp_get_thread_num()] = syscall(SYS_gettid);
+	}
+
+	struct sigaction action = {};
+	action.sa_handler = budget_handler;
+	action.sa_flags = SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	if (sigaction(migration_signal, &action, NULL) != 0)
+	{
+		return RT_GOMP_JOB_MIGRATION_TIMER_ERROR;
+	}
+
+	// The signal goes to the main thread, so the handler never runs at the
+	// same time as job_migration_end
+	sigevent event = {};
+	event.sigev_notify = SIGEV_THREAD_ID;
+	event.sigev_signo = migration_signal;
+	event.sigev_notify_thread_id = syscall(SYS_gettid);
+	if (timer_create(CLOCK_PROCESS_CPUTIME_ID, &event, &budget_timer) != 0)
+	{
+		return RT_GOMP_JOB_MIGRATION_TIMER_ERROR;
+	}
+	return RT_GOMP_JOB_MIGRATION_SUCCESS;
+}
+
+void job_migration_start()
+{
+	if (part_masks.empty()) return;
+	current_part = 0;
+	job_active = 1;
+	arm_budget(0);
+}
+
+unsigned job_migration_end()
+{
+	if (part_masks.empty()) return 0;
+	job_active = 0;
+	arm_budget(part_budgets.size());
+	const unsigned moves = current_part;
+	if (moves > 0) move_to_part(0);
+	current_part = 0;
+	return moves;
+}
@@ -0,0 +1,57 @@
+#ifndef RT_GOMP_JOB_MIGRATION_H
+#define RT_GOMP_JOB_MIGRATION_H
+
+#include <time.h>
+#include <vector>
+
+// Migration of the jobs of split light tasks (see partition.h). A split task
+// starts each job on its first core at its first priority. Once the job has
+// used the budget of a part, it moves with all of its threads to the core of
+// the next part and takes that part's priority, and at the end of the job it
+// moves back. Budgets are measured in the CPU time of the process with a
+// CLOCK_PROCESS_CPUTIME_ID timer, whose signal handler does the move and arms
+// the timer for the next part, so the job does not have to check for it.
+//
+// The parts before the last run at the top priority of their cores, so they
+// end exactly a budget after they start, as the analysis assumes. A split task
+// runs on one core at a time, so the CPU time of the process is that of the
+// current part.
+//
+// In a schedule (.rtps) file the migrations follow the partition parameters of
+// the task as budget_sec:budget_ns:core:priority tokens, one per move, and are
+// passed to task_manager joined by commas, or as "-" if there are none.
+
+enum rt_gomp_job_migration_error_codes
+{
+	RT_GOMP_JOB_MIGRATION_SUCCESS,
+	RT_GOMP_JOB_MIGRATION_PARSE_ERROR,
+	RT_GOMP_JOB_MIGRATION_TIMER_ERROR
+};
+
+typedef struct
+{
+	// CPU time of the job on the previous core before it moves
+	timespec budget;
+	unsigned core;
+	int priority;
+}
+job_migration_t;
+
+// Parses the migrations argument of task_manager
+int parse_job_migrations(const char *text, std::vector<job_migration_t> & migrations);
+
+// Prepares the migrations of the jobs of a task on first_core at first_priority
+// and the threads of its OpenMP team. Without migrations nothing is done.
+int job_migration_init(unsigned first_core, int first_priority, const std::vector<job_migration_t> & migrations);
+
+// Arms the budget of the first part at the start of a job. The budgets are
+// parts of the task's work as utilization_calculator measures it, which
+// includes sampling its channels and reading its counters around run, so
+// task_manager calls this before those and job_migration_end after them.
+void job_migration_start();
+
+// Disarms the timer at the end of a job and moves the task back to its first
+// core and priority if it moved. Returns the number of moves during the job.
+unsigned job_migration_end();
+
+#endif /* RT_GOMP_JOB_MIGRATION_H */
@@ -4,6 +4,55 @@ import string
 import math
 import copy
 import re
+import os
+import ctypes
+
+#exact response time analysis for light task admission (see rta.h) and
+#topology-driven cluster placement (see topology.h)
+#libpartition.so is built by make; without it the utilization bound is used
+#and clusters are placed one after the other
+try:
+	libpartition = ctypes.CDLL(os.path.join(os.path.dirname(os.path.abspath(__file__)), 'libpartition.so'))
+	libpartition.rta_core_create.restype = ctypes.c_void_p
+	libpartition.rta_core_destroy.argtypes = [ctypes.c_void_p]
+	libpartition.rta_core_try_add.argtypes = [ctypes.c_void_p, ctypes.c_int64, ctypes.c_int64, ctypes.c_int64, ctypes.c_int]
+	libpartition.rta_core_force_add.argtypes = [ctypes.c_void_p, ctypes.c_int64, ctypes.c_int64, ctypes.c_int64, ctypes.c_int]
+	libpartition.rta_core_schedulable.argtypes = [ctypes.c_void_p]
+	libpartition.rta_core_assign_priorities.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_uint)]
+	libpartition.topology_place.argtypes = [ctypes.c_char_p, ctypes.c_uint, ctypes.c_uint, ctypes.POINTER(ctypes.c_uint), ctypes.c_uint, ctypes.POINTER(ctypes.c_uint)]
+except OSError:
+	libpartition = None
+
+#admission test of original() for a light task joining a non-empty core
+#'rta': exact response time analysis, 'bound': np(rp^(1/np)-1)+2/rp-1
+#'rta' is only the default with libpartition.so; setting it without the library
+#makes cluster_partition fail rather than fall back to the bound
+admission = 'rta' if libpartition else 'bound'
+
+#the admission test in use, for the scripts to print with their result
+def admission_name():
+	if admission == 'rta':
+		return 'response time analysis'
+	if libpartition is None:
+		return 'utilization bound (libpartition.so not found, run make for response time analysis)'
+	return 'utilization bound'
+
+#topology for option 6, which puts each heavy cluster in the smallest cache or
+#NUMA domain that holds it
+#topology_file: cpu socket node llc core lines (see topology.h), None for /sys
+#topology_firstcpu: the cpu that is core 0 of the partition
+topology_file = None
+topology_firstcpu = 0
+
+#deadlines shorter than the period: {'prog_name': deadline}
+#heavy tasks get (C-L)/(D-L) cores and light tasks deadline monotonic
+#priorities, and light cores are checked by response time analysis, since the
+#utilization bound assumes deadlines equal to periods
+deadlines = {}
+
+#relative deadline of a prog: ['prog_name', period, ...]
+def deadline(prog):
+	return deadlines.get(prog[0], prog[1])
 
 #sort according to segments' prog_name, sub_id
 '''
@@ -49,6 +98,10 @@ def sortperiod(e1, e2):
 def sortperiod(e1):
 	return e1[1]
 
+#sort according to progs' deadline (low to high)
+def sortdeadline(e1):
+	return deadline(e1)
+
 #sort according to progs' releasetime (low to high)
 '''
 def sortrelease(e1, e2):
@@ -76,15 +129,27 @@ def sortposs(e1, e2):
 def sortposs(e1):
 	return -1*e1[1]
 
-#for 36#
-#sorthigh for highinfo
-'''
-def sorthigh(e1, e2):
-	return -1*cmp(e1[0], e2[0])
-'''
-def sorthigh(e1):
-	return -1*e1[0]
 
+#response time analysis state of each core used by original()
+class RTACore:
+	def __init__(self):
+		self.core = libpartition.rta_core_create()
+	def __del__(self):
+		libpartition.rta_core_destroy(self.core)
+	#prog: ['prog_name', period, util, worst_case, span, ...]
+	def try_add(self, prog, priority):
+		return libpartition.rta_core_try_add(self.core, int(prog[3]), int(prog[1]), int(deadline(prog)), priority) == 1
+	def force_add(self, prog, priority):
+		libpartition.rta_core_force_add(self.core, int(prog[3]), int(prog[1]), int(deadline(prog)), priority)
+	def schedulable(self):
+		return libpartition.rta_core_schedulable(self.core) == 1
+	#Audsley's optimal priority assignment over num tasks (see rta.h)
+	#returns the former position of the task at each position, or None
+	def assign_priorities(self, num):
+		order = (ctypes.c_uint * num)()
+		if libpartition.rta_core_assign_priorities(self.core, order) == 0:
+			return None
+		return list(order)
 
 #partition low util tasks
 #original or threshold
@@ -95,6 +160,11 @@ def original(lowcore, lowinfo, posscore, highid, corestat, corestr, outinfo, thr
 	sched = 0
 	lowcorenum = len(lowcore)
 	curcore = 0
+	#tasks are added in deadline order, so 98-np is a deadline monotonic priority
+	rtacores = {}
+	if admission == 'rta':
+		for core in lowcore+posscore:
+			rtacores[core] = RTACore()
 
 	for i in range(0, len(lowinfo)):
 		#info: ['prog_name', period, util, worst_case, span]
@@ -115,6 +185,8 @@ def original(lowcore, lowinfo, posscore, highid, corestat, corestr, outinfo, thr
 				newprog = lowinfo[i][0:-1]+[98-corestat[lowcore[curcore]][0], lowcore[curcore], lowcore[curcore]]
 				outinfo.append(newprog)
 				corestr[lowcore[curcore]].append(newprog)
+				if rtacores:
+					rtacores[lowcore[curcore]].force_add(newprog, newprog[-3])
 				break
 			else:
 				#bound = np(rp^(1/np)-1)+2/rp-1
@@ -122,8 +194,12 @@ def original(lowcore, lowinfo, posscore, highid, corestat, corestr, outinfo, thr
 				np = corestat[lowcore[curcore]][0]+1.0
 				rp = 1.0*period/corestat[lowcore[curcore]][2]
 				sumutil = corestat[lowcore[curcore]][1] + util
-				bound = np*(math.pow(rp,(1/np))-1)+2/rp-1
-				if sumutil < thr and sumutil <= bound:
+				if rtacores:
+					admitted = sumutil < thr and rtacores[lowcore[curcore]].try_add(lowinfo[i], 98-int(np))
+				else:
+					bound = np*(math.pow(rp,(1/np))-1)+2/rp-1
+					admitted = sumutil < thr and sumutil <= bound
+				if admitted:
 					corestat[lowcore[curcore]][0] += 1
 					corestat[lowcore[curcore]][1] += util
 					newprog = lowinfo[i][0:-1]+[98-corestat[lowcore[curcore]][0], lowcore[curcore], lowcore[curcore]]
@@ -158,6 +234,8 @@ def original(lowcore, lowinfo, posscore, highid, corestat, corestr, outinfo, thr
 					newprog = lowinfo[i][0:-1]+[98-corestat[addcore][0], addcore, addcore]
 					outinfo.append(newprog)
 					corestr[addcore].append(newprog)
+					if rtacores:
+						rtacores[addcore].force_add(newprog, newprog[-3])
 					outinfo[progid][-1] = addcore - 1
 					corestr[outinfo[progid][-2]][0][-1] = addcore - 1
 					#print("try.............")
@@ -175,6 +253,8 @@ def original(lowcore, lowinfo, posscore, highid, corestat, corestr, outinfo, thr
 				newprog = lowinfo[i][0:-1]+[98-corestat[lowcore[mincore]][0], lowcore[mincore], lowcore[mincore]]
 				outinfo.append(newprog)
 				corestr[lowcore[mincore]].append(newprog)
+				if rtacores:
+					rtacores[lowcore[mincore]].force_add(newprog, newprog[-3])
 	#print("\t",outinfo)
 	#if sched == 1:
 		#print("!!!!!!!!!!original\t"#, corestr, partedcore, lowcore, corestat)
@@ -424,7 +504,7 @@ def loadbalance(lowcore, info, posscore, highid, corestat, corestr, outinfo):
 					#	print(each, coremin, availablestr#"!!")
 					#	change = 10
 					availablestr[coremin].append(newprog)
-					availablestr[coremin].sort(key=sortperiod)
+					availablestr[coremin].sort(key=sortdeadline)
 					oldprog = each
 					flag = 1
 					change = 1
@@ -445,7 +525,7 @@ def loadbalance(lowcore, info, posscore, highid, corestat, corestr, outinfo):
 	# print('\t', availablestr, available)
 	for core in available:
 		if availablestr[core] != []:
-			availablestr[core].sort(key=sortperiod)
+			availablestr[core].sort(key=sortdeadline)
 			for i in range(0, len(availablestr[core])):
 				newprog = availablestr[core][i][0:-1]+[97-i, core, core]
 				outinfo.append(newprog)
@@ -455,6 +535,79 @@ def loadbalance(lowcore, info, posscore, highid, corestat, corestr, outinfo):
 	return change
 
 
+#whether the light tasks on each of cores meet their deadlines by response
+#time analysis with the priorities they were given
+def rta_schedulable(corestr, cores):
+	for core in cores:
+		rtacore = RTACore()
+		for prog in corestr[core]:
+			rtacore.force_add(prog, prog[5])
+		if not rtacore.schedulable():
+			return False
+	return True
+
+
+#give the light tasks on each of cores optimal priorities by response time
+#analysis (see rta_core_assign_priorities in rta.h), reusing the priorities the
+#core has; the deadline monotonic order they were admitted in is kept wherever
+#it meets every deadline
+def assign_priorities(corestr, cores):
+	for core in cores:
+		progs = sorted(corestr[core], key=sortpriority)
+		rtacore = RTACore()
+		for prog in progs:
+			rtacore.force_add(prog, prog[5])
+		if rtacore.schedulable():
+			continue
+		order = rtacore.assign_priorities(len(progs))
+		if order is None:
+			continue
+		priorities = [prog[5] for prog in progs]
+		for k in range(0, len(order)):
+			progs[order[k]][5] = priorities[k]
+
+#cores whose light tasks would miss deadlines with rate monotonic priorities
+def rm_unschedulable_cores(corestr, cores):
+	unschedulable = []
+	for core in cores:
+		rtacore = RTACore()
+		progs = sorted(corestr[core], key=sortperiod)
+		for k in range(0, len(progs)):
+			rtacore.force_add(progs[k], -k)
+		if not rtacore.schedulable():
+			unschedulable.append(core)
+	return unschedulable
+
+
+#move the heavy clusters in outinfo into the smallest cache or NUMA domains
+#that hold them (see topology_place in topology.h), updating corestr and the
+#last cores in possible
+#returns the cores left for light tasks in ascending order, or None if the
+#clusters stay one after the other
+def place_clusters(outinfo, corestr, possible, corenum):
+	if libpartition is None or len(outinfo) == 0:
+		return None
+	num = len(outinfo)
+	sizes = (ctypes.c_uint * num)(*[prog[7]-prog[6]+1 for prog in outinfo])
+	firstcores = (ctypes.c_uint * num)()
+	filename = topology_file.encode() if topology_file else None
+	if libpartition.topology_place(filename, topology_firstcpu, corenum, sizes, num, firstcores) == 0:
+		return None
+	used = [False]*corenum
+	for i in range(0, num):
+		prog = outinfo[i]
+		corestr[prog[6]].remove(prog)
+		prog[7] += firstcores[i]-prog[6]
+		prog[6] = firstcores[i]
+		corestr[prog[6]].append(prog)
+		for c in range(prog[6], prog[7]+1):
+			used[c] = True
+	#possible: [[posscoreid, remaining_util, highid], ], highid indexes outinfo
+	for each in possible:
+		each[0] = outinfo[each[2]][7]
+	return [c for c in range(0, corenum) if not used[c]]
+
+
 #clustered scheduling
 #assign core to each task
 #info: ['prog_name', period, util, worst_case, span]
@@ -467,13 +620,15 @@ def loadbalance(lowcore, info, posscore, highid, corestat, corestr, outinfo):
 #4. original + load balancing + 0.95 threshold
 ####5. original + load balancing + 0.90 threshold + 0.95 threshold + ori
 #5. original + 0.90 threshold
-#6. for 36 (corenum = 36) + load balancing + 0.90 threshold
+#6. clusters placed by topology (see place_clusters) + load balancing + 0.90 threshold
 #7. 0.95 + overhead
 #return sched
 	#0: Guaranteed schedulable.
 	#1: Not guaranteed schedulable, partition available, may try.
 	#2: Not schedulable, no partition available.
 def cluster_partition(info, prognum, corenum, option):
+	if admission == 'rta' and libpartition is None:
+		raise RuntimeError('rta admission needs libpartition.so, run make first')
 	#sort util from high to low
 	info.sort(key=sortutil)
 	#print(info)
@@ -522,7 +677,7 @@ def cluster_partition(info, prognum, corenum, option):
 	#[[posscoreid, remaining_util, highid], ]
 	possible = []
 	for i in range(0, len(info)):
-		period = info[i][1]
+		dline = deadline(info[i])
 		work = info[i][3]
 		span = info[i][4]
 		util = info[i][2]
@@ -531,11 +686,13 @@ def cluster_partition(info, prognum, corenum, option):
 			if partedcore+1 == corenum:
 				#print("not core for high tasks", info)
 				return 2, [], []
+			if span >= dline:
+				return 2, [], []
 			#number of cores assigned to high tasks
 			#numcore = int(math.ceil(2*util))
-			#number = (C-L)(P-L)
-			tmp = 1.0*(work - span)/(period - span)
-			print(work, span, period)
+			#number = (C-L)(D-L)
+			tmp = 1.0*(work - span)/(dline - span)
+			print(work, span, dline)
 			print(util, tmp)
 			numcore = int(math.ceil(tmp))
 			if numcore == 1:
@@ -572,136 +729,36 @@ def cluster_partition(info, prognum, corenum, option):
 	#if i+1 >= len(info):
 	if lowid == len(info):
 		#print('no low')
-		#for 36#
-		if option == 6 and corenum == 36:
-			#print("36 cores, four sockets")
-			#print(corestr)
-			#print(outinfo)
-			#print(possible)
-			needchange = 0
-			highinfo = []
-			for eachhigh in outinfo:
-				highinfo.append([eachhigh[7]-eachhigh[6]+1,eachhigh])
-				if eachhigh[6] <= 11 and eachhigh[7] > 11:
-					needchange = 1
-				elif eachhigh[6] <= 23 and eachhigh[7] > 23:
-					needchange = 1
-			if needchange == 1:
-				highinfo.sort(key=sorthigh)
-				socket = [12, 12, 12]
-				for eachhigh in highinfo:
-					if eachhigh[0] <= socket[0]:
-						socket[0] -= eachhigh[0]
-					elif eachhigh[0] <= socket[1]:
-						socket[1] -= eachhigh[0]
-					elif eachhigh[0] <= socket[2]:
-						socket[2] -= eachhigh[0]
-					else:
-						return 0, corestr, outinfo
-				socket = [12, 12, 12]
-				for eachhigh in highinfo:
-					if eachhigh[0] <= socket[0]:
-						sid = 0
-						socket[0] -= eachhigh[0]
-					elif eachhigh[0] <= socket[1]:
-						sid = 1
-						socket[1] -= eachhigh[0]
-					elif eachhigh[0] <= socket[2]:
-						sid = 2
-						socket[2] -= eachhigh[0]
-					newhigh = copy.deepcopy(eachhigh[1])
-					newhigh[6] = (sid+1)*12-socket[sid]-eachhigh[0]
-					newhigh[7] = (sid+1)*12-socket[sid]-1
-					#print(sid, socket[sid],newhigh)
-					#possible
-					outinfo.remove(eachhigh[1])
-					outinfo.append(newhigh)
-					corestr[eachhigh[1][6]].remove(eachhigh[1])
-					corestr[newhigh[6]].append(newhigh)
-				#print(highinfo)
-				#print(outinfo)
-				#print(corestr)
-			#for analysis#
-			#return -10, corestr, outinfo
+		if option == 6:
+			place_clusters(outinfo, corestr, possible, corenum)
 		return 0, corestr, outinfo
 	if numlowcore == 0 and i < len(info):
 		return 2, [], []
 
-	#sort low tasks according to period
+	#sort low tasks according to deadline, which is the period unless constrained
 	lowinfo = info[lowid:len(info)]
-	lowinfo.sort(key=sortperiod)
+	lowinfo.sort(key=sortdeadline)
 	#print(lowinfo)
 	#scale low tasks
-	tmax = lowinfo[-1][1]
-	tmin = lowinfo[0][1]
+	tmax = deadline(lowinfo[-1])
+	tmin = deadline(lowinfo[0])
 	scale = 1.0*tmax/tmin
 	if scale >= 2.0:
 		for task in lowinfo:
 			#Ti'=(ti-min)/(max-min) + 1
-			period = task[1]
+			period = deadline(task)
 			t = 1.0*(period-tmin)/(tmax-tmin)+1
 			task.append(t)
 	else:
 		for task in lowinfo:
-			task.append(task[1])
+			task.append(deadline(task))
 
-	#for 36#
-	fitsocket = 0
-	if option == 6 and corenum == 36:
-		#print("36 cores, four sockets")
-		#print(corestr)
-		#print(outinfo)
-		#print(possible)
-		needchange = 0
-		highinfo = []
-		for eachhigh in outinfo:
-			highinfo.append([eachhigh[7]-eachhigh[6]+1,eachhigh])
-			if eachhigh[6] <= 11 and eachhigh[7] > 11:
-				needchange = 1
-			elif eachhigh[6] <= 23 and eachhigh[7] > 23:
-				needchange = 1
-		if needchange == 1:
-			highinfo.sort(key=sorthigh)
-			socket = [12, 12, 12]
-			for eachhigh in highinfo:
-				if eachhigh[0] <= socket[0]:
-					socket[0] -= eachhigh[0]
-				elif eachhigh[0] <= socket[1]:
-					socket[1] -= eachhigh[0]
-				elif eachhigh[0] <= socket[2]:
-					socket[2] -= eachhigh[0]
-				else:
-					fitsocket = 1
-			if fitsocket == 0:
-				possible = []
-				socket = [12, 12, 12]
-				fitsocket = [0, 12, 24]
-				for eachhigh in highinfo:
-					if eachhigh[0] <= socket[0]:
-						sid = 0
-						socket[0] -= eachhigh[0]
-					elif eachhigh[0] <= socket[1]:
-						sid = 1
-						socket[1] -= eachhigh[0]
-					elif eachhigh[0] <= socket[2]:
-						sid = 2
-						socket[2] -= eachhigh[0]
-					newhigh = copy.deepcopy(eachhigh[1])
-					newhigh[6] = (sid+1)*12-socket[sid]-eachhigh[0]
-					newhigh[7] = (sid+1)*12-socket[sid]-1
-					#print(sid, socket[sid],newhigh)
-					fitsocket[sid] = newhigh[7]+1
-					tmpid = info.index(eachhigh[1][0:5])
-					possible.append([newhigh[7],newhigh[2],tmpid])
-					outinfo.remove(eachhigh[1])
-					outinfo.append(newhigh)
-					corestr[eachhigh[1][6]].remove(eachhigh[1])
-					corestr[newhigh[6]].append(newhigh)
-				#print(highinfo)
-				#print(outinfo)
-				#print(corestr)
-		else: 
-			fitsocket = 2
+	#id of all lowcores
+	lowcore = None
+	if option == 6:
+		lowcore = place_clusters(outinfo, corestr, possible, corenum)
+	if lowcore is None:
+		lowcore = list(range(partedcore, corenum))
 
 	#generate possible core id and program id list
 	posscore = []
@@ -712,23 +769,6 @@ def cluster_partition(info, prognum, corenum, option):
 			posscore.append(each[0])
 			highid.append(each[2])
 
-	#id of all lowcores
-	lowcore = []
-	for i in range(partedcore, corenum):
-		lowcore.append(i)
-	#for 36#
-	if fitsocket != 0 and fitsocket != 1 and fitsocket != 2:
-		#print("=========",fitsocket,"=========")
-		#print(possible)
-		#print(posscore)
-		#print(highid)
-		lowcore = []
-		for j in range(0, 3):
-			for i in range(fitsocket[j], (j+1)*12):
-				lowcore.append(i)
-		#print("lowcore",lowcore)
-	#print("lowcore",lowcore)
-
 	if option == 0 or option == 5:
 		sched = original(lowcore, lowinfo, posscore, highid, corestat, corestr, outinfo, threshold)
 	elif option == 1:
@@ -752,15 +792,12 @@ def cluster_partition(info, prognum, corenum, option):
 	#print("\t",outinfo)
 	if sched == 2:
 		return sched, [], []
+	if admission == 'rta':
+		assign_priorities(corestr, lowcore)
+	if sched == 0 and deadlines and not rta_schedulable(corestr, lowcore):
+		sched = 1
 	#print(sched, corestat)
 	#print(outinfo)
-	#for 36#
-	#for analysis#
-	#if fitsocket != 0 and fitsocket != 1:
-	#	if sched == 0:
-	#		return -10, corestr, outinfo
-	#	else:
-	#		return -11, corestr, outinfo
 	return sched, corestr, outinfo
 
 
@@ -776,7 +813,7 @@ def cluster_partition(info, prognum, corenum, option):
 #3. original + load balancing + 0.90 threshold
 #4. original + load balancing + 0.95 threshold
 #5. original + load balancing + 0.90 threshold + 0.95 threshold + ori
-#6. for 36 (corenum = 36) + load balancing + 0.90 threshold
+#6. clusters placed by topology (see place_clusters) + load balancing + 0.90 threshold
 def cluster_assign_core(allsub, prognum, corenum, option):
 	#output
 	#info: ['prog_name', period, util, worst_case, span]
@@ -842,6 +879,104 @@ def cluster_assign_core(allsub, prognum, corenum, option):
 	return sched, corestr, outinfo
 
 
+#shared resources (see resource_lock.h)
+#resources: {'prog_name': [[resource_name, requests_per_job, cs], ], }
+#requests are spin based FIFO with priority boosting, so a request waits for at
+#most one critical section on each other core that uses the resource, and a
+#job is blocked at most once by a lower priority job on its core
+
+#longest critical section for each resource on each core
+#corecs: {resource_name: [cs on core 0, cs on core 1, ...]}
+def resource_core_cs(outinfo, resources, corenum):
+	corecs = {}
+	for prog in outinfo:
+		for (res, requests, cs) in resources.get(prog[0], []):
+			if res not in corecs:
+				corecs[res] = [0]*corenum
+			for core in range(prog[6], prog[7]+1):
+				corecs[res][core] = max(corecs[res][core], cs)
+	return corecs
+
+#worst case spinning of one request of prog for res
+def request_spin(prog, res, corecs):
+	return sum(corecs[res]) - corecs[res][prog[6]]
+
+#worst case spinning of all requests of a job of prog
+def job_spin(prog, resources, corecs):
+	spin = 0
+	for (res, requests, cs) in resources.get(prog[0], []):
+		spin += requests*request_spin(prog, res, corecs)
+	return spin
+
+#longest boosted request of a lower priority task on the core of prog
+def local_blocking(prog, coreprogs, resources, corecs):
+	blocking = 0
+	for other in coreprogs:
+		if other[5] < prog[5]:
+			for (res, requests, cs) in resources.get(other[0], []):
+				if requests > 0:
+					blocking = max(blocking, request_spin(other, res, corecs)+cs)
+	return blocking
+
+#schedulability test that accounts for blocking
+#heavy tasks: federated test with the spinning added to work and span
+#light tasks: response time analysis on each core with spinning and local blocking
+#outinfo: ['prog_name', period, util, worst_case, span, *priority, *firstc, *lastc]
+#return (schedulable, delays), delays: {'prog_name': [spin, blocking, response]}
+def blocking_analysis(outinfo, resources, corenum):
+	corecs = resource_core_cs(outinfo, resources, corenum)
+	coreprogs = []
+	for m in range(0, corenum):
+		coreprogs.append([])
+	for prog in outinfo:
+		if prog[6] == prog[7]:
+			coreprogs[prog[6]].append(prog)
+
+	schedulable = True
+	delays = {}
+	for prog in outinfo:
+		dline = deadline(prog)
+		spin = job_spin(prog, resources, corecs)
+		if prog[6] < prog[7]:
+			work = prog[3] + spin
+			span = prog[4] + spin
+			numcore = prog[7] - prog[6] + 1
+			if span >= dline or 1.0*(work - span)/(dline - span) > numcore:
+				schedulable = False
+			delays[prog[0]] = [spin, 0, span]
+		else:
+			blocking = local_blocking(prog, coreprogs[prog[6]], resources, corecs)
+			higher = []
+			for other in coreprogs[prog[6]]:
+				if other[5] > prog[5]:
+					higher.append([other[1], other[3] + job_spin(other, resources, corecs)])
+			own = prog[3] + spin + blocking
+			response = own
+			while response <= dline:
+				demand = own
+				for (otherperiod, otherwork) in higher:
+					demand += int(math.ceil(1.0*response/otherperiod))*otherwork
+				if demand == response:
+					break
+				response = demand
+			if response > dline:
+				schedulable = False
+			delays[prog[0]] = [spin, blocking, response]
+	return schedulable, delays
+
+#inflate the work and span of each task by its delays for the next partition
+#info: ['prog_name', period, util, worst_case, span]
+def inflate_info(info, delays):
+	inflated = copy.deepcopy(info)
+	for prog in inflated:
+		if prog[0] in delays:
+			(spin, blocking, response) = delays[prog[0]]
+			prog[3] += spin + blocking
+			prog[4] += spin + blocking
+			prog[2] = 1.0*prog[3]/prog[1]
+	return inflated
+
+
 #simulate multiple jobs on single execution
 #alljobs: ['prog_name', period, util, worst_case, span, *priority, *firstc, *lastc, release, deadline]
 def single_simu(alljobs, hyper):
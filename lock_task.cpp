@@ -0,0 +1,90 @@
+// An example of tasks sharing data through a resource lock (see resource_lock.h)
+// Call the functions with the following arguments in argv:
+//     executable_name resource_name requests_per_job critical_section_ns
+// Each job makes requests_per_job requests for the resource, spread over its
+// OpenMP threads. In each critical section a thread marks the shared data as its
+// own, computes for critical_section_ns and increments a shared counter. If
+// another thread entered the critical section meanwhile, the mark is gone and
+// finalize reports the violation. Annotate the task's timing line in the .rtpt
+// file with resource_name:requests_per_job:0:critical_section_ns so that cluster.py
+// accounts for the blocking.
+
+#include <omp.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <sstream>
+#include <string>
+#include "task.h"
+#include "resource_lock.h"
+#include "timespec_functions.h"
+
+typedef struct
+{
+	unsigned long counter;
+	unsigned long owner;
+}
+shared_data_t;
+
+std::string resource_name;
+unsigned requests_per_job;
+long critical_section_ns;
+resource_lock_t lock;
+unsigned long violations = 0;
+
+enum rt_gomp_lock_task_error_codes
+{
+	RT_GOMP_LOCK_TASK_SUCCESS,
+	RT_GOMP_LOCK_TASK_INVALID_ARGUMENTS,
+	RT_GOMP_LOCK_TASK_LOCK_ERROR,
+	RT_GOMP_LOCK_TASK_VERIFY_ERROR
+};
+
+int init(int argc, char *argv[])
+{
+	if (!(
+		argc == 4 &&
+		std::istringstream(argv[1]) >> resource_name &&
+		std::istringstream(argv[2]) >> requests_per_job &&
+		std::istringstream(argv[3]) >> critical_section_ns && critical_section_ns >= 0
+	))
+	{
+		fprintf(stderr, "ERROR: Invalid initialization arguments");
+		return RT_GOMP_LOCK_TASK_INVALID_ARGUMENTS;
+	}
+
+	if (resource_lock_open(&lock, resource_name.c_str(), sizeof(shared_data_t)) != 0)
+	{
+		return RT_GOMP_LOCK_TASK_LOCK_ERROR;
+	}
+	return 0;
+}
+
+int run(int argc, char *argv[])
+{
+	const timespec critical_section = { critical_section_ns / nanosec_in_sec, critical_section_ns % nanosec_in_sec };
+	volatile shared_data_t *data = static_cast<shared_data_t *>(lock.data);
+
+	#pragma omp parallel for schedule(static)
+	for (unsigned r = 0; r < requests_per_job; ++r)
+	{
+		const unsigned long id = (unsigned long) getpid() * 1024 + omp_get_thread_num();
+		resource_lock_acquire(&lock);
+		data->owner = id;
+		busy_work(critical_section);
+		if (data->owner != id) violations += 1;
+		data->counter += 1;
+		resource_lock_release(&lock);
+	}
+
+	return 0;
+}
+
+int finalize(int argc, char *argv[])
+{
+	fprintf(stderr, "Shared counter of resource %s is %lu, mutual exclusion violations %lu\n",
+	        resource_name.c_str(), static_cast<shared_data_t *>(lock.data)->counter, violations);
+	resource_lock_close(&lock);
+	return violations == 0 ? RT_GOMP_LOCK_TASK_SUCCESS : RT_GOMP_LOCK_TASK_VERIFY_ERROR;
+}
+
+task_t task = { init, run, finalize };
@@ -0,0 +1,337 @@
+#include "matvec.h"
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+#include "first_touch.h"
+
+size_t matvec_row_stride(size_t num_cols)
+{
+	const size_t doubles_per_line = matvec_alignment / sizeof(double);
+	return (num_cols + doubles_per_line - 1) / doubles_per_line * doubles_per_line;
+}
+
+double *matvec_alloc(size_t count)
+{
+	void *ptr = NULL;
+	if (count == 0) count = 1;
+	if (posix_memalign(&ptr, matvec_alignment, count * sizeof(double)) != 0)
+	{
+		return NULL;
+	}
+	return static_cast<double *>(ptr);
+}
+
+static inline size_t min_size(size_t a, size_t b)
+{
+	return a < b ? a : b;
+}
+
+// Stores a row sum computed over one column block. The first block overwrites
+// the result and later blocks accumulate into it.
+static inline void store_row(double *result, size_t r, double sum, bool first_block)
+{
+	if (first_block) result[r] = sum;
+	else result[r] += sum;
+}
+
+// Reference kernel. Kept simple on purpose so that it can be used to verify the others.
+static void matvec_scalar(const double *matrix, size_t row_stride, const double *vector,
+                          double *result, size_t row_begin, size_t row_end, size_t num_cols)
+{
+	for (size_t r = row_begin; r < row_end; ++r)
+	{
+		const double *row = matrix + r * row_stride;
+		double sum = 0;
+		for (size_t c = 0; c < num_cols; ++c)
+		{
+			sum += row[c] * vector[c];
+		}
+		result[r] = sum;
+	}
+}
+
+// SSE2 kernel: 2 doubles per register, 4 rows x 2 registers of accumulators
+static void matvec_sse2(const double *matrix, size_t row_stride, const double *vector,
+                        double *result, size_t row_begin, size_t row_end, size_t num_cols)
+{
+	for (size_t cb = 0; cb < num_cols; cb += matvec_col_block)
+	{
+		const size_t ce = min_size(cb + matvec_col_block, num_cols);
+		const bool first_block = (cb == 0);
+		size_t r = row_begin;
+		for (; r + matvec_row_tile <= row_end; r += matvec_row_tile)
+		{
+			const double *r0 = matrix + r * row_stride;
+			const double *r1 = r0 + row_stride;
+			const double *r2 = r1 + row_stride;
+			const double *r3 = r2 + row_stride;
+			__m128d a0 = _mm_setzero_pd(), b0 = _mm_setzero_pd();
+			__m128d a1 = _mm_setzero_pd(), b1 = _mm_setzero_pd();
+			__m128d a2 = _mm_setzero_pd(), b2 = _mm_setzero_pd();
+			__m128d a3 = _mm_setzero_pd(), b3 = _mm_setzero_pd();
+			size_t c = cb;
+			for (; c + 4 <= ce; c += 4)
+			{
+				const __m128d v0 = _mm_load_pd(vector + c);
+				const __m128d v1 = _mm_load_pd(vector + c + 2);
+				a0 = _mm_add_pd(a0, _mm_mul_pd(_mm_load_pd(r0 + c), v0));
+				b0 = _mm_add_pd(b0, _mm_mul_pd(_mm_load_pd(r0 + c + 2), v1));
+				a1 = _mm_add_pd(a1, _mm_mul_pd(_mm_load_pd(r1 + c), v0));
+				b1 = _mm_add_pd(b1, _mm_mul_pd(_mm_load_pd(r1 + c + 2), v1));
+				a2 = _mm_add_pd(a2, _mm_mul_pd(_mm_load_pd(r2 + c), v0));
+				b2 = _mm_add_pd(b2, _mm_mul_pd(_mm_load_pd(r2 + c + 2), v1));
+				a3 = _mm_add_pd(a3, _mm_mul_pd(_mm_load_pd(r3 + c), v0));
+				b3 = _mm_add_pd(b3, _mm_mul_pd(_mm_load_pd(r3 + c + 2), v1));
+			}
+			double sums[matvec_row_tile][2];
+			_mm_storeu_pd(sums[0], _mm_add_pd(a0, b0));
+			_mm_storeu_pd(sums[1], _mm_add_pd(a1, b1));
+			_mm_storeu_pd(sums[2], _mm_add_pd(a2, b2));
+			_mm_storeu_pd(sums[3], _mm_add_pd(a3, b3));
+			const double *rows[matvec_row_tile] = { r0, r1, r2, r3 };
+			for (size_t t = 0; t < matvec_row_tile; ++t)
+			{
+				double sum = sums[t][0] + sums[t][1];
+				for (size_t cc = c; cc < ce; ++cc) sum += rows[t][cc] * vector[cc];
+				store_row(result, r + t, sum, first_block);
+			}
+		}
+		for (; r < row_end; ++r)
+		{
+			const double *row = matrix + r * row_stride;
+			__m128d a = _mm_setzero_pd();
+			size_t c = cb;
+			for (; c + 2 <= ce; c += 2)
+			{
+				a = _mm_add_pd(a, _mm_mul_pd(_mm_load_pd(row + c), _mm_load_pd(vector + c)));
+			}
+			double pair[2];
+			_mm_storeu_pd(pair, a);
+			double sum = pair[0] + pair[1];
+			for (; c < ce; ++c) sum += row[c] * vector[c];
+			store_row(result, r, sum, first_block);
+		}
+	}
+}
+
+__attribute__((target("avx2,fma")))
+static inline double hsum_avx2(__m256d a)
+{
+	__m128d lo = _mm256_castpd256_pd128(a);
+	__m128d hi = _mm256_extractf128_pd(a, 1);
+	lo = _mm_add_pd(lo, hi);
+	return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+// AVX2 kernel: 4 doubles per register, 4 rows x 2 registers of FMA accumulators
+__attribute__((target("avx2,fma")))
+static void matvec_avx2(const double *matrix, size_t row_stride, const double *vector,
+                        double *result, size_t row_begin, size_t row_end, size_t num_cols)
+{
+	for (size_t cb = 0; cb < num_cols; cb += matvec_col_block)
+	{
+		const size_t ce = min_size(cb + matvec_col_block, num_cols);
+		const bool first_block = (cb == 0);
+		size_t r = row_begin;
+		for (; r + matvec_row_tile <= row_end; r += matvec_row_tile)
+		{
+			const double *r0 = matrix + r * row_stride;
+			const double *r1 = r0 + row_stride;
+			const double *r2 = r1 + row_stride;
+			const double *r3 = r2 + row_stride;
+			__m256d a0 = _mm256_setzero_pd(), b0 = _mm256_setzero_pd();
+			__m256d a1 = _mm256_setzero_pd(), b1 = _mm256_setzero_pd();
+			__m256d a2 = _mm256_setzero_pd(), b2 = _mm256_setzero_pd();
+			__m256d a3 = _mm256_setzero_pd(), b3 = _mm256_setzero_pd();
+			size_t c = cb;
+			for (; c + 8 <= ce; c += 8)
+			{
+				const __m256d v0 = _mm256_load_pd(vector + c);
+				const __m256d v1 = _mm256_load_pd(vector + c + 4);
+				a0 = _mm256_fmadd_pd(_mm256_load_pd(r0 + c), v0, a0);
+				b0 = _mm256_fmadd_pd(_mm256_load_pd(r0 + c + 4), v1, b0);
+				a1 = _mm256_fmadd_pd(_mm256_load_pd(r1 + c), v0, a1);
+				b1 = _mm256_fmadd_pd(_mm256_load_pd(r1 + c + 4), v1, b1);
+				a2 = _mm256_fmadd_pd(_mm256_load_pd(r2 + c), v0, a2);
+				b2 = _mm256_fmadd_pd(_mm256_load_pd(r2 + c + 4), v1, b2);
+				a3 = _mm256_fmadd_pd(_mm256_load_pd(r3 + c), v0, a3);
+				b3 = _mm256_fmadd_pd(_mm256_load_pd(r3 + c + 4), v1, b3);
+			}
+			const double sums[matvec_row_tile] = {
+				hsum_avx2(_mm256_add_pd(a0, b0)), hsum_avx2(_mm256_add_pd(a1, b1)),
+				hsum_avx2(_mm256_add_pd(a2, b2)), hsum_avx2(_mm256_add_pd(a3, b3))
+			};
+			const double *rows[matvec_row_tile] = { r0, r1, r2, r3 };
+			for (size_t t = 0; t < matvec_row_tile; ++t)
+			{
+				double sum = sums[t];
+				for (size_t cc = c; cc < ce; ++cc) sum += rows[t][cc] * vector[cc];
+				store_row(result, r + t, sum, first_block);
+			}
+		}
+		for (; r < row_end; ++r)
+		{
+			const double *row = matrix + r * row_stride;
+			__m256d a = _mm256_setzero_pd();
+			size_t c = cb;
+			for (; c + 4 <= ce; c += 4)
+			{
+				a = _mm256_fmadd_pd(_mm256_load_pd(row + c), _mm256_load_pd(vector + c), a);
+			}
+			double sum = hsum_avx2(a);
+			for (; c < ce; ++c) sum += row[c] * vector[c];
+			store_row(result, r, sum, first_block);
+		}
+	}
+}
+
+__attribute__((target("avx512f")))
+static inline double hsum_avx512(__m512d a)
+{
+	// Reduce through memory; the register extract intrinsics trigger spurious
+	// uninitialized-variable warnings in some GCC versions.
+	double lanes[8] __attribute__((aligned(64)));
+	_mm512_store_pd(lanes, a);
+	return ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) + ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7]));
+}
+
+// AVX-512 kernel: 8 doubles per register, 4 rows x 2 registers of FMA accumulators
+__attribute__((target("avx512f")))
+static void matvec_avx512(const double *matrix, size_t row_stride, const double *vector,
+                          double *result, size_t row_begin, size_t row_end, size_t num_cols)
+{
+	for (size_t cb = 0; cb < num_cols; cb += matvec_col_block)
+	{
+		const size_t ce = min_size(cb + matvec_col_block, num_cols);
+		const bool first_block = (cb == 0);
+		size_t r = row_begin;
+		for (; r + matvec_row_tile <= row_end; r += matvec_row_tile)
+		{
+			const double *r0 = matrix + r * row_stride;
+			const double *r1 = r0 + row_stride;
+			const double *r2 = r1 + row_stride;
+			const double *r3 = r2 + row_stride;
+			__m512d a0 = _mm512_setzero_pd(), b0 = _mm512_setzero_pd();
+			__m512d a1 = _mm512_setzero_pd(), b1 = _mm512_setzero_pd();
+			__m512d a2 = _mm512_setzero_pd(), b2 = _mm512_setzero_pd();
+			__m512d a3 = _mm512_setzero_pd(), b3 = _mm512_setzero_pd();
+			size_t c = cb;
+			for (; c + 16 <= ce; c += 16)
+			{
+				const __m512d v0 = _mm512_load_pd(vector + c);
+				const __m512d v1 = _mm512_load_pd(vector + c + 8);
+				a0 = _mm512_fmadd_pd(_mm512_load_pd(r0 + c), v0, a0);
+				b0 = _mm512_fmadd_pd(_mm512_load_pd(r0 + c + 8), v1, b0);
+				a1 = _mm512_fmadd_pd(_mm512_load_pd(r1 + c), v0, a1);
+				b1 = _mm512_fmadd_pd(_mm512_load_pd(r1 + c + 8), v1, b1);
+				a2 = _mm512_fmadd_pd(_mm512_load_pd(r2 + c), v0, a2);
+				b2 = _mm512_fmadd_pd(_mm512_load_pd(r2 + c + 8), v1, b2);
+				a3 = _mm512_fmadd_pd(_mm512_load_pd(r3 + c), v0, a3);
+				b3 = _mm512_fmadd_pd(_mm512_load_pd(r3 + c + 8), v1, b3);
+			}
+			// Handle the last partial group of columns with masked loads
+			if (c < ce)
+			{
+				const size_t left = ce - c;
+				const __mmask8 m0 = (__mmask8) ((1u << min_size(left, 8)) - 1);
+				const __mmask8 m1 = left > 8 ? (__mmask8) ((1u << (left - 8)) - 1) : (__mmask8) 0;
+				const __m512d v0 = _mm512_maskz_load_pd(m0, vector + c);
+				const __m512d v1 = _mm512_maskz_load_pd(m1, vector + c + 8);
+				a0 = _mm512_fmadd_pd(_mm512_maskz_load_pd(m0, r0 + c), v0, a0);
+				b0 = _mm512_fmadd_pd(_mm512_maskz_load_pd(m1, r0 + c + 8), v1, b0);
+				a1 = _mm512_fmadd_pd(_mm512_maskz_load_pd(m0, r1 + c), v0, a1);
+				b1 = _mm512_fmadd_pd(_mm512_maskz_load_pd(m1, r1 + c + 8), v1, b1);
+				a2 = _mm512_fmadd_pd(_mm512_maskz_load_pd(m0, r2 + c), v0, a2);
+				b2 = _mm512_fmadd_pd(_mm512_maskz_load_pd(m1, r2 + c + 8), v1, b2);
+				a3 = _mm512_fmadd_pd(_mm512_maskz_load_pd(m0, r3 + c), v0, a3);
+				b3 = _mm512_fmadd_pd(_mm512_maskz_load_pd(m1, r3 + c + 8), v1, b3);
+			}
+			store_row(result, r, hsum_avx512(_mm512_add_pd(a0, b0)), first_block);
+			store_row(result, r + 1, hsum_avx512(_mm512_add_pd(a1, b1)), first_block);
+			store_row(result, r + 2, hsum_avx512(_mm512_add_pd(a2, b2)), first_block);
+			store_row(result, r + 3, hsum_avx512(_mm512_add_pd(a3, b3)), first_block);
+		}
+		for (; r < row_end; ++r)
+		{
+			const double *row = matrix + r * row_stride;
+			__m512d a = _mm512_setzero_pd();
+			for (size_t c = cb; c < ce; c += 8)
+			{
+				const size_t left = ce - c;
+				const __mmask8 m = (__mmask8) ((1u << min_size(left, 8)) - 1);
+				a = _mm512_fmadd_pd(_mm512_maskz_load_pd(m, row + c), _mm512_maskz_load_pd(m, vector + c), a);
+			}
+			store_row(result, r, hsum_avx512(a), first_block);
+		}
+	}
+}
+
+bool matvec_kernel_supported(matvec_kernel_kind kind)
+{
+	// __builtin_cpu_supports reads the CPUID feature bits once at startup and
+	// also checks that the operating system saves the wider register state.
+	switch (kind)
+	{
+		case MATVEC_KERNEL_SCALAR:
+		case MATVEC_KERNEL_AUTO:
+			return true;
+		case MATVEC_KERNEL_SSE2:
+			return __builtin_cpu_supports("sse2");
+		case MATVEC_KERNEL_AVX2:
+			return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+		case MATVEC_KERNEL_AVX512:
+			return __builtin_cpu_supports("avx512f");
+	}
+	return false;
+}
+
+matvec_kernel_t matvec_get_kernel(matvec_kernel_kind kind, matvec_kernel_kind *selected)
+{
+	if (kind == MATVEC_KERNEL_AUTO)
+	{
+		if (matvec_kernel_supported(MATVEC_KERNEL_AVX512)) kind = MATVEC_KERNEL_AVX512;
+		else if (matvec_kernel_supported(MATVEC_KERNEL_AVX2)) kind = MATVEC_KERNEL_AVX2;
+		else if (matvec_kernel_supported(MATVEC_KERNEL_SSE2)) kind = MATVEC_KERNEL_SSE2;
+		else kind = MATVEC_KERNEL_SCALAR;
+	}
+
+	if (!matvec_kernel_supported(kind))
+	{
+		return NULL;
+	}
+
+	if (selected != NULL) *selected = kind;
+
+	switch (kind)
+	{
+		case MATVEC_KERNEL_SSE2: return matvec_sse2;
+		case MATVEC_KERNEL_AVX2: return matvec_avx2;
+		case MATVEC_KERNEL_AVX512: return matvec_avx512;
+		default: return matvec_scalar;
+	}
+}
+
+static const char *matvec_kernel_names[] = { "scalar", "sse2", "avx2", "avx512", "auto" };
+
+bool matvec_parse_kernel_kind(const char *name, matvec_kernel_kind *kind)
+{
+	for (int i = MATVEC_KERNEL_SCALAR; i <= MATVEC_KERNEL_AUTO; ++i)
+	{
+		if (strcmp(name, matvec_kernel_names[i]) == 0)
+		{
+			*kind = static_cast<matvec_kernel_kind>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+const char *matvec_kernel_name(matvec_kernel_kind kind)
+{
+	return matvec_kernel_names[kind];
+}
+
+void matvec_thread_rows(size_t num_rows, size_t *row_begin, size_t *row_end)
+{
+	omp_static_range(num_rows, matvec_row_tile, row_begin, row_end);
+}
@@ -0,0 +1,59 @@
+#ifndef RT_GOMP_MATVEC_H
+#define RT_GOMP_MATVEC_H
+
+#include <stddef.h>
+
+// Matrix-vector multiplication kernels used by simple_task. The matrix is stored
+// row major with a padded row stride (see matvec_row_stride) so that every row
+// starts on a 64 byte boundary. Each kernel computes result = matrix * vector for
+// the rows [row_begin, row_end) and keeps its partial sums in registers for a tile
+// of rows at a time. Columns are processed in blocks so that the slice of the
+// vector being used stays in the L1 cache while a thread walks down its rows.
+
+// Number of rows accumulated together in registers by the SIMD kernels
+const size_t matvec_row_tile = 4;
+
+// Number of columns processed per cache block
+const size_t matvec_col_block = 2048;
+
+// Alignment in bytes of matrix rows and vectors
+const size_t matvec_alignment = 64;
+
+enum matvec_kernel_kind
+{
+	MATVEC_KERNEL_SCALAR,
+	MATVEC_KERNEL_SSE2,
+	MATVEC_KERNEL_AVX2,
+	MATVEC_KERNEL_AVX512,
+	MATVEC_KERNEL_AUTO
+};
+
+typedef void (*matvec_kernel_t)(const double *matrix, size_t row_stride, const double *vector,
+                                double *result, size_t row_begin, size_t row_end, size_t num_cols);
+
+// Returns the row stride, in elements, used for a matrix with the given number of columns.
+size_t matvec_row_stride(size_t num_cols);
+
+// Allocates count doubles aligned to matvec_alignment. Release with free(). Returns NULL on failure.
+double *matvec_alloc(size_t count);
+
+// Returns true if the processor and operating system support the given kernel.
+bool matvec_kernel_supported(matvec_kernel_kind kind);
+
+// Returns the kernel of the given kind. MATVEC_KERNEL_AUTO selects the widest
+// kernel supported by the processor as reported by CPUID. The kind actually
+// selected is stored in selected if it is not NULL. Returns NULL if the
+// requested kind is not supported.
+matvec_kernel_t matvec_get_kernel(matvec_kernel_kind kind, matvec_kernel_kind *selected);
+
+// Parses a kernel name (scalar, sse2, avx2, avx512 or auto). Returns false if the name is unknown.
+bool matvec_parse_kernel_kind(const char *name, matvec_kernel_kind *kind);
+
+const char *matvec_kernel_name(matvec_kernel_kind kind);
+
+// Computes this thread's share of the rows for a static partition of num_rows rows
+// into whole row tiles (see omp_static_range in first_touch.h). Must be called from
+// inside a parallel region.
+void matvec_thread_rows(size_t num_rows, size_t *row_begin, size_t *row_end);
+
+#endif /* RT_GOMP_MATVEC_H */
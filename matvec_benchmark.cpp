@@ -0,0 +1,160 @@
+// Compares the matrix-vector kernels used by simple_task.
+// Usage: matvec_benchmark [num_repetitions [num_rows num_cols ...]]
+// Without size arguments the 50x50 and 1000x1000 configurations of simple_taskset.rtpt are used.
+// Each kernel is checked against the scalar reference and then timed using all
+// available OpenMP threads, the same way simple_task runs it. The mean running
+// time is reported as GFLOP/s and the longest running time as the observed WCET.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <sstream>
+#include <vector>
+#include <omp.h>
+#include "matvec.h"
+#include "timespec_functions.h"
+
+enum rt_gomp_matvec_benchmark_error_codes
+{
+	RT_GOMP_MATVEC_BENCHMARK_SUCCESS,
+	RT_GOMP_MATVEC_BENCHMARK_ARG_PARSE_ERROR,
+	RT_GOMP_MATVEC_BENCHMARK_MEM_ALLOC_ERROR,
+	RT_GOMP_MATVEC_BENCHMARK_VERIFY_ERROR
+};
+
+static void run_kernel(matvec_kernel_t kernel, const double *matrix, size_t row_stride,
+                       const double *vector, double *result, size_t num_rows, size_t num_cols)
+{
+	#pragma omp parallel
+	{
+		size_t row_begin, row_end;
+		matvec_thread_rows(num_rows, &row_begin, &row_end);
+		kernel(matrix, row_stride, vector, result, row_begin, row_end, num_cols);
+	}
+}
+
+static int benchmark(size_t num_rows, size_t num_cols, unsigned num_repetitions)
+{
+	const size_t row_stride = matvec_row_stride(num_cols);
+	double *matrix = matvec_alloc(num_rows * row_stride);
+	double *vector = matvec_alloc(num_cols);
+	double *reference = matvec_alloc(num_rows);
+	double *result = matvec_alloc(num_rows);
+	if (!matrix || !vector || !reference || !result)
+	{
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		return RT_GOMP_MATVEC_BENCHMARK_MEM_ALLOC_ERROR;
+	}
+	
+	srand48(num_rows * num_cols);
+	for (size_t r = 0; r < num_rows; ++r)
+	{
+		for (size_t c = 0; c < num_cols; ++c) matrix[r * row_stride + c] = drand48() - 0.5;
+	}
+	for (size_t c = 0; c < num_cols; ++c) vector[c] = drand48() - 0.5;
+	
+	matvec_kernel_t scalar = matvec_get_kernel(MATVEC_KERNEL_SCALAR, NULL);
+	run_kernel(scalar, matrix, row_stride, vector, reference, num_rows, num_cols);
+	
+	const double flops = 2.0 * num_rows * num_cols;
+	int ret_val = RT_GOMP_MATVEC_BENCHMARK_SUCCESS;
+	
+	for (int k = MATVEC_KERNEL_SCALAR; k < MATVEC_KERNEL_AUTO; ++k)
+	{
+		matvec_kernel_kind kind = static_cast<matvec_kernel_kind>(k);
+		matvec_kernel_t kernel = matvec_get_kernel(kind, NULL);
+		if (!kernel)
+		{
+			printf("%5zux%-5zu %-7s not supported\n", num_rows, num_cols, matvec_kernel_name(kind));
+			continue;
+		}
+		
+		// Verify against the reference. Summation order differs between kernels,
+		// so allow a relative error proportional to the row length.
+		run_kernel(kernel, matrix, row_stride, vector, result, num_rows, num_cols);
+		double max_error = 0;
+		for (size_t r = 0; r < num_rows; ++r)
+		{
+			double error = fabs(result[r] - reference[r]) / (1.0 + fabs(reference[r]));
+			if (error > max_error) max_error = error;
+		}
+		if (max_error > 1e-12 * num_cols)
+		{
+			fprintf(stderr, "ERROR: %s kernel differs from the scalar kernel by %g\n", matvec_kernel_name(kind), max_error);
+			ret_val = RT_GOMP_MATVEC_BENCHMARK_VERIFY_ERROR;
+		}
+		
+		timespec start, finish, runtime, total = { 0, 0 }, wcet = { 0, 0 };
+		for (unsigned i = 0; i < num_repetitions; ++i)
+		{
+			get_time(&start);
+			run_kernel(kernel, matrix, row_stride, vector, result, num_rows, num_cols);
+			get_time(&finish);
+			ts_diff(start, finish, runtime);
+			total = total + runtime;
+			if (runtime > wcet) wcet = runtime;
+		}
+		
+		timespec mean = total / num_repetitions;
+		double mean_secs = mean.tv_sec + mean.tv_nsec / 1e9;
+		printf("%5zux%-5zu %-7s ", num_rows, num_cols, matvec_kernel_name(kind));
+		std::cout << "mean " << mean << " secs, wcet " << wcet << " secs, ";
+		printf("%8.3f GFLOP/s, max error %g\n", flops / mean_secs / 1e9, max_error);
+		fflush(stdout);
+	}
+	
+	free(matrix);
+	free(vector);
+	free(reference);
+	free(result);
+	return ret_val;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned num_repetitions = 1000;
+	if (argc > 1 && !(std::istringstream(argv[1]) >> num_repetitions && num_repetitions > 0))
+	{
+		fprintf(stderr, "ERROR: Cannot parse number of repetitions\n");
+		return RT_GOMP_MATVEC_BENCHMARK_ARG_PARSE_ERROR;
+	}
+	
+	std::vector<size_t> sizes;
+	if (argc > 2)
+	{
+		for (int i = 2; i < argc; ++i)
+		{
+			size_t size;
+			if (!(std::istringstream(argv[i]) >> size && size > 0))
+			{
+				fprintf(stderr, "ERROR: Cannot parse matrix size %s\n", argv[i]);
+				return RT_GOMP_MATVEC_BENCHMARK_ARG_PARSE_ERROR;
+			}
+			sizes.push_back(size);
+		}
+		if (sizes.size() % 2 != 0)
+		{
+			fprintf(stderr, "ERROR: Matrix sizes must be given as num_rows num_cols pairs\n");
+			return RT_GOMP_MATVEC_BENCHMARK_ARG_PARSE_ERROR;
+		}
+	}
+	else
+	{
+		// The configurations used in simple_taskset.rtpt
+		sizes.push_back(50); sizes.push_back(50);
+		sizes.push_back(1000); sizes.push_back(1000);
+	}
+	
+	omp_set_dynamic(0);
+	omp_set_num_threads(omp_get_num_procs());
+	printf("%d OpenMP threads, %u repetitions\n", omp_get_max_threads(), num_repetitions);
+	
+	int ret_val = RT_GOMP_MATVEC_BENCHMARK_SUCCESS;
+	for (size_t i = 0; i < sizes.size(); i += 2)
+	{
+		int config_ret_val = benchmark(sizes[i], sizes[i + 1], num_repetitions);
+		if (config_ret_val != 0) ret_val = config_ret_val;
+	}
+	
+	return ret_val;
+}
@@ -0,0 +1,254 @@
+#include "numa_placement.h"
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#include <fstream>
+#include <sstream>
+
+static const unsigned bits_per_word = 8 * sizeof(unsigned long);
+
+void numa_node_mask_clear(numa_node_mask_t *mask)
+{
+	memset(mask->bits, 0, sizeof(mask->bits));
+}
+
+void numa_node_mask_set(numa_node_mask_t *mask, unsigned node)
+{
+	if (node < max_numa_nodes) mask->bits[node / bits_per_word] |= 1UL << (node % bits_per_word);
+}
+
+bool numa_node_mask_isset(const numa_node_mask_t *mask, unsigned node)
+{
+	return node < max_numa_nodes && (mask->bits[node / bits_per_word] & (1UL << (node % bits_per_word)));
+}
+
+unsigned numa_node_mask_count(const numa_node_mask_t *mask)
+{
+	unsigned count = 0;
+	for (unsigned node = 0; node < max_numa_nodes; ++node)
+	{
+		if (numa_node_mask_isset(mask, node)) count += 1;
+	}
+	return count;
+}
+
+bool parse_cpu_list(const std::string & list, std::vector<unsigned> & cpus)
+{
+	std::istringstream stream(list);
+	std::string range;
+	while (std::getline(stream, range, ','))
+	{
+		// Skip the trailing newline and empty lists
+		size_t end = range.find_last_not_of(" \n");
+		if (end == std::string::npos) continue;
+		range = range.substr(0, end + 1);
+		
+		unsigned first, last;
+		char dash;
+		std::istringstream range_stream(range);
+		if (!(range_stream >> first)) return false;
+		if (range_stream >> dash)
+		{
+			if (dash != '-' || !(range_stream >> last) || last < first) return false;
+		}
+		else
+		{
+			last = first;
+		}
+		
+		for (unsigned cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+	}
+	return true;
+}
+
+int read_numa_node_of_cpus(std::vector<unsigned> & node_of_cpu)
+{
+	const char *node_dir_name = "/sys/devices/system/node";
+	node_of_cpu.assign(sysconf(_SC_NPROCESSORS_CONF), 0);
+	
+	DIR *node_dir = opendir(node_dir_name);
+	if (node_dir == NULL)
+	{
+		// No NUMA support in the kernel: everything is on node 0
+		return RT_GOMP_NUMA_PLACEMENT_SUCCESS;
+	}
+	
+	int ret_val = RT_GOMP_NUMA_PLACEMENT_SUCCESS;
+	struct dirent *entry;
+	while ((entry = readdir(node_dir)) != NULL)
+	{
+		unsigned node;
+		char extra;
+		if (sscanf(entry->d_name, "node%u%c", &node, &extra) != 1) continue;
+		
+		std::string cpulist_name = std::string(node_dir_name) + "/" + entry->d_name + "/cpulist";
+		std::ifstream cpulist_file(cpulist_name.c_str());
+		std::string cpulist;
+		std::vector<unsigned> cpus;
+		if (!std::getline(cpulist_file, cpulist) || !parse_cpu_list(cpulist, cpus))
+		{
+			fprintf(stderr, "ERROR: Cannot read %s\n", cpulist_name.c_str());
+			ret_val = RT_GOMP_NUMA_PLACEMENT_SYSFS_ERROR;
+			break;
+		}
+		
+		for (size_t i = 0; i < cpus.size(); ++i)
+		{
+			if (cpus[i] >= node_of_cpu.size()) node_of_cpu.resize(cpus[i] + 1, 0);
+			node_of_cpu[cpus[i]] = node;
+		}
+	}
+	
+	closedir(node_dir);
+	return ret_val;
+}
+
+int numa_nodes_of_cores(unsigned first_core, unsigned last_core, numa_node_mask_t *nodes)
+{
+	std::vector<unsigned> node_of_cpu;
+	int ret_val = read_numa_node_of_cpus(node_of_cpu);
+	if (ret_val != 0) return ret_val;
+	
+	numa_node_mask_clear(nodes);
+	for (unsigned core = first_core; core <= last_core; ++core)
+	{
+		numa_node_mask_set(nodes, core < node_of_cpu.size() ? node_of_cpu[core] : 0);
+	}
+	
+	if (numa_node_mask_count(nodes) == 0)
+	{
+		return RT_GOMP_NUMA_PLACEMENT_NO_NODES_ERROR;
+	}
+	return RT_GOMP_NUMA_PLACEMENT_SUCCESS;
+}
+
+int set_numa_memory_policy(int mode, const numa_node_mask_t *nodes)
+{
+	numa_node_mask_t policy_nodes = *nodes;
+	if (mode == MPOL_PREFERRED)
+	{
+		// Preferred takes a single node
+		numa_node_mask_clear(&policy_nodes);
+		for (unsigned node = 0; node < max_numa_nodes; ++node)
+		{
+			if (numa_node_mask_isset(nodes, node))
+			{
+				numa_node_mask_set(&policy_nodes, node);
+				break;
+			}
+		}
+	}
+	
+	// The kernel expects maxnode to be one more than the number of bits
+	long ret_val = syscall(SYS_set_mempolicy, mode, policy_nodes.bits, (unsigned long) max_numa_nodes + 1);
+	if (ret_val != 0)
+	{
+		return RT_GOMP_NUMA_PLACEMENT_SET_MEMPOLICY_ERROR;
+	}
+	return RT_GOMP_NUMA_PLACEMENT_SUCCESS;
+}
+
+int numa_resident_kb_per_node(std::vector<unsigned long> & kb_per_node, std::vector<unsigned long> & shared_kb_per_node)
+{
+	std::ifstream numa_maps("/proc/self/numa_maps");
+	if (!numa_maps.is_open())
+	{
+		return RT_GOMP_NUMA_PLACEMENT_NUMA_MAPS_ERROR;
+	}
+	
+	// Each line describes one mapping, with N<node>=<pages> fields giving the
+	// number of resident pages on each node and kernelpagesize_kB their size.
+	// POSIX shared memory is mapped from files under /dev/shm.
+	std::string line;
+	while (std::getline(numa_maps, line))
+	{
+		std::istringstream fields(line);
+		std::string field;
+		unsigned long page_kb = 4;
+		bool shared = false;
+		std::vector<std::pair<unsigned, unsigned long> > pages;
+		while (fields >> field)
+		{
+			unsigned node;
+			unsigned long count;
+			if (sscanf(field.c_str(), "N%u=%lu", &node, &count) == 2)
+			{
+				pages.push_back(std::make_pair(node, count));
+			}
+			else if (field.compare(0, 14, "file=/dev/shm/") == 0)
+			{
+				shared = true;
+			}
+			else
+			{
+				sscanf(field.c_str(), "kernelpagesize_kB=%lu", &page_kb);
+			}
+		}
+		
+		std::vector<unsigned long> & kb = shared ? shared_kb_per_node : kb_per_node;
+		for (size_t i = 0; i < pages.size(); ++i)
+		{
+			if (pages[i].first >= kb.size()) kb.resize(pages[i].first + 1, 0);
+			kb[pages[i].first] += pages[i].second * page_kb;
+		}
+	}
+	
+	return RT_GOMP_NUMA_PLACEMENT_SUCCESS;
+}
+
+std::string numa_node_mask_string(const numa_node_mask_t *nodes)
+{
+	std::ostringstream stream;
+	stream << "{";
+	bool first = true;
+	for (unsigned node = 0; node < max_numa_nodes; ++node)
+	{
+		if (numa_node_mask_isset(nodes, node))
+		{
+			stream << (first ? "" : ",") << node;
+			first = false;
+		}
+	}
+	stream << "}";
+	return stream.str();
+}
+
+void report_numa_placement(const char *task_name, const numa_node_mask_t *nodes)
+{
+	std::vector<unsigned long> kb_per_node, shared_kb_per_node;
+	if (numa_resident_kb_per_node(kb_per_node, shared_kb_per_node) != 0)
+	{
+		fprintf(stderr, "WARNING: Cannot read NUMA placement of task %s\n", task_name);
+		return;
+	}
+	
+	unsigned long total_kb = 0, remote_kb = 0;
+	std::ostringstream per_node;
+	for (unsigned node = 0; node < kb_per_node.size(); ++node)
+	{
+		if (kb_per_node[node] == 0) continue;
+		per_node << " " << node << ":" << kb_per_node[node];
+		total_kb += kb_per_node[node];
+		if (!numa_node_mask_isset(nodes, node)) remote_kb += kb_per_node[node];
+	}
+	
+	fprintf(stderr, "Resident kB per NUMA node for task %s:%s\n", task_name, per_node.str().c_str());
+	fprintf(stderr, "Remote memory for task %s: %lu / %lu kB (%.2f%%)\n", task_name, remote_kb, total_kb,
+	        total_kb > 0 ? 100.0 * remote_kb / total_kb : 0.0);
+	
+	unsigned long shared_kb = 0, shared_remote_kb = 0;
+	for (unsigned node = 0; node < shared_kb_per_node.size(); ++node)
+	{
+		shared_kb += shared_kb_per_node[node];
+		if (!numa_node_mask_isset(nodes, node)) shared_remote_kb += shared_kb_per_node[node];
+	}
+	if (shared_kb > 0)
+	{
+		fprintf(stderr, "Shared segments of task %s: %lu kB, %lu kB on other nodes, placed by the instance that created them\n",
+		        task_name, shared_kb, shared_remote_kb);
+	}
+}
@@ -0,0 +1,67 @@
+#ifndef RT_GOMP_NUMA_PLACEMENT_H
+#define RT_GOMP_NUMA_PLACEMENT_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// NUMA helpers used by task_manager to keep a task's memory on the nodes of
+// the cores it runs on. The node layout is read from /sys and the memory
+// policy is set with the set_mempolicy system call directly, so there is no
+// dependency on libnuma.
+
+enum rt_gomp_numa_placement_error_codes
+{
+	RT_GOMP_NUMA_PLACEMENT_SUCCESS,
+	RT_GOMP_NUMA_PLACEMENT_SYSFS_ERROR,
+	RT_GOMP_NUMA_PLACEMENT_NO_NODES_ERROR,
+	RT_GOMP_NUMA_PLACEMENT_SET_MEMPOLICY_ERROR,
+	RT_GOMP_NUMA_PLACEMENT_NUMA_MAPS_ERROR
+};
+
+const unsigned max_numa_nodes = 1024;
+
+// A set of NUMA nodes in the layout expected by set_mempolicy
+typedef struct
+{
+	unsigned long bits[max_numa_nodes / (8 * sizeof(unsigned long))];
+}
+numa_node_mask_t;
+
+void numa_node_mask_clear(numa_node_mask_t *mask);
+void numa_node_mask_set(numa_node_mask_t *mask, unsigned node);
+bool numa_node_mask_isset(const numa_node_mask_t *mask, unsigned node);
+unsigned numa_node_mask_count(const numa_node_mask_t *mask);
+
+// Parses a kernel cpu/node list such as "0-3,8,10-11". Returns false on a syntax error.
+bool parse_cpu_list(const std::string & list, std::vector<unsigned> & cpus);
+
+// Returns the NUMA node of each cpu in node_of_cpu, indexed by cpu number. Cpus
+// not listed under any node are given node 0. Systems without NUMA support in
+// the kernel are reported as a single node 0.
+int read_numa_node_of_cpus(std::vector<unsigned> & node_of_cpu);
+
+// Stores the set of nodes containing the cores first_core..last_core in nodes.
+int numa_nodes_of_cores(unsigned first_core, unsigned last_core, numa_node_mask_t *nodes);
+
+// Sets the memory policy of the calling thread. mode is MPOL_BIND or
+// MPOL_PREFERRED from <linux/mempolicy.h>; MPOL_PREFERRED uses the lowest
+// node in the mask. Threads created afterwards inherit the policy.
+int set_numa_memory_policy(int mode, const numa_node_mask_t *nodes);
+
+// Sums the resident memory of the calling process per NUMA node, in kilobytes,
+// using /proc/self/numa_maps. kb_per_node is resized to cover every node seen.
+// Memory in POSIX shared memory, such as shared segments (see shared_segment.h),
+// goes to shared_kb_per_node instead, resized the same way.
+int numa_resident_kb_per_node(std::vector<unsigned long> & kb_per_node, std::vector<unsigned long> & shared_kb_per_node);
+
+// Writes a one line description of a node set, e.g. "{0,1}"
+std::string numa_node_mask_string(const numa_node_mask_t *nodes);
+
+// Prints the resident memory of the calling process on each node and the fraction
+// of it that is outside of nodes, for the end of run report of a task. Shared
+// segments are placed by the instance that created them, whatever the nodes of
+// the others, so they are reported on their own and not counted as remote.
+void report_numa_placement(const char *task_name, const numa_node_mask_t *nodes);
+
+#endif /* RT_GOMP_NUMA_PLACEMENT_H */
@@ -0,0 +1,1820 @@
+#include "partition.h"
+#include "rta.h"
+#include "topology.h"
+#include "budget_reservation.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+#include <omp.h>
+
+const partition_option_t partition_options[] =
+{
+	{ "original", PARTITION_NEXT_FIT, 1.0, false, false, false, PARTITION_BOUND_ADMISSION },
+	{ "worstfit", PARTITION_WORST_FIT, 1.0, false, false, false, PARTITION_BOUND_ADMISSION },
+	{ "balance", PARTITION_NEXT_FIT, 1.0, true, false, false, PARTITION_BOUND_ADMISSION },
+	{ "balance_090", PARTITION_NEXT_FIT, 0.90, true, false, false, PARTITION_BOUND_ADMISSION },
+	{ "balance_095", PARTITION_NEXT_FIT, 0.95, true, false, false, PARTITION_BOUND_ADMISSION },
+	{ "threshold_090", PARTITION_NEXT_FIT, 0.90, false, false, false, PARTITION_BOUND_ADMISSION },
+	{ "original_rta", PARTITION_NEXT_FIT, 1.0, false, false, false, PARTITION_RTA_ADMISSION },
+	{ "worstfit_rta", PARTITION_WORST_FIT, 1.0, false, false, false, PARTITION_RTA_ADMISSION },
+	{ "balance_rta", PARTITION_NEXT_FIT, 1.0, true, false, false, PARTITION_RTA_ADMISSION },
+	{ "balance_090_rta", PARTITION_NEXT_FIT, 0.90, true, false, false, PARTITION_RTA_ADMISSION },
+	{ "balance_095_rta", PARTITION_NEXT_FIT, 0.95, true, false, false, PARTITION_RTA_ADMISSION },
+	{ "threshold_090_rta", PARTITION_NEXT_FIT, 0.90, false, false, false, PARTITION_RTA_ADMISSION },
+	{ "semi_federated_rta", PARTITION_NEXT_FIT, 1.0, false, true, false, PARTITION_RTA_ADMISSION },
+	{ "semi_worstfit_rta", PARTITION_WORST_FIT, 1.0, false, true, false, PARTITION_RTA_ADMISSION },
+	{ "semi_balance_rta", PARTITION_NEXT_FIT, 1.0, true, true, false, PARTITION_RTA_ADMISSION },
+	{ "split_rta", PARTITION_NEXT_FIT, 1.0, false, false, true, PARTITION_RTA_ADMISSION },
+	{ "split_worstfit_rta", PARTITION_WORST_FIT, 1.0, false, false, true, PARTITION_RTA_ADMISSION },
+	{ "optimal_rta", PARTITION_OPTIMAL_FIT, 1.0, false, false, false, PARTITION_RTA_ADMISSION }
+};
+
+const unsigned num_partition_options = sizeof(partition_options) / sizeof(partition_options[0]);
+
+const double partition_default_search_seconds = 1.0;
+
+const unsigned partition_max_search_tasks = 100;
+
+const partition_option_t *find_partition_option(const char *name)
+{
+	for (unsigned i = 0; i < num_partition_options; ++i)
+	{
+		if (strcmp(partition_options[i].name, name) == 0) return &partition_options[i];
+	}
+	return NULL;
+}
+
+int find_partition_objective(const char *name)
+{
+	if (strcmp(name, "cores") == 0) return PARTITION_FEWEST_CORES;
+	if (strcmp(name, "balance") == 0) return PARTITION_BEST_BALANCE;
+	if (strcmp(name, "slack") == 0) return PARTITION_MOST_SLACK;
+	return -1;
+}
+
+void partition_problem_prepare(partition_problem_t *problem)
+{
+	const std::vector<partition_task_t> & tasks = problem->tasks;
+	problem->by_util.resize(tasks.size());
+	for (unsigned i = 0; i < tasks.size(); ++i) problem->by_util[i] = i;
+	std::stable_sort(problem->by_util.begin(), problem->by_util.end(),
+		[&tasks](unsigned a, unsigned b) { return tasks[a].util > tasks[b].util; });
+
+	problem->by_deadline = problem->by_util;
+	std::stable_sort(problem->by_deadline.begin(), problem->by_deadline.end(),
+		[&tasks](unsigned a, unsigned b) { return tasks[a].deadline < tasks[b].deadline; });
+}
+
+// Light tasks on one core
+typedef struct
+{
+	unsigned num_tasks;
+	double util;
+	// Sum of C/D, the utilization the bound sees
+	double density;
+	// Scaled period of the first task, which has the shortest deadline
+	double min_period;
+	// In deadline order
+	std::vector<unsigned> tasks;
+	// Budget reservation of a semi-federated heavy task, 0 if none
+	int64_t budget;
+	int64_t budget_period;
+	// Parts of split tasks, which count in num_tasks and util but are not in
+	// tasks, and whether one of them is at the top priority
+	unsigned num_parts;
+	bool has_top_part;
+	// Only kept up to date with PARTITION_RTA_ADMISSION
+	rta_core_t rta;
+}
+core_state_t;
+
+// Priority of the parts of split tasks that end at their budget, above every
+// other light task
+static const int top_part_priority = 98;
+
+// Whether a core has neither light tasks nor a reservation
+static bool core_empty(const core_state_t & core)
+{
+	return core.num_tasks == 0 && core.budget == 0 && core.num_parts == 0;
+}
+
+// A core that a heavy task can give up to the light tasks, because it got more
+// cores than (C-L)/(T-L) by rounding up
+typedef struct
+{
+	unsigned core;
+	double remaining;
+	unsigned task;
+}
+possible_core_t;
+
+typedef struct
+{
+	const partition_problem_t *problem;
+	const partition_option_t *option;
+	// The tasks as analyzed: problem->tasks, or slowed_tasks once a task is
+	// slowed down for sharing physical cores
+	const std::vector<partition_task_t> *tasks;
+	std::vector<partition_task_t> slowed_tasks;
+	// Periods used by the utilization bound, scaled from the deadlines, indexed
+	// like the tasks
+	std::vector<double> scaled_period;
+	std::vector<core_state_t> cores;
+	std::vector<unsigned> light_cores;
+	std::vector<possible_core_t> possible;
+	// Bandwidth of the tasks in each memory domain
+	std::vector<double> domain_used;
+	// Shortest deadline of a light task, 0 if none, which bounds the budget
+	// period of a semi-federated task
+	int64_t min_light_deadline;
+	// Heavy tasks by utilization, and the cores their clusters hold whole
+	std::vector<unsigned> heavy_tasks;
+	std::vector<bool> heavy_cores;
+	partition_result_t *result;
+}
+partition_state_t;
+
+static partition_task_t slowed_task(const partition_task_t & task, double slowdown)
+{
+	partition_task_t slowed = task;
+	slowed.work = static_cast<int64_t>(ceil(task.work * slowdown));
+	slowed.span = static_cast<int64_t>(ceil(task.span * slowdown));
+	slowed.util = 1.0 * slowed.work / slowed.period;
+	return slowed;
+}
+
+static double core_speed(const partition_problem_t *problem, unsigned c)
+{
+	return problem->core_speed.empty() ? 1.0 : problem->core_speed[c];
+}
+
+// A task as it runs at the given core speed
+static partition_task_t at_speed(const partition_task_t & task, double speed)
+{
+	return speed == 1.0 ? task : slowed_task(task, 1 / speed);
+}
+
+// Time that work takes at the given speed, rounded up as by slowed_task
+static int64_t time_taken(int64_t work, double speed)
+{
+	return speed == 1.0 ? work : static_cast<int64_t>(ceil(work * (1 / speed)));
+}
+
+// Work that a core at the given speed gets done in time, rounded down
+static int64_t work_done(int64_t time, double speed)
+{
+	return speed == 1.0 ? time : static_cast<int64_t>(floor(time * speed));
+}
+
+// A task as it runs on core c
+static partition_task_t task_on_core(const partition_state_t *state, unsigned task, unsigned c)
+{
+	return at_speed((*state->tasks)[task], core_speed(state->problem, c));
+}
+
+// Whether the memory domain of core c has the bandwidth left for a task
+static bool domain_fits(const partition_state_t *state, unsigned c, double bandwidth)
+{
+	const partition_problem_t *problem = state->problem;
+	if (problem->core_domain.empty() || bandwidth == 0) return true;
+	const unsigned domain = problem->core_domain[c];
+	return state->domain_used[domain] + bandwidth <= problem->domain_bandwidth[domain];
+}
+
+// Adds bandwidth, which may be negative, to the memory domain of core c
+static void use_bandwidth(partition_state_t *state, unsigned c, double bandwidth)
+{
+	if (!state->problem->core_domain.empty()) state->domain_used[state->problem->core_domain[c]] += bandwidth;
+}
+
+// Whether a light task goes to the memory domain with the most bandwidth left
+// that has a core taking it (see spread_domains) rather than by the fit alone
+static bool spreads(const partition_state_t *state, unsigned task)
+{
+	return !state->problem->core_domain.empty() && (*state->tasks)[task].bandwidth > 0;
+}
+
+// Multiplies the work and span of the given tasks by the SMT slowdown
+static void slow_down(partition_state_t *state, const std::vector<unsigned> & tasks)
+{
+	const partition_problem_t *problem = state->problem;
+	if (problem->smt_slowdown == 1.0) return;
+	if (state->slowed_tasks.empty())
+	{
+		state->slowed_tasks = problem->tasks;
+		state->tasks = &state->slowed_tasks;
+	}
+	for (unsigned i = 0; i < tasks.size(); ++i)
+	{
+		state->slowed_tasks[tasks[i]] = slowed_task(problem->tasks[tasks[i]], problem->smt_slowdown);
+		state->result->placement[tasks[i]].slowdown = problem->smt_slowdown;
+	}
+}
+
+static double utilization_bound(double num_tasks, double period_ratio)
+{
+	return num_tasks * (pow(period_ratio, 1 / num_tasks) - 1) + 2 / period_ratio - 1;
+}
+
+static double density(const partition_task_t & task)
+{
+	return 1.0 * task.work / task.deadline;
+}
+
+// Tests whether task fits on core c at the given priority. With response time
+// analysis an admitted task is added to the core's analysis.
+static bool try_admit(partition_state_t *state, unsigned c, unsigned task, int priority)
+{
+	core_state_t & core = state->cores[c];
+	const partition_task_t t = task_on_core(state, task, c);
+	if (t.util + core.util >= state->option->threshold) return false;
+	if (!domain_fits(state, c, t.bandwidth)) return false;
+
+	if (state->option->admission == PARTITION_RTA_ADMISSION)
+	{
+		return rta_core_try_add(&core.rta, t.work, t.period, t.deadline, priority);
+	}
+	const double num_tasks = core.num_tasks + 1.0;
+	const double period_ratio = state->scaled_period[task] / core.min_period;
+	return density(t) + core.density <= utilization_bound(num_tasks, period_ratio);
+}
+
+// Places a light task on core c below the tasks already there. forced is set if
+// the task did not go through try_admit.
+static void place_light(partition_state_t *state, unsigned c, unsigned task, bool forced)
+{
+	core_state_t & core = state->cores[c];
+	const partition_task_t t = task_on_core(state, task, c);
+	if (core.num_tasks == 0) core.min_period = state->scaled_period[task];
+	core.num_tasks += 1;
+	core.util += t.util;
+	core.density += density(t);
+	core.tasks.push_back(task);
+	use_bandwidth(state, c, t.bandwidth);
+
+	partition_placement_t & placement = state->result->placement[task];
+	placement.first_core = c;
+	placement.last_core = c;
+	placement.priority = 98 - core.num_tasks;
+
+	if (forced && state->option->admission == PARTITION_RTA_ADMISSION)
+	{
+		rta_core_force_add(&core.rta, t.work, t.period, t.deadline, placement.priority);
+	}
+}
+
+// Largest work up to max_work of a part of a task at the top priority of a
+// core, with its work as its deadline, that leaves every task there meeting its
+// deadline, or 0. More work only delays the other tasks more.
+static int64_t max_top_part(const core_state_t & core, int64_t max_work, int64_t period)
+{
+	int64_t low = 0, high = max_work;
+	while (low < high)
+	{
+		const int64_t middle = low + (high - low + 1) / 2;
+		rta_core_t rta = core.rta;
+		if (rta_core_try_add(&rta, middle, period, middle, top_part_priority)) low = middle;
+		else high = middle - 1;
+	}
+	return low;
+}
+
+// Splits a light task that no core admits whole over the least utilized cores
+// (see partition_option_t::split). On each core the rest of the task either
+// fits whole as the last part below the tasks there, or as much of it as the
+// core takes becomes a top priority part, unless the core already has one; if
+// that is all of it, it is the last part too. Only cores whose memory domain
+// has the whole bandwidth of the task left take a part. Returns false, changing
+// nothing, if the cores run out first.
+static bool split_light(partition_state_t *state, unsigned task)
+{
+	const partition_task_t & t = (*state->tasks)[task];
+	std::vector<core_state_t> & cores = state->cores;
+	std::vector<unsigned> order = state->light_cores;
+	std::stable_sort(order.begin(), order.end(),
+		[&cores](unsigned a, unsigned b) { return cores[a].util < cores[b].util; });
+
+	// The parts as planned, with their times on their cores and the analysis
+	// of their cores including them. Work is left to do at speed 1.
+	std::vector<unsigned> part_cores;
+	std::vector<int64_t> part_time, part_work;
+	std::vector<int> part_priority;
+	std::vector<rta_core_t> part_rta;
+	int64_t work = t.work, deadline = t.deadline;
+	bool complete = false;
+	for (unsigned k = 0; k < order.size() && !complete; ++k)
+	{
+		const core_state_t & core = cores[order[k]];
+		if (core.budget > 0 || !domain_fits(state, order[k], t.bandwidth)) continue;
+		const double speed = core_speed(state->problem, order[k]);
+		const int64_t time = time_taken(work, speed);
+		rta_core_t rta = core.rta;
+		const int priority = 98 - (core.num_tasks + 1);
+		if (rta_core_try_add(&rta, time, t.period, deadline, priority))
+		{
+			part_priority.push_back(priority);
+			part_time.push_back(time);
+			part_work.push_back(work);
+			complete = true;
+		}
+		else
+		{
+			if (core.has_top_part) continue;
+			const int64_t part = max_top_part(core, std::min(time, deadline - 1), t.period);
+			if (part == 0) continue;
+			complete = part == time;
+			rta_core_force_add(&rta, part, t.period, complete ? deadline : part, top_part_priority);
+			part_priority.push_back(top_part_priority);
+			part_time.push_back(part);
+			part_work.push_back(std::min(work, work_done(part, speed)));
+			work -= work_done(part, speed);
+			deadline -= part;
+		}
+		part_cores.push_back(order[k]);
+		part_rta.push_back(rta);
+	}
+	if (!complete) return false;
+
+	partition_placement_t & placement = state->result->placement[task];
+	for (unsigned k = 0; k < part_cores.size(); ++k)
+	{
+		core_state_t & core = cores[part_cores[k]];
+		core.rta = part_rta[k];
+		core.util += 1.0 * part_time[k] / t.period;
+		core.density += 1.0 * part_time[k] / t.deadline;
+		core.num_parts += 1;
+		// Each part moves its share of the task's memory traffic
+		use_bandwidth(state, part_cores[k], t.bandwidth * part_work[k] / t.work);
+		if (part_priority[k] == top_part_priority) core.has_top_part = true;
+		else core.num_tasks += 1;
+		if (k == 0)
+		{
+			placement.first_core = part_cores[k];
+			placement.last_core = part_cores[k];
+			placement.priority = part_priority[k];
+		}
+		else
+		{
+			partition_segment_t segment = { part_time[k - 1], part_cores[k], part_priority[k] };
+			placement.segments.push_back(segment);
+		}
+	}
+	return true;
+}
+
+// Places a task that no core admits: split over several cores if the option
+// splits tasks, or else on the least utilized core if it fits by utilization,
+// otherwise on a core taken from a heavy task. Returns false if there is no
+// such core.
+static bool place_overflow(partition_state_t *state, unsigned task, unsigned min_core)
+{
+	if (state->option->split && split_light(state, task)) return true;
+	state->result->sched = PARTITION_MAY_TRY;
+	if (state->cores[min_core].util + task_on_core(state, task, min_core).util < 1)
+	{
+		place_light(state, min_core, task, true);
+		return true;
+	}
+
+	if (state->possible.empty()) return false;
+	const possible_core_t possible = state->possible.front();
+	state->possible.erase(state->possible.begin());
+	state->light_cores.push_back(possible.core);
+	place_light(state, possible.core, task, true);
+	state->result->placement[possible.task].last_core = possible.core - 1;
+	return true;
+}
+
+// The memory domains in which a light task that uses memory bandwidth may go,
+// those with its bandwidth left, by most bandwidth left, ties by index. There
+// are few domains, so they are sorted again for each task.
+static void spread_domains(const partition_state_t *state, unsigned task, std::vector<unsigned> & domains)
+{
+	const std::vector<double> & used = state->domain_used;
+	const std::vector<double> & capacity = state->problem->domain_bandwidth;
+	domains.clear();
+	for (unsigned d = 0; d < capacity.size(); ++d)
+	{
+		if (used[d] + (*state->tasks)[task].bandwidth <= capacity[d]) domains.push_back(d);
+	}
+	std::stable_sort(domains.begin(), domains.end(),
+		[&used, &capacity](unsigned a, unsigned b) { return capacity[a] - used[a] > capacity[b] - used[b]; });
+}
+
+// A tournament tree over positions 0 to n-1 that finds in O(log n) the
+// largest key in a range and the first position from a given one whose key is
+// at least a bound, so that the fits pass over the cores that cannot take a
+// task without looking at each of them
+typedef struct
+{
+	// A power of 2, at least n
+	unsigned size;
+	// node[1] is the root, each node holds the largest key below it, and the
+	// key of position k is node[size + k]
+	std::vector<double> node;
+}
+core_tree_t;
+
+static void tree_build(core_tree_t *tree, const std::vector<double> & keys)
+{
+	tree->size = 1;
+	while (tree->size < keys.size()) tree->size *= 2;
+	tree->node.assign(2 * tree->size, -HUGE_VAL);
+	std::copy(keys.begin(), keys.end(), tree->node.begin() + tree->size);
+	for (unsigned i = tree->size - 1; i >= 1; --i) tree->node[i] = std::max(tree->node[2 * i], tree->node[2 * i + 1]);
+}
+
+static void tree_set(core_tree_t *tree, unsigned position, double key)
+{
+	unsigned i = tree->size + position;
+	tree->node[i] = key;
+	for (i /= 2; i >= 1; i /= 2) tree->node[i] = std::max(tree->node[2 * i], tree->node[2 * i + 1]);
+}
+
+// Largest key in [from, to) under node i, which covers [low, high)
+static double tree_max(const core_tree_t *tree, unsigned from, unsigned to, unsigned i, unsigned low, unsigned high)
+{
+	if (high <= from || to <= low) return -HUGE_VAL;
+	if (from <= low && high <= to) return tree->node[i];
+	const unsigned middle = (low + high) / 2;
+	return std::max(tree_max(tree, from, to, 2 * i, low, middle), tree_max(tree, from, to, 2 * i + 1, middle, high));
+}
+
+// First position in [from, to) under node i, which covers [low, high), whose
+// key is at least bound, or -1
+static int tree_find(const core_tree_t *tree, unsigned from, unsigned to, double bound, unsigned i, unsigned low, unsigned high)
+{
+	if (high <= from || to <= low || tree->node[i] < bound) return -1;
+	if (high - low == 1) return low;
+	const unsigned middle = (low + high) / 2;
+	const int found = tree_find(tree, from, to, bound, 2 * i, low, middle);
+	return found >= 0 ? found : tree_find(tree, from, to, bound, 2 * i + 1, middle, high);
+}
+
+static double tree_max(const core_tree_t *tree, unsigned from, unsigned to)
+{
+	return tree_max(tree, from, to, 1, 0, tree->size);
+}
+
+static int tree_find(const core_tree_t *tree, unsigned from, unsigned to, double bound)
+{
+	return tree_find(tree, from, to, bound, 1, 0, tree->size);
+}
+
+// Utilization at speed 1 that core c may still take, HUGE_VAL if it is empty,
+// since an empty core takes any light task. A task with more is sure to fail
+// the threshold test of try_admit, up to rounding.
+static double core_room(const partition_state_t *state, unsigned c)
+{
+	const core_state_t & core = state->cores[c];
+	return core_empty(core) ? HUGE_VAL : (state->option->threshold - core.util) * core_speed(state->problem, c);
+}
+
+static void build_room_tree(const partition_state_t *state, core_tree_t *tree)
+{
+	std::vector<double> room(state->light_cores.size());
+	for (unsigned k = 0; k < room.size(); ++k) room[k] = core_room(state, state->light_cores[k]);
+	tree_build(tree, room);
+}
+
+// The light cores of each memory domain, so that a task that uses memory
+// bandwidth looks only at the cores of the domains it may go to
+typedef struct
+{
+	// Positions in light_cores of the cores of each domain, in order, with a
+	// tree of the room left on each
+	std::vector<std::vector<unsigned> > positions;
+	std::vector<core_tree_t> room;
+	// For each position in light_cores, its index in its domain's positions
+	std::vector<unsigned> index;
+}
+domain_rooms_t;
+
+static void build_domain_rooms(const partition_state_t *state, domain_rooms_t *rooms)
+{
+	const partition_problem_t *problem = state->problem;
+	rooms->positions.assign(problem->domain_bandwidth.size(), std::vector<unsigned>());
+	rooms->room.resize(problem->domain_bandwidth.size());
+	rooms->index.resize(state->light_cores.size());
+	if (problem->core_domain.empty()) return;
+	std::vector<std::vector<double> > room(rooms->positions.size());
+	for (unsigned k = 0; k < state->light_cores.size(); ++k)
+	{
+		const unsigned d = problem->core_domain[state->light_cores[k]];
+		rooms->index[k] = rooms->positions[d].size();
+		rooms->positions[d].push_back(k);
+		room[d].push_back(core_room(state, state->light_cores[k]));
+	}
+	for (unsigned d = 0; d < room.size(); ++d) tree_build(&rooms->room[d], room[d]);
+}
+
+// Tries the cores at positions[j] of light_cores, or at j itself without
+// positions, for j from start to count, then from 0, passing over those with
+// less room in the tree than the task needs. The task goes to the first that
+// is empty or admits it. Returns that j, or -1 if there is none.
+static int ring_fit(partition_state_t *state, unsigned task, const core_tree_t *room, const std::vector<unsigned> *positions,
+	unsigned count, unsigned start)
+{
+	const double needed = (*state->tasks)[task].util - 1e-9;
+	int j = tree_find(room, start, count, needed);
+	bool wrapped = false;
+	while (true)
+	{
+		if (j < 0 && !wrapped)
+		{
+			wrapped = true;
+			j = tree_find(room, 0, start, needed);
+		}
+		if (j < 0) return -1;
+		const unsigned c = state->light_cores[positions == NULL ? j : (*positions)[j]];
+		core_state_t & core = state->cores[c];
+		if (core_empty(core))
+		{
+			place_light(state, c, task, true);
+			return j;
+		}
+		if (try_admit(state, c, task, 98 - (core.num_tasks + 1)))
+		{
+			place_light(state, c, task, false);
+			return j;
+		}
+		j = tree_find(room, j + 1, wrapped ? start : count, needed);
+	}
+}
+
+// original(): a ring of cores where each task starts at the core that took the
+// previous one. The cores without room for the task are passed over with a
+// tree of the room left on each core, as try_admit would turn them down. A
+// task that uses memory bandwidth goes round the ring of the cores of each
+// domain it may go to in turn, with a tree for each domain.
+static bool next_fit(partition_state_t *state, const std::vector<unsigned> & light_tasks)
+{
+	unsigned current = 0;
+	core_tree_t room;
+	domain_rooms_t rooms;
+	std::vector<unsigned> domains;
+	build_room_tree(state, &room);
+	build_domain_rooms(state, &rooms);
+	for (unsigned i = 0; i < light_tasks.size(); ++i)
+	{
+		const unsigned task = light_tasks[i];
+		const unsigned num_light_cores = state->light_cores.size();
+		bool placed = false;
+
+		if (spreads(state, task))
+		{
+			spread_domains(state, task, domains);
+			for (unsigned k = 0; k < domains.size() && !placed; ++k)
+			{
+				const std::vector<unsigned> & positions = rooms.positions[domains[k]];
+				const unsigned start = std::lower_bound(positions.begin(), positions.end(), current) - positions.begin();
+				const int j = ring_fit(state, task, &rooms.room[domains[k]], &positions, positions.size(), start);
+				if (j >= 0) current = positions[j];
+				placed = j >= 0;
+			}
+		}
+		else
+		{
+			const int k = ring_fit(state, task, &room, NULL, num_light_cores, current);
+			if (k >= 0) current = k;
+			placed = k >= 0;
+		}
+
+		if (placed)
+		{
+			const double current_room = core_room(state, state->light_cores[current]);
+			tree_set(&room, current, current_room);
+			if (!state->problem->core_domain.empty())
+			{
+				const unsigned d = state->problem->core_domain[state->light_cores[current]];
+				tree_set(&rooms.room[d], rooms.index[current], current_room);
+			}
+			continue;
+		}
+
+		// Every core was tried, so the overflow goes to the least utilized,
+		// the first of them from current on
+		unsigned min_core = state->light_cores[current];
+		for (unsigned count = 0; count < num_light_cores; ++count)
+		{
+			const unsigned c = state->light_cores[(current + count) % num_light_cores];
+			if (state->cores[c].util < state->cores[min_core].util) min_core = c;
+		}
+		if (!place_overflow(state, task, min_core)) return false;
+		// An overflow may change several cores and add one
+		build_room_tree(state, &room);
+		build_domain_rooms(state, &rooms);
+	}
+	return true;
+}
+
+// Light cores by utilization, ties in light_cores order, as pairs of the
+// utilization and the position in light_cores
+typedef std::set<std::pair<double, unsigned> > core_order_t;
+
+// Sorts the light cores by utilization, and those of each memory domain on
+// their own in domain_order, with the top speed of each domain's cores
+static void sort_by_util(const partition_state_t *state, core_order_t & order, std::vector<core_order_t> & domain_order,
+	std::vector<double> & domain_speed)
+{
+	const partition_problem_t *problem = state->problem;
+	order.clear();
+	domain_order.assign(problem->domain_bandwidth.size(), core_order_t());
+	domain_speed.assign(problem->domain_bandwidth.size(), 0.0);
+	for (unsigned k = 0; k < state->light_cores.size(); ++k)
+	{
+		const unsigned c = state->light_cores[k];
+		order.insert(std::make_pair(state->cores[c].util, k));
+		if (problem->core_domain.empty()) continue;
+		domain_order[problem->core_domain[c]].insert(std::make_pair(state->cores[c].util, k));
+		domain_speed[problem->core_domain[c]] = std::max(domain_speed[problem->core_domain[c]], core_speed(problem, c));
+	}
+}
+
+// Each task goes to the least utilized core that admits it, and a task that
+// uses memory bandwidth to the least utilized one of the first domain it may
+// go to that has a core admitting it. Only the core that took a task changes,
+// so the orders are kept by moving that core alone.
+static bool worst_fit(partition_state_t *state, const std::vector<unsigned> & light_tasks)
+{
+	const std::vector<core_state_t> & cores = state->cores;
+	const std::vector<unsigned> & light_cores = state->light_cores;
+	const std::vector<unsigned> & core_domain = state->problem->core_domain;
+	core_order_t order;
+	std::vector<core_order_t> domain_order;
+	std::vector<double> domain_speed;
+	std::vector<unsigned> domains;
+	sort_by_util(state, order, domain_order, domain_speed);
+
+	for (unsigned i = 0; i < light_tasks.size(); ++i)
+	{
+		const unsigned task = light_tasks[i];
+		core_order_t::iterator taken = order.end();
+		const bool spread = spreads(state, task);
+		if (spread) spread_domains(state, task, domains);
+		for (unsigned k = 0; spread && k < domains.size() && taken == order.end(); ++k)
+		{
+			const unsigned d = domains[k];
+			for (core_order_t::iterator it = domain_order[d].begin(); it != domain_order[d].end(); ++it)
+			{
+				const unsigned c = light_cores[it->second];
+				if (core_empty(cores[c]))
+				{
+					place_light(state, c, task, true);
+					taken = order.find(*it);
+					break;
+				}
+				// The remaining cores of the domain are at least as utilized
+				// and no faster, so they have no more room (see core_room)
+				if ((state->option->threshold - cores[c].util) * domain_speed[d] < (*state->tasks)[task].util - 1e-9) break;
+				if (try_admit(state, c, task, 98 - (cores[c].num_tasks + 1)))
+				{
+					place_light(state, c, task, false);
+					taken = order.find(*it);
+					break;
+				}
+			}
+		}
+		for (core_order_t::iterator it = order.begin(); it != order.end() && !spread; ++it)
+		{
+			const unsigned c = light_cores[it->second];
+			if (core_empty(cores[c]))
+			{
+				place_light(state, c, task, true);
+				taken = it;
+				break;
+			}
+			// The remaining cores are at least as utilized
+			if ((*state->tasks)[task].util + cores[c].util >= state->option->threshold) break;
+			if (try_admit(state, c, task, 98 - (cores[c].num_tasks + 1)))
+			{
+				place_light(state, c, task, false);
+				taken = it;
+				break;
+			}
+		}
+
+		if (taken == order.end())
+		{
+			const unsigned num_light_cores = light_cores.size();
+			if (!place_overflow(state, task, light_cores[order.begin()->second])) return false;
+			if (light_cores.size() != num_light_cores || state->option->split)
+			{
+				sort_by_util(state, order, domain_order, domain_speed);
+				continue;
+			}
+			taken = order.begin();
+		}
+
+		const std::pair<double, unsigned> moved = *taken;
+		const unsigned k = moved.second;
+		order.erase(taken);
+		order.insert(std::make_pair(cores[light_cores[k]].util, k));
+		if (core_domain.empty()) continue;
+		domain_order[core_domain[light_cores[k]]].erase(moved);
+		domain_order[core_domain[light_cores[k]]].insert(std::make_pair(cores[light_cores[k]].util, k));
+	}
+	return true;
+}
+
+// Hash of the set of tasks on a core, as bits of the task indices
+struct task_set_hash
+{
+	size_t operator()(const std::vector<uint64_t> & bits) const
+	{
+		uint64_t hash = 14695981039346656037ULL;
+		for (unsigned i = 0; i < bits.size(); ++i) hash = (hash ^ bits[i]) * 1099511628211ULL;
+		return hash;
+	}
+};
+
+// Nodes between looks at the clock, and sets of tasks remembered before the
+// memory is cleared
+static const unsigned long search_check_interval = 1024;
+static const size_t max_remembered_sets = 1 << 20;
+
+// A branch and bound search of optimal_fit. Light cores are referred to by
+// their position in state->light_cores.
+typedef struct
+{
+	partition_state_t *state;
+	// Light tasks by utilization, high to low, and by deadline, as they are
+	// given priorities on each core
+	std::vector<unsigned> by_util;
+	const std::vector<unsigned> *by_deadline;
+	// Tasks on each light core, as bits of the task indices, with their number
+	// and utilization at the core's speed
+	std::vector<std::vector<uint64_t> > core_tasks;
+	std::vector<unsigned> core_count;
+	std::vector<double> core_util;
+	// Light cores with the same speed class run tasks alike, and empty cores
+	// with the same empty class are interchangeable
+	std::vector<unsigned> speed_class;
+	std::vector<unsigned> empty_class;
+	unsigned num_empty_classes;
+	double max_speed;
+	// Light core of each task, and the best packing so far
+	std::vector<unsigned> core_of;
+	std::vector<unsigned> best_core_of;
+	unsigned cores_open;
+	unsigned best_cores;
+	// No packing can use fewer cores, so the search ends when it finds one
+	unsigned min_cores;
+	// Utilization of the tasks not yet placed, and capacity left on the open
+	// cores, both at speed 1
+	double remaining;
+	double spare;
+	// Whether each set of tasks, with its speed class as a last word, is
+	// schedulable on a core
+	std::unordered_map<std::vector<uint64_t>, bool, task_set_hash> schedulable;
+	std::vector<uint64_t> key;
+	double end_time;
+	unsigned long nodes;
+	bool timed_out;
+}
+search_state_t;
+
+// Whether the tasks of a set are schedulable on light core k at deadline
+// monotonic priorities, which are optimal on one core without reservations
+static bool set_schedulable(search_state_t *search, unsigned k, const std::vector<uint64_t> & bits)
+{
+	const std::vector<unsigned> & by_deadline = *search->by_deadline;
+	rta_core_t rta;
+	rta.schedulable = true;
+	for (unsigned i = 0; i < by_deadline.size(); ++i)
+	{
+		const unsigned task = by_deadline[i];
+		if (!(bits[task / 64] >> (task % 64) & 1)) continue;
+		const partition_task_t t = task_on_core(search->state, task, search->state->light_cores[k]);
+		if (!rta_core_try_add(&rta, t.work, t.period, t.deadline, by_deadline.size() - i)) return false;
+	}
+	return true;
+}
+
+// Whether a task fits on light core k with the tasks there
+static bool search_fits(search_state_t *search, unsigned k, unsigned task)
+{
+	partition_state_t *state = search->state;
+	const unsigned c = state->light_cores[k];
+	const partition_task_t t = task_on_core(state, task, c);
+	if (t.util + search->core_util[k] >= state->option->threshold) return false;
+	if (!domain_fits(state, c, t.bandwidth)) return false;
+
+	std::vector<uint64_t> & key = search->key;
+	std::copy(search->core_tasks[k].begin(), search->core_tasks[k].end(), key.begin());
+	key[task / 64] |= 1ULL << (task % 64);
+	key.back() = search->speed_class[k];
+	std::unordered_map<std::vector<uint64_t>, bool, task_set_hash>::const_iterator found = search->schedulable.find(key);
+	if (found != search->schedulable.end()) return found->second;
+
+	const bool schedulable = set_schedulable(search, k, key);
+	if (search->schedulable.size() >= max_remembered_sets) search->schedulable.clear();
+	search->schedulable[key] = schedulable;
+	return schedulable;
+}
+
+// Moves a task onto light core k, or off it with sign -1
+static void search_move(search_state_t *search, unsigned k, unsigned task, int sign)
+{
+	partition_state_t *state = search->state;
+	const unsigned c = state->light_cores[k];
+	const partition_task_t t = task_on_core(state, task, c);
+	const double speed = core_speed(state->problem, c);
+	if (sign > 0 && search->core_count[k] == 0)
+	{
+		search->cores_open += 1;
+		search->spare += speed;
+	}
+	search->core_tasks[k][task / 64] ^= 1ULL << (task % 64);
+	search->core_count[k] += sign;
+	search->core_util[k] += sign * t.util;
+	search->spare -= sign * t.util * speed;
+	search->remaining -= sign * (*state->tasks)[task].util;
+	use_bandwidth(state, c, sign * t.bandwidth);
+	search->core_of[task] = k;
+	// Sums that go back to empty cores are reset, so that rounding does not add up
+	if (sign < 0 && search->core_count[k] == 0)
+	{
+		search->cores_open -= 1;
+		search->spare -= speed;
+		search->core_util[k] = 0;
+	}
+}
+
+// Places the light tasks from position i of by_util on in every way that may
+// use fewer cores than the best packing so far
+static void search_packings(search_state_t *search, unsigned i)
+{
+	if (search->timed_out || search->best_cores <= search->min_cores) return;
+	if (++search->nodes % search_check_interval == 0 && search->end_time > 0 && omp_get_wtime() > search->end_time)
+	{
+		search->timed_out = true;
+		return;
+	}
+	if (i == search->by_util.size())
+	{
+		search->best_cores = search->cores_open;
+		search->best_core_of = search->core_of;
+		return;
+	}
+
+	// Utilization that does not fit on the open cores needs new ones, at best
+	// as fast as the fastest core
+	const double excess = search->remaining - search->spare;
+	const unsigned new_cores = excess > 1e-9 ? static_cast<unsigned>(ceil(excess / search->max_speed - 1e-9)) : 0;
+	if (search->cores_open + new_cores >= search->best_cores) return;
+
+	const unsigned task = search->by_util[i];
+	const unsigned num_light_cores = search->state->light_cores.size();
+	std::vector<bool> tried(search->num_empty_classes, false);
+	for (unsigned k = 0; k < num_light_cores; ++k)
+	{
+		if (search->core_count[k] == 0)
+		{
+			if (tried[search->empty_class[k]] || search->cores_open + 1 >= search->best_cores) continue;
+			tried[search->empty_class[k]] = true;
+		}
+		if (!search_fits(search, k, task)) continue;
+		search_move(search, k, task, 1);
+		search_packings(search, i + 1);
+		search_move(search, k, task, -1);
+	}
+}
+
+// Packs the light tasks by next fit or worst fit, whichever admits every task
+// onto fewer light cores, on a copy of the state. Returns the number of light
+// cores used, with the position in state->light_cores of each task's core in
+// core_of, or one more than there are light cores if neither does.
+static unsigned heuristic_packing(const partition_state_t *state, const std::vector<unsigned> & light_tasks, std::vector<unsigned> & core_of)
+{
+	const std::vector<unsigned> & light_cores = state->light_cores;
+	std::vector<int> position(state->problem->num_cores, -1);
+	for (unsigned k = 0; k < light_cores.size(); ++k) position[light_cores[k]] = k;
+
+	unsigned best_cores = light_cores.size() + 1;
+	for (unsigned f = 0; f < 2; ++f)
+	{
+		partition_result_t result = *state->result;
+		partition_state_t trial = *state;
+		trial.result = &result;
+		if (state->tasks == &state->slowed_tasks) trial.tasks = &trial.slowed_tasks;
+		// A task that no core admits makes the partition only worth a try
+		if (!(f == 0 ? next_fit(&trial, light_tasks) : worst_fit(&trial, light_tasks)) || result.sched != state->result->sched) continue;
+
+		unsigned cores_used = 0;
+		for (unsigned k = 0; k < light_cores.size(); ++k)
+		{
+			if (!trial.cores[light_cores[k]].tasks.empty()) cores_used += 1;
+		}
+		if (cores_used >= best_cores) continue;
+		best_cores = cores_used;
+		core_of.assign(state->tasks->size(), 0);
+		for (unsigned i = 0; i < light_tasks.size(); ++i) core_of[light_tasks[i]] = position[result.placement[light_tasks[i]].first_core];
+	}
+	return best_cores;
+}
+
+// Packs the light tasks onto the fewest cores by branch and bound (see
+// PARTITION_OPTIMAL_FIT), starting from the packing of heuristic_packing, or
+// by worst fit if neither finds a packing
+static bool optimal_fit(partition_state_t *state, const std::vector<unsigned> & light_tasks)
+{
+	const partition_problem_t *problem = state->problem;
+	const std::vector<unsigned> & light_cores = state->light_cores;
+	search_state_t search;
+	search.state = state;
+	search.by_deadline = &light_tasks;
+	search.by_util = light_tasks;
+	const std::vector<partition_task_t> & tasks = *state->tasks;
+	std::stable_sort(search.by_util.begin(), search.by_util.end(),
+		[&tasks](unsigned a, unsigned b) { return tasks[a].util > tasks[b].util; });
+
+	const unsigned num_words = (tasks.size() + 63) / 64;
+	search.core_tasks.assign(light_cores.size(), std::vector<uint64_t>(num_words, 0));
+	search.core_count.assign(light_cores.size(), 0);
+	search.core_util.assign(light_cores.size(), 0.0);
+	search.key.resize(num_words + 1);
+	std::vector<double> speeds;
+	std::vector<std::pair<double, unsigned> > empty_kinds;
+	search.max_speed = 0;
+	for (unsigned k = 0; k < light_cores.size(); ++k)
+	{
+		const double speed = core_speed(problem, light_cores[k]);
+		const unsigned domain = problem->core_domain.empty() ? 0 : problem->core_domain[light_cores[k]];
+		search.speed_class.push_back(std::find(speeds.begin(), speeds.end(), speed) - speeds.begin());
+		if (search.speed_class.back() == speeds.size()) speeds.push_back(speed);
+		const std::pair<double, unsigned> kind(speed, domain);
+		search.empty_class.push_back(std::find(empty_kinds.begin(), empty_kinds.end(), kind) - empty_kinds.begin());
+		if (search.empty_class.back() == empty_kinds.size()) empty_kinds.push_back(kind);
+		search.max_speed = std::max(search.max_speed, speed);
+	}
+	search.num_empty_classes = empty_kinds.size();
+
+	search.core_of.assign(tasks.size(), 0);
+	search.cores_open = 0;
+	search.best_cores = heuristic_packing(state, light_tasks, search.best_core_of);
+	search.remaining = 0;
+	for (unsigned i = 0; i < light_tasks.size(); ++i) search.remaining += tasks[light_tasks[i]].util;
+	search.min_cores = std::max(static_cast<unsigned>(ceil(search.remaining / search.max_speed - 1e-9)), 1u);
+	search.spare = 0;
+	search.end_time = problem->search_seconds > 0 ? omp_get_wtime() + problem->search_seconds : 0;
+	search.nodes = 0;
+	search.timed_out = false;
+	search_packings(&search, 0);
+	state->result->search_timed_out = search.timed_out;
+
+	if (search.best_cores > light_cores.size()) return worst_fit(state, light_tasks);
+	for (unsigned i = 0; i < light_tasks.size(); ++i)
+	{
+		const unsigned task = light_tasks[i];
+		const unsigned c = light_cores[search.best_core_of[task]];
+		const bool admitted = try_admit(state, c, task, 98 - (state->cores[c].num_tasks + 1));
+		place_light(state, c, task, !admitted);
+	}
+	return true;
+}
+
+// Tests whether a task moved off a core with utilization util_max fits on the
+// non-empty core c without bringing it to util_max
+static bool can_move(const partition_state_t *state, unsigned c, unsigned task, double util_max)
+{
+	const core_state_t & core = state->cores[c];
+	if (core.util + task_on_core(state, task, c).util >= util_max) return false;
+
+	// loadbalance() tests the task ahead of tasks with the same deadline
+	std::vector<unsigned> merged = core.tasks;
+	const std::vector<double> & scaled_period = state->scaled_period;
+	std::vector<unsigned>::iterator position = std::lower_bound(merged.begin(), merged.end(), task,
+		[&scaled_period](unsigned a, unsigned b) { return scaled_period[a] < scaled_period[b]; });
+	const unsigned index = position - merged.begin();
+	merged.insert(position, task);
+
+	if (state->option->admission == PARTITION_RTA_ADMISSION)
+	{
+		rta_core_t rta;
+		rta.schedulable = true;
+		if (core.budget > 0) rta_core_add_reservation(&rta, core.budget, core.budget_period);
+		for (unsigned k = 0; k < merged.size(); ++k)
+		{
+			const partition_task_t t = task_on_core(state, merged[k], c);
+			if (!rta_core_try_add(&rta, t.work, t.period, t.deadline, -static_cast<int>(k))) return false;
+		}
+		return true;
+	}
+
+	// Every prefix of the deadline monotonic order that contains the task must pass the bound
+	const double min_period = std::min(core.min_period, scaled_period[task]);
+	double sum_density = 0;
+	for (unsigned k = 0; k < merged.size(); ++k)
+	{
+		sum_density += density(task_on_core(state, merged[k], c));
+		if (k >= index && sum_density > utilization_bound(k + 1.0, scaled_period[merged[k]] / min_period)) return false;
+	}
+	return true;
+}
+
+// loadbalance(): moves tasks from the most utilized shared core to the least
+// utilized of the cores that were left empty, while that lowers the maximum.
+// Trees of the utilization of the shared cores and of minus that of the
+// others find each of them, the first in order of those alike.
+static void load_balance(partition_state_t *state)
+{
+	std::vector<unsigned> available, used;
+	for (unsigned k = 0; k < state->light_cores.size(); ++k)
+	{
+		const unsigned c = state->light_cores[k];
+		(core_empty(state->cores[c]) ? available : used).push_back(c);
+	}
+	if (available.empty()) return;
+
+	const std::vector<partition_task_t> & tasks = *state->tasks;
+	std::vector<core_state_t> & cores = state->cores;
+	// Only shared cores with more than one task give up tasks
+	auto shared_key = [&cores](unsigned c) { return cores[c].num_tasks > 1 ? cores[c].util : 0.0; };
+	std::vector<double> keys(used.size());
+	for (unsigned k = 0; k < used.size(); ++k) keys[k] = shared_key(used[k]);
+	core_tree_t shared, balanced;
+	tree_build(&shared, keys);
+	keys.resize(available.size());
+	for (unsigned k = 0; k < available.size(); ++k) keys[k] = -cores[available[k]].util;
+	tree_build(&balanced, keys);
+	while (true)
+	{
+		const double util_max = used.empty() ? 0 : tree_max(&shared, 0, used.size());
+		if (util_max <= 0) break;
+		const unsigned max_position = tree_find(&shared, 0, used.size(), util_max);
+		const unsigned core_max = used[max_position];
+
+		const unsigned min_position = tree_find(&balanced, 0, available.size(), tree_max(&balanced, 0, available.size()));
+		const unsigned core_min = available[min_position];
+		if (cores[core_min].util >= util_max) break;
+
+		std::vector<unsigned> candidates = cores[core_max].tasks;
+		std::stable_sort(candidates.begin(), candidates.end(),
+			[&tasks](unsigned a, unsigned b) { return tasks[a].util > tasks[b].util; });
+
+		bool moved = false;
+		for (unsigned k = 0; k < candidates.size() && !moved; ++k)
+		{
+			const unsigned task = candidates[k];
+			const partition_problem_t *problem = state->problem;
+			const bool other_domain = !problem->core_domain.empty() && problem->core_domain[core_min] != problem->core_domain[core_max];
+			if (other_domain && !domain_fits(state, core_min, tasks[task].bandwidth)) continue;
+			// As in loadbalance(), every task tried lowers the core's shortest period for the bound
+			if (cores[core_min].num_tasks > 0) cores[core_min].min_period = std::min(cores[core_min].min_period, state->scaled_period[task]);
+			if (cores[core_min].num_tasks > 0 && !can_move(state, core_min, task, util_max)) continue;
+
+			core_state_t & from = cores[core_max];
+			from.tasks.erase(std::find(from.tasks.begin(), from.tasks.end(), task));
+			from.num_tasks -= 1;
+			from.util -= task_on_core(state, task, core_max).util;
+			from.density -= density(task_on_core(state, task, core_max));
+			use_bandwidth(state, core_max, -tasks[task].bandwidth);
+
+			core_state_t & to = cores[core_min];
+			const std::vector<double> & scaled_period = state->scaled_period;
+			to.tasks.insert(std::upper_bound(to.tasks.begin(), to.tasks.end(), task,
+				[&scaled_period](unsigned a, unsigned b) { return scaled_period[a] < scaled_period[b]; }), task);
+			to.min_period = to.num_tasks == 0 ? scaled_period[task] : std::min(to.min_period, scaled_period[task]);
+			to.num_tasks += 1;
+			to.util += task_on_core(state, task, core_min).util;
+			to.density += density(task_on_core(state, task, core_min));
+			use_bandwidth(state, core_min, tasks[task].bandwidth);
+			moved = true;
+		}
+		if (!moved) break;
+		tree_set(&shared, max_position, shared_key(core_max));
+		tree_set(&balanced, min_position, -cores[core_min].util);
+	}
+
+	// Tasks on the balanced cores get deadline monotonic priorities from 97 down
+	for (unsigned k = 0; k < available.size(); ++k)
+	{
+		const core_state_t & core = cores[available[k]];
+		for (unsigned i = 0; i < core.tasks.size(); ++i)
+		{
+			partition_placement_t & placement = state->result->placement[core.tasks[i]];
+			placement.first_core = available[k];
+			placement.last_core = available[k];
+			placement.priority = 97 - i;
+		}
+	}
+}
+
+// Gives the light tasks on each core optimal priorities by response time
+// analysis (see rta_core_assign_priorities). They were admitted in deadline
+// monotonic order, which is kept wherever it meets every deadline.
+static void assign_priorities(partition_state_t *state)
+{
+	std::vector<partition_placement_t> & placement = state->result->placement;
+	for (unsigned k = 0; k < state->light_cores.size(); ++k)
+	{
+		const core_state_t & core = state->cores[state->light_cores[k]];
+		if (core.num_parts > 0) continue;
+		std::vector<unsigned> on_core = core.tasks;
+		std::stable_sort(on_core.begin(), on_core.end(),
+			[&placement](unsigned a, unsigned b) { return placement[a].priority > placement[b].priority; });
+
+		rta_core_t rta;
+		rta.schedulable = true;
+		if (core.budget > 0) rta_core_add_reservation(&rta, core.budget, core.budget_period);
+		const unsigned num_reservations = rta.tasks.size();
+		std::vector<int> priorities;
+		for (unsigned i = 0; i < on_core.size(); ++i)
+		{
+			const partition_task_t t = task_on_core(state, on_core[i], state->light_cores[k]);
+			priorities.push_back(placement[on_core[i]].priority);
+			rta_core_force_add(&rta, t.work, t.period, t.deadline, priorities.back());
+		}
+		if (rta.schedulable) continue;
+
+		std::vector<unsigned> order(rta.tasks.size());
+		if (!rta_core_assign_priorities(&rta, &order[0])) continue;
+		for (unsigned i = num_reservations; i < order.size(); ++i)
+		{
+			placement[on_core[order[i] - num_reservations]].priority = priorities[i - num_reservations];
+		}
+	}
+}
+
+// Bound on the response time of a heavy task with work C and span L on m
+// dedicated cores and one more thread under a reservation of budget B every
+// period P. The reservation may supply nothing for 2(P-B), and at least B of
+// every P after that. Until the job finishes, either every thread is busy, or
+// some thread is idle and a node of the critical path runs, or the critical
+// path waits on the reserved thread while it is not supplied, so with
+// alpha = B/P the bound is R <= (C + mL) / (alpha(m+1)) + 2(P-B), the federated
+// bound on m+1 cores when B = P.
+static double semi_federated_response(const partition_task_t & t, unsigned m, int64_t budget, int64_t period)
+{
+	return 1.0 * (t.work + m * t.span) * period / (1.0 * budget * (m + 1)) + 2.0 * (period - budget);
+}
+
+// Sizes the cluster of a heavy task with the given work and span: ceil((C-L)/(D-L))
+// cores, at least 2, or semi-federated, floor((C-L)/(D-L)) cores, at least 1,
+// and, if those are not enough, the smallest budget on a shared core that meets
+// the deadline by semi_federated_response. The budget period splits the
+// deadline into windows no longer than the shortest light deadline, so that
+// the reservation delays the light tasks on the core by no more than one
+// budget per window. The budget is at least the smallest one the kernel
+// accepts, which only shortens the bound. If no budget below a whole core is
+// enough the task gets one more dedicated core instead. Returns 0 if no number
+// of cores is enough.
+static unsigned cluster_size(const partition_state_t *state, const partition_task_t & t, double *cores_needed,
+	int64_t *budget, int64_t *budget_period)
+{
+	*budget = 0;
+	*budget_period = 0;
+	if (t.deadline <= t.span) return 0;
+	*cores_needed = 1.0 * (t.work - t.span) / (t.deadline - t.span);
+	if (state->option->semi_federated)
+	{
+		const unsigned dedicated = static_cast<unsigned>(std::max<int64_t>((t.work - t.span) / (t.deadline - t.span), 1));
+		if (t.work - t.span <= dedicated * (t.deadline - t.span)) return dedicated;
+
+		const int64_t windows = state->min_light_deadline > 0 ? (t.deadline + state->min_light_deadline - 1) / state->min_light_deadline : 1;
+		const int64_t period = t.deadline / windows;
+		if (period < 2 || semi_federated_response(t, dedicated, period - 1, period) > t.deadline) return dedicated + 1;
+		// The bound only falls as the budget grows
+		int64_t low = 1, high = period - 1;
+		while (low < high)
+		{
+			const int64_t mid = low + (high - low) / 2;
+			if (semi_federated_response(t, dedicated, mid, period) <= t.deadline) high = mid;
+			else low = mid + 1;
+		}
+		if (std::max(low, min_budget_ns) < period)
+		{
+			*budget = std::max(low, min_budget_ns);
+			*budget_period = period;
+		}
+		return dedicated + 1;
+	}
+	return std::max(static_cast<unsigned>(ceil(*cores_needed)), 2u);
+}
+
+// Places the clusters of heavy tasks by core speed. Each task, by decreasing
+// utilization, takes the run of consecutive free cores that needs the fewest
+// cores with its work and span at the speed of the slowest core of the run,
+// and of those the fastest, then the first. With whole_cores a run takes at
+// most one cpu of each physical core, and only cores whose cpus are all free,
+// and their other cpus are marked used as well. Returns false if some task
+// fits in no run.
+static bool place_by_speed(partition_state_t *state, const std::vector<unsigned> & heavy_tasks, bool whole_cores,
+	std::vector<bool> & used, std::vector<unsigned> & first_cores, std::vector<unsigned> & cluster_sizes,
+	std::vector<double> & cores_needed, std::vector<int64_t> & budgets, std::vector<int64_t> & budget_periods)
+{
+	const partition_problem_t *problem = state->problem;
+	const unsigned num_cores = problem->num_cores;
+	std::vector<std::vector<unsigned> > siblings(num_cores);
+	if (whole_cores)
+	{
+		for (unsigned c = 0; c < num_cores; ++c)
+		{
+			std::vector<unsigned> cpus;
+			topology_siblings(problem->topology, problem->first_cpu + c, cpus);
+			for (unsigned k = 0; k < cpus.size(); ++k)
+			{
+				if (cpus[k] >= problem->first_cpu && cpus[k] - problem->first_cpu < num_cores) siblings[c].push_back(cpus[k] - problem->first_cpu);
+			}
+		}
+	}
+	// Whether core c can join a run that starts at start
+	auto usable = [&](unsigned c, unsigned start)
+	{
+		if (used[c]) return false;
+		for (unsigned k = 0; k < siblings[c].size(); ++k)
+		{
+			if (used[siblings[c][k]] || (siblings[c][k] >= start && siblings[c][k] < c)) return false;
+		}
+		return true;
+	};
+
+	for (unsigned i = 0; i < heavy_tasks.size(); ++i)
+	{
+		const partition_task_t & task = (*state->tasks)[heavy_tasks[i]];
+		unsigned best_size = 0;
+		double best_speed = 0;
+		for (unsigned start = 0; start < num_cores; ++start)
+		{
+			double speed = HUGE_VAL;
+			for (unsigned end = start; end < num_cores && usable(end, start); ++end)
+			{
+				speed = std::min(speed, problem->core_speed[end]);
+				double needed;
+				int64_t budget, budget_period;
+				// The size only grows as the run gets slower
+				const unsigned size = cluster_size(state, at_speed(task, speed), &needed, &budget, &budget_period);
+				if (size == 0 || (best_size != 0 && size > best_size)) break;
+				if (end - start + 1 < size) continue;
+				if (best_size == 0 || size < best_size || speed > best_speed)
+				{
+					best_size = size;
+					best_speed = speed;
+					first_cores[i] = start;
+					cores_needed[i] = needed;
+					budgets[i] = budget;
+					budget_periods[i] = budget_period;
+				}
+				break;
+			}
+		}
+		if (best_size == 0) return false;
+
+		cluster_sizes[i] = best_size;
+		for (unsigned c = first_cores[i]; c < first_cores[i] + best_size; ++c)
+		{
+			used[c] = true;
+			for (unsigned k = 0; k < siblings[c].size(); ++k) used[siblings[c][k]] = true;
+		}
+	}
+	return true;
+}
+
+// Places the heavy tasks, which partition_minimize keeps for every count of
+// cores that holds their clusters. Returns whether the memory domains may
+// hold their bandwidth, or that the clusters do not fit.
+static partition_schedulability place_heavy_tasks(partition_state_t *state)
+{
+	const partition_problem_t *problem = state->problem;
+	const double threshold = state->option->threshold;
+	const partition_smt_policy smt_policy = problem->topology == NULL ? PARTITION_SMT_IGNORE : problem->smt_policy;
+	if (smt_policy == PARTITION_SMT_SHARED && topology_shares_cores(problem->topology, problem->first_cpu, std::vector<bool>(problem->num_cores, true)))
+	{
+		slow_down(state, problem->by_util);
+	}
+	// Light tasks are only slowed down below once the heavy and light tasks are
+	// told apart, which changes work and span but not deadlines
+	const std::vector<partition_task_t> & tasks = *state->tasks;
+
+	std::vector<unsigned> & heavy_tasks = state->heavy_tasks;
+	for (unsigned i = 0; i < problem->by_util.size() && tasks[problem->by_util[i]].util >= threshold; ++i)
+	{
+		heavy_tasks.push_back(problem->by_util[i]);
+	}
+
+	state->min_light_deadline = 0;
+	for (unsigned i = 0; i < problem->by_deadline.size() && state->min_light_deadline == 0; ++i)
+	{
+		if (tasks[problem->by_deadline[i]].util < threshold) state->min_light_deadline = tasks[problem->by_deadline[i]].deadline;
+	}
+
+	// With core speeds the clusters go to the fastest runs of cores that hold
+	// them. Otherwise they go into the smallest topology domains that hold
+	// them, or else one after the other from core 0, which may put them on
+	// siblings.
+	const bool whole_cores = smt_policy == PARTITION_SMT_WHOLE_CORES;
+	std::vector<bool> & used = state->heavy_cores;
+	used.assign(problem->num_cores, false);
+	std::vector<unsigned> first_cores(heavy_tasks.size()), cluster_sizes(heavy_tasks.size());
+	std::vector<double> cores_needed(heavy_tasks.size());
+	std::vector<int64_t> budgets(heavy_tasks.size()), budget_periods(heavy_tasks.size());
+	if (!problem->core_speed.empty())
+	{
+		if (!place_by_speed(state, heavy_tasks, whole_cores, used, first_cores, cluster_sizes, cores_needed, budgets, budget_periods)) return PARTITION_UNSCHEDULABLE;
+	}
+	else
+	{
+		unsigned num_heavy_cores = 0;
+		for (unsigned i = 0; i < heavy_tasks.size(); ++i)
+		{
+			cluster_sizes[i] = cluster_size(state, tasks[heavy_tasks[i]], &cores_needed[i], &budgets[i], &budget_periods[i]);
+			num_heavy_cores += cluster_sizes[i];
+			if (cluster_sizes[i] == 0 || num_heavy_cores > problem->num_cores) return PARTITION_UNSCHEDULABLE;
+		}
+		if (problem->topology == NULL || !topology_place_clusters(problem->topology, problem->first_cpu, cluster_sizes, whole_cores, used, first_cores))
+		{
+			if (whole_cores) return PARTITION_UNSCHEDULABLE;
+			for (unsigned i = 0, next_core = 0; i < heavy_tasks.size(); next_core += cluster_sizes[i], ++i)
+			{
+				first_cores[i] = next_core;
+			}
+			for (unsigned c = 0; c < num_heavy_cores; ++c) used[c] = true;
+		}
+	}
+
+	// A heavy task's bandwidth is shared among the cores of its cluster
+	state->domain_used.assign(problem->domain_bandwidth.size(), 0.0);
+	for (unsigned i = 0; i < heavy_tasks.size(); ++i)
+	{
+		partition_placement_t & placement = state->result->placement[heavy_tasks[i]];
+		for (unsigned c = first_cores[i]; c < first_cores[i] + cluster_sizes[i]; ++c)
+		{
+			use_bandwidth(state, c, tasks[heavy_tasks[i]].bandwidth / cluster_sizes[i]);
+		}
+		placement.first_core = first_cores[i];
+		placement.last_core = first_cores[i] + cluster_sizes[i] - 1;
+		placement.priority = 97;
+		// The shared core of a semi-federated task is a light core
+		if (budgets[i] > 0)
+		{
+			placement.budget = budgets[i];
+			placement.budget_period = budget_periods[i];
+			used[placement.last_core] = false;
+		}
+		else if (cluster_sizes[i] > cores_needed[i] && cluster_sizes[i] > 2)
+		{
+			possible_core_t possible = { placement.last_core, cluster_sizes[i] - cores_needed[i], heavy_tasks[i] };
+			state->possible.push_back(possible);
+		}
+	}
+
+	bool overloaded = false;
+	for (unsigned d = 0; d < problem->domain_bandwidth.size(); ++d)
+	{
+		if (state->domain_used[d] > problem->domain_bandwidth[d]) overloaded = true;
+	}
+	return overloaded ? PARTITION_MAY_TRY : PARTITION_SCHEDULABLE;
+}
+
+// Packs the light tasks onto the cores that place_heavy_tasks left, and the
+// shared cores of semi-federated tasks, given what it returned
+static partition_schedulability place_light_tasks(partition_state_t *state, partition_schedulability heavy_sched)
+{
+	const partition_problem_t *problem = state->problem;
+	const double threshold = state->option->threshold;
+	const bool whole_cores = problem->topology != NULL && problem->smt_policy == PARTITION_SMT_WHOLE_CORES;
+	const std::vector<partition_task_t> & tasks = *state->tasks;
+	const std::vector<unsigned> & heavy_tasks = state->heavy_tasks;
+	const std::vector<bool> & used = state->heavy_cores;
+
+	std::vector<unsigned> light_tasks;
+	for (unsigned i = 0; i < problem->by_deadline.size(); ++i)
+	{
+		if (tasks[problem->by_deadline[i]].util < threshold) light_tasks.push_back(problem->by_deadline[i]);
+	}
+	if (light_tasks.empty()) return heavy_sched;
+	for (unsigned c = 0; c < problem->num_cores; ++c)
+	{
+		if (!used[c]) state->light_cores.push_back(c);
+	}
+	if (state->light_cores.empty()) return PARTITION_UNSCHEDULABLE;
+	// Light tasks fill the fastest cores first
+	if (!problem->core_speed.empty())
+	{
+		const std::vector<double> & speed = problem->core_speed;
+		std::stable_sort(state->light_cores.begin(), state->light_cores.end(),
+			[&speed](unsigned a, unsigned b) { return speed[a] > speed[b]; });
+	}
+	if (whole_cores)
+	{
+		std::vector<bool> light(problem->num_cores, false);
+		for (unsigned k = 0; k < state->light_cores.size(); ++k) light[state->light_cores[k]] = true;
+		if (topology_shares_cores(problem->topology, problem->first_cpu, light)) slow_down(state, light_tasks);
+	}
+
+	// The bound works on deadlines scaled into [1, 2] when they differ by a factor of 2 or more
+	const double min_period = tasks[light_tasks.front()].deadline;
+	const double max_period = tasks[light_tasks.back()].deadline;
+	state->scaled_period.resize(tasks.size());
+	for (unsigned i = 0; i < light_tasks.size(); ++i)
+	{
+		const double period = tasks[light_tasks[i]].deadline;
+		state->scaled_period[light_tasks[i]] = max_period / min_period >= 2.0 ? (period - min_period) / (max_period - min_period) + 1 : period;
+	}
+
+	std::stable_sort(state->possible.begin(), state->possible.end(),
+		[](const possible_core_t & a, const possible_core_t & b) { return a.remaining > b.remaining; });
+
+	state->cores.resize(problem->num_cores);
+	for (unsigned c = 0; c < problem->num_cores; ++c)
+	{
+		state->cores[c].num_tasks = 0;
+		state->cores[c].util = 0;
+		state->cores[c].density = 0;
+		state->cores[c].min_period = 0;
+		state->cores[c].budget = 0;
+		state->cores[c].num_parts = 0;
+		state->cores[c].has_top_part = false;
+		state->cores[c].rta.schedulable = true;
+	}
+	for (unsigned i = 0; i < heavy_tasks.size(); ++i)
+	{
+		const partition_placement_t & placement = state->result->placement[heavy_tasks[i]];
+		if (placement.budget == 0) continue;
+		core_state_t & core = state->cores[placement.last_core];
+		core.budget = placement.budget;
+		core.budget_period = placement.budget_period;
+		core.util = 1.0 * core.budget / core.budget_period;
+		core.density = core.util;
+		rta_core_add_reservation(&core.rta, core.budget, core.budget_period);
+	}
+
+	state->result->sched = heavy_sched;
+	const bool fits = state->option->fit == PARTITION_OPTIMAL_FIT ? optimal_fit(state, light_tasks) :
+		state->option->fit == PARTITION_WORST_FIT ? worst_fit(state, light_tasks) : next_fit(state, light_tasks);
+	if (!fits) return PARTITION_UNSCHEDULABLE;
+	if (state->result->sched == PARTITION_SCHEDULABLE && state->option->load_balance) load_balance(state);
+	if (state->option->admission == PARTITION_RTA_ADMISSION) assign_priorities(state);
+	return state->result->sched;
+}
+
+static partition_schedulability partition_tasks(partition_state_t *state)
+{
+	const partition_schedulability heavy_sched = place_heavy_tasks(state);
+	if (heavy_sched == PARTITION_UNSCHEDULABLE) return heavy_sched;
+	return place_light_tasks(state, heavy_sched);
+}
+
+void partition_run(const partition_problem_t *problem, const partition_option_t *option, partition_result_t *result)
+{
+	partition_state_t state;
+	state.problem = problem;
+	state.option = option;
+	state.tasks = &problem->tasks;
+	state.result = result;
+	const partition_placement_t unplaced = { 0, 0, 0, 0, 0, 1.0 };
+	result->placement.assign(problem->tasks.size(), unplaced);
+	result->search_timed_out = false;
+
+	result->sched = partition_tasks(&state);
+	if (result->sched == PARTITION_UNSCHEDULABLE) result->placement.clear();
+	partition_evaluate(problem, result);
+}
+
+void partition_evaluate(const partition_problem_t *problem, partition_result_t *result)
+{
+	result->cores_used = 0;
+	result->max_core_util = 0;
+	result->min_slack = 0;
+	result->rm_schedulable = false;
+	result->max_domain_load = 0;
+	result->task_slack.clear();
+	if (result->sched == PARTITION_UNSCHEDULABLE) return;
+
+	const std::vector<partition_task_t> & tasks = problem->tasks;
+	const bool whole_cores = problem->topology != NULL && problem->smt_policy == PARTITION_SMT_WHOLE_CORES;
+	std::vector<double> core_util(problem->num_cores, 0.0);
+	std::vector<bool> core_used(problem->num_cores, false);
+	std::vector<rta_core_t> cores(problem->num_cores), rm_cores(problem->num_cores);
+	std::vector<std::vector<unsigned> > light_tasks(problem->num_cores);
+	std::vector<bool> has_parts(problem->num_cores, false);
+	// The task that finishes each job at a priority of a core: a light task or
+	// the last part of a split task
+	std::vector<std::vector<std::pair<int, unsigned> > > finishing(problem->num_cores);
+	result->task_slack.assign(tasks.size(), 0.0);
+	std::vector<double> domain_load(problem->domain_bandwidth.size(), 0.0);
+	auto add_load = [&](unsigned c, double bandwidth)
+	{
+		if (!domain_load.empty()) domain_load[problem->core_domain[c]] += bandwidth;
+	};
+	for (unsigned c = 0; c < problem->num_cores; ++c) cores[c].schedulable = rm_cores[c].schedulable = true;
+
+	double min_slack = 1;
+	for (unsigned i = 0; i < tasks.size(); ++i)
+	{
+		const partition_placement_t & placement = result->placement[i];
+		const partition_task_t slowed = placement.slowdown == 1.0 ? tasks[i] : slowed_task(tasks[i], placement.slowdown);
+		// A cluster runs at the speed of its slowest core
+		double speed = core_speed(problem, placement.first_core);
+		for (unsigned c = placement.first_core + 1; c <= placement.last_core; ++c) speed = std::min(speed, core_speed(problem, c));
+		const partition_task_t t = at_speed(slowed, speed);
+		const unsigned num_cores = placement.last_core - placement.first_core + 1;
+		// A semi-federated task's budget is its share of its last core
+		const unsigned num_dedicated = placement.budget > 0 ? num_cores - 1 : num_cores;
+		const double budget_util = placement.budget > 0 ? 1.0 * placement.budget / placement.budget_period : 0;
+		if (!placement.segments.empty())
+		{
+			// Every part of a split task but the last has its time as its
+			// deadline, and the last one what is left of the work and deadline
+			unsigned c = placement.first_core;
+			int priority = placement.priority;
+			int64_t work = slowed.work, deadline = slowed.deadline;
+			for (unsigned k = 0; k <= placement.segments.size(); ++k)
+			{
+				const bool last = k == placement.segments.size();
+				const int64_t part = last ? time_taken(std::max<int64_t>(work, 0), core_speed(problem, c)) : placement.segments[k].budget;
+				rta_core_force_add(&cores[c], part, t.period, last ? deadline : part, priority);
+				core_util[c] += 1.0 * part / t.period;
+				core_used[c] = true;
+				has_parts[c] = true;
+				add_load(c, tasks[i].bandwidth * (last ? work : std::min(work, work_done(part, core_speed(problem, c)))) / slowed.work);
+				work -= work_done(part, core_speed(problem, c));
+				deadline -= part;
+				if (last)
+				{
+					finishing[c].push_back(std::make_pair(priority, i));
+					break;
+				}
+				c = placement.segments[k].core;
+				priority = placement.segments[k].priority;
+			}
+			continue;
+		}
+		if (placement.budget > 0)
+		{
+			core_util[placement.last_core] += budget_util;
+			rta_core_add_reservation(&cores[placement.last_core], placement.budget, placement.budget_period);
+			rta_core_add_reservation(&rm_cores[placement.last_core], placement.budget, placement.budget_period);
+		}
+		for (unsigned c = placement.first_core; c <= placement.last_core; ++c)
+		{
+			if (c - placement.first_core < num_dedicated) core_util[c] += (t.util - budget_util) / num_dedicated;
+			core_used[c] = true;
+			add_load(c, tasks[i].bandwidth / num_cores);
+			if (!whole_cores || num_cores == 1) continue;
+
+			std::vector<unsigned> siblings;
+			topology_siblings(problem->topology, problem->first_cpu + c, siblings);
+			for (unsigned k = 0; k < siblings.size(); ++k)
+			{
+				if (siblings[k] >= problem->first_cpu && siblings[k] - problem->first_cpu < problem->num_cores) core_used[siblings[k] - problem->first_cpu] = true;
+			}
+		}
+
+		if (num_cores == 1)
+		{
+			rta_core_force_add(&cores[placement.first_core], t.work, t.period, t.deadline, placement.priority);
+			light_tasks[placement.first_core].push_back(i);
+			finishing[placement.first_core].push_back(std::make_pair(placement.priority, i));
+		}
+		else
+		{
+			const double response = placement.budget > 0 ? semi_federated_response(t, num_dedicated, placement.budget, placement.budget_period) :
+				t.span + 1.0 * (t.work - t.span) / num_dedicated;
+			result->task_slack[i] = (t.deadline - response) / t.deadline;
+			min_slack = std::min(min_slack, result->task_slack[i]);
+		}
+	}
+
+	result->rm_schedulable = true;
+	for (unsigned c = 0; c < problem->num_cores; ++c)
+	{
+		std::vector<unsigned> & by_period = light_tasks[c];
+		std::stable_sort(by_period.begin(), by_period.end(),
+			[&tasks](unsigned a, unsigned b) { return tasks[a].period < tasks[b].period; });
+		for (unsigned k = 0; k < by_period.size(); ++k)
+		{
+			const partition_placement_t & placement = result->placement[by_period[k]];
+			const partition_task_t t = at_speed(placement.slowdown == 1.0 ? tasks[by_period[k]] : slowed_task(tasks[by_period[k]], placement.slowdown), core_speed(problem, c));
+			rta_core_force_add(&rm_cores[c], t.work, t.period, t.deadline, -static_cast<int>(k));
+		}
+		if (!rm_cores[c].schedulable && !has_parts[c]) result->rm_schedulable = false;
+
+		if (core_used[c]) result->cores_used += 1;
+		result->max_core_util = std::max(result->max_core_util, core_util[c]);
+		for (unsigned k = 0; k < cores[c].tasks.size(); ++k)
+		{
+			const rta_task_t & t = cores[c].tasks[k];
+			min_slack = std::min(min_slack, 1.0 * (t.deadline - t.response) / t.deadline);
+			for (unsigned j = 0; j < finishing[c].size(); ++j)
+			{
+				if (finishing[c][j].first != t.priority) continue;
+				const unsigned task = finishing[c][j].second;
+				result->task_slack[task] = 1.0 * (t.deadline - t.response) / tasks[task].deadline;
+			}
+		}
+	}
+	result->min_slack = min_slack;
+	for (unsigned d = 0; d < domain_load.size(); ++d)
+	{
+		result->max_domain_load = std::max(result->max_domain_load, domain_load[d] / problem->domain_bandwidth[d]);
+	}
+}
+
+// Returns -1 if a is better than b in one metric, 1 if it is worse and 0 if they tie
+static int compare_metric(const partition_result_t *a, const partition_result_t *b, partition_objective metric)
+{
+	const double epsilon = 1e-9;
+	switch (metric)
+	{
+		case PARTITION_FEWEST_CORES:
+			return a->cores_used < b->cores_used ? -1 : a->cores_used > b->cores_used ? 1 : 0;
+		case PARTITION_BEST_BALANCE:
+			return a->max_core_util < b->max_core_util - epsilon ? -1 : a->max_core_util > b->max_core_util + epsilon ? 1 : 0;
+		default:
+			return a->min_slack > b->min_slack + epsilon ? -1 : a->min_slack < b->min_slack - epsilon ? 1 : 0;
+	}
+}
+
+bool partition_better(const partition_result_t *a, const partition_result_t *b, partition_objective objective)
+{
+	if (a->sched != b->sched) return a->sched < b->sched;
+	if (a->sched == PARTITION_UNSCHEDULABLE) return false;
+
+	const partition_objective metrics[] = { objective, PARTITION_FEWEST_CORES, PARTITION_BEST_BALANCE, PARTITION_MOST_SLACK };
+	for (unsigned i = 0; i < sizeof(metrics) / sizeof(metrics[0]); ++i)
+	{
+		const int comparison = compare_metric(a, b, metrics[i]);
+		if (comparison != 0) return comparison < 0;
+	}
+	return false;
+}
+
+unsigned partition_explore(const partition_problem_t *problem, const partition_option_t *options, unsigned num_options, partition_objective objective, std::vector<partition_result_t> & results)
+{
+	results.resize(num_options);
+
+	#pragma omp parallel for schedule(dynamic, 1)
+	for (unsigned i = 0; i < num_options; ++i)
+	{
+		partition_run(problem, &options[i], &results[i]);
+	}
+
+	unsigned best = 0;
+	for (unsigned i = 1; i < num_options; ++i)
+	{
+		if (partition_better(&results[i], &results[best], objective)) best = i;
+	}
+	return best;
+}
+
+unsigned partition_min_cores_bound(const partition_problem_t *problem)
+{
+	double total_util = 0, max_speed = 1;
+	for (unsigned i = 0; i < problem->tasks.size(); ++i) total_util += problem->tasks[i].util;
+	if (!problem->core_speed.empty()) max_speed = *std::max_element(problem->core_speed.begin(), problem->core_speed.end());
+	return std::max(static_cast<unsigned>(ceil(total_util / max_speed - 1e-9)), 1u);
+}
+
+unsigned partition_minimize(const partition_problem_t *problem, const partition_option_t *option, partition_result_t *result)
+{
+	unsigned num_cores = partition_min_cores_bound(problem);
+	if (num_cores > problem->num_cores)
+	{
+		partition_run(problem, option, result);
+		return 0;
+	}
+
+	// The heavy tasks are placed once on all the cores. A count of cores that
+	// holds every cluster, and shares physical cores if all the cores do, would
+	// place them alike, so only the light tasks are packed again for it.
+	// Fewer cores are partitioned from scratch.
+	partition_problem_t probe = *problem;
+	partition_result_t heavy_result;
+	partition_state_t heavy;
+	heavy.problem = &probe;
+	heavy.option = option;
+	heavy.tasks = &problem->tasks;
+	heavy.result = &heavy_result;
+	const partition_placement_t unplaced = { 0, 0, 0, 0, 0, 1.0 };
+	heavy_result.placement.assign(problem->tasks.size(), unplaced);
+	heavy_result.search_timed_out = false;
+	const partition_schedulability heavy_sched = place_heavy_tasks(&heavy);
+	if (heavy_sched == PARTITION_UNSCHEDULABLE)
+	{
+		partition_run(problem, option, result);
+		return 0;
+	}
+	unsigned heavy_end = 0;
+	for (unsigned i = 0; i < heavy.heavy_tasks.size(); ++i)
+	{
+		heavy_end = std::max(heavy_end, heavy_result.placement[heavy.heavy_tasks[i]].last_core + 1);
+	}
+	const bool shared = problem->topology != NULL && problem->smt_policy == PARTITION_SMT_SHARED;
+	const bool all_share = shared && topology_shares_cores(problem->topology, problem->first_cpu, std::vector<bool>(problem->num_cores, true));
+
+	auto schedulable = [&](unsigned count)
+	{
+		probe.num_cores = count;
+		if (count < heavy_end || (shared && topology_shares_cores(problem->topology, problem->first_cpu, std::vector<bool>(count, true)) != all_share))
+		{
+			partition_run(&probe, option, result);
+			return result->sched == PARTITION_SCHEDULABLE;
+		}
+		*result = heavy_result;
+		partition_state_t state = heavy;
+		state.result = result;
+		if (heavy.tasks == &heavy.slowed_tasks) state.tasks = &state.slowed_tasks;
+		result->sched = place_light_tasks(&state, heavy_sched);
+		if (result->sched == PARTITION_UNSCHEDULABLE) result->placement.clear();
+		partition_evaluate(&probe, result);
+		return result->sched == PARTITION_SCHEDULABLE;
+	};
+
+	// The heuristics may fail on some count of cores and succeed on fewer, so
+	// once all the cores are found to be enough every count from the bound up
+	// is tried
+	if (!schedulable(problem->num_cores)) return 0;
+	partition_result_t all_cores = *result;
+	while (num_cores < problem->num_cores && !schedulable(num_cores)) ++num_cores;
+	if (num_cores == problem->num_cores) *result = all_cores;
+	return num_cores;
+}
+
+unsigned partition_explore_minimum(const partition_problem_t *problem, const partition_option_t *options, unsigned num_options,
+	partition_objective objective, std::vector<unsigned> & min_cores, std::vector<partition_result_t> & results)
+{
+	results.resize(num_options);
+	min_cores.resize(num_options);
+
+	#pragma omp parallel for schedule(dynamic, 1)
+	for (unsigned i = 0; i < num_options; ++i)
+	{
+		min_cores[i] = partition_minimize(problem, &options[i], &results[i]);
+	}
+
+	unsigned best = 0;
+	for (unsigned i = 1; i < num_options; ++i)
+	{
+		const bool fewer = min_cores[i] != 0 && (min_cores[best] == 0 || min_cores[i] < min_cores[best]);
+		const bool tie = min_cores[i] == min_cores[best];
+		if (fewer || (tie && partition_better(&results[i], &results[best], objective))) best = i;
+	}
+	return best;
+}
+
+// Relative precision of scaling factors, and the largest factor looked for
+static const double scaling_precision = 1e-4;
+static const double max_scaling_factor = 1e6;
+
+// Largest factor by which the work and span of a task, or of every task if
+// task is negative, can be multiplied with the partition still meeting every
+// deadline. scaled and scratch are copies of the problem and the result to
+// work in; scaled is restored before returning.
+static double scaling_factor(const partition_problem_t *problem, int task, partition_problem_t *scaled, partition_result_t *scratch)
+{
+	const unsigned first = task < 0 ? 0 : task;
+	const unsigned end = task < 0 ? problem->tasks.size() : task + 1;
+	auto meets_deadlines = [&](double factor)
+	{
+		for (unsigned i = first; i < end; ++i) scaled->tasks[i] = slowed_task(problem->tasks[i], factor);
+		partition_evaluate(scaled, scratch);
+		return scratch->min_slack >= 0;
+	};
+
+	// Double from 1 until the deadlines are missed, or halve the gap below 1
+	double low = 0, high = 1;
+	if (meets_deadlines(1.0))
+	{
+		low = 1;
+		high = 2;
+		while (high <= max_scaling_factor && meets_deadlines(high))
+		{
+			low = high;
+			high *= 2;
+		}
+	}
+	while (high <= max_scaling_factor && high - low > scaling_precision * high)
+	{
+		const double middle = (low + high) / 2;
+		if (meets_deadlines(middle)) low = middle;
+		else high = middle;
+	}
+
+	for (unsigned i = first; i < end; ++i) scaled->tasks[i] = problem->tasks[i];
+	return low;
+}
+
+void partition_sensitivity(const partition_problem_t *problem, const partition_result_t *result, double *all_tasks, std::vector<double> & task_factor)
+{
+	*all_tasks = 0;
+	task_factor.assign(problem->tasks.size(), 0.0);
+	if (result->sched == PARTITION_UNSCHEDULABLE) return;
+
+	#pragma omp parallel
+	{
+		partition_problem_t scaled = *problem;
+		partition_result_t scratch = *result;
+		#pragma omp single nowait
+		*all_tasks = scaling_factor(problem, -1, &scaled, &scratch);
+
+		#pragma omp for schedule(dynamic, 1)
+		for (unsigned i = 0; i < problem->tasks.size(); ++i)
+		{
+			task_factor[i] = scaling_factor(problem, i, &scaled, &scratch);
+		}
+	}
+}
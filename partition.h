@@ -0,0 +1,319 @@
+#ifndef RT_GOMP_PARTITION_H
+#define RT_GOMP_PARTITION_H
+
+#include <stdint.h>
+#include <vector>
+#include "topology.h"
+
+// The partitioning heuristics of cluster_partition() in lib_cluster.py, in C++.
+//
+// Heavy tasks get clusters of cores of their own and light tasks are packed
+// onto the remaining cores, one core each, with an admission test. A
+// partition_option_t chooses the fit, threshold, load balancing, splitting and
+// admission test, and a partition_problem_t gives the tasks and the cores,
+// with their topology, speeds and memory domains if known. Deadlines D may be
+// shorter than periods T. Times are nanoseconds.
+//
+// A partition_problem_t is never modified by the heuristics, so any number of
+// options can run on it at once (see partition_explore).
+
+// Schedulability of a partition, as written on the first line of a .rtps file
+enum partition_schedulability
+{
+	PARTITION_SCHEDULABLE = 0,
+	PARTITION_MAY_TRY = 1,
+	PARTITION_UNSCHEDULABLE = 2
+};
+
+// How light tasks, in deadline monotonic order, are packed onto cores. The
+// heuristic fits find cores through indexed structures rather than by
+// scanning them all for every task, so apart from the admission tests, the
+// tasks that no core admits and the sorting of the few memory domains for each
+// task that uses bandwidth, partitioning n tasks onto m cores takes O(n log m)
+// (see partition_benchmark, and partition_regression, which checks that they
+// keep giving the same partitions).
+enum partition_fit
+{
+	// Fill the current core until a task does not fit, then move on
+	// (original()). The cores without room are passed over with a tree of the
+	// room left on each, and one for the cores of each memory domain.
+	PARTITION_NEXT_FIT,
+	// Put each task on the least utilized core that admits it, found in
+	// ordered sets of the cores by utilization, and of each memory domain
+	PARTITION_WORST_FIT,
+	// Search all packings of the light tasks by branch and bound for the one
+	// onto the fewest cores, for tasksets where the heuristics leave cores
+	// unused or find no partition at all; it takes response time analysis as
+	// the admission test. Tasks go by decreasing utilization onto each core
+	// that already has tasks and admits them, or onto one empty core of each
+	// speed and memory domain, since empty cores alike are interchangeable. A
+	// branch is cut when the utilization of the tasks left, beyond the
+	// capacity left on the cores in use, needs enough new cores to reach the
+	// best packing found so far, which is at first that of next fit or worst
+	// fit, whichever admits every task onto fewer cores. Whether a set of
+	// tasks is schedulable on a core is remembered for the rest of the search.
+	// The search stops at the problem's time limit, keeping the best packing
+	// found; if there is none, the tasks are packed by worst fit.
+	PARTITION_OPTIMAL_FIT
+};
+
+// Admission test of light tasks onto a core
+enum partition_admission
+{
+	// The utilization bound np(rp^(1/np)-1)+2/rp-1 on scaled periods. It takes
+	// each task to have its deadline as its period, which only makes it more
+	// demanding, so it holds for constrained deadlines too.
+	PARTITION_BOUND_ADMISSION,
+	// Exact response time analysis (see rta.h). The light tasks on each core
+	// finally get Audsley's optimal priorities (see
+	// rta_core_assign_priorities in rta.h).
+	PARTITION_RTA_ADMISSION
+};
+
+typedef struct
+{
+	const char *name;
+	partition_fit fit;
+	// Tasks at or above this utilization are heavy, and no core is filled to
+	// it. A heavy task gets a federated cluster of ceil((C-L)/(D-L)) cores, at
+	// least 2, at priority 97, placed within the smallest cache or NUMA domain
+	// that holds it if a topology is given.
+	double threshold;
+	// After a schedulable packing, move light tasks onto unused cores (loadbalance())
+	bool load_balance;
+	// Share a core between each heavy task and light tasks. A heavy task gets
+	// m = floor((C-L)/(D-L)) dedicated cores, at least 1, and if those are not
+	// enough, the next core as well with the smallest budget reservation B
+	// every period P (see budget_reservation.h) that meets the deadline by the
+	// supply bound of the reservation, which may supply nothing for 2(P-B):
+	// R <= (C+mL)P/(B(m+1)) + 2(P-B). If no budget below the whole core is
+	// enough, the task gets m+1 dedicated cores instead. The remainder of a
+	// shared core goes to light tasks. Only response time analysis accounts
+	// for the reservation, so these options use it.
+	bool semi_federated;
+	// Split light tasks that no core admits whole over several cores, C=D
+	// style: every part but the last runs at the top priority of its core with
+	// its work as its deadline, so it ends exactly that long after the job's
+	// release, and the last part gets the rest of the work and of the
+	// deadline. The job moves from part to part when it has used the work of
+	// its part (see job_migration.h). This also takes response time analysis.
+	bool split;
+	partition_admission admission;
+}
+partition_option_t;
+
+// The options of cluster_partition (0 to 5) with each admission test, then the
+// semi-federated, the split and the optimal options
+extern const partition_option_t partition_options[];
+extern const unsigned num_partition_options;
+
+// Returns the option with the given name, or NULL
+const partition_option_t *find_partition_option(const char *name);
+
+typedef struct
+{
+	int64_t work;
+	int64_t span;
+	int64_t period;
+	int64_t deadline;
+	double util;
+	// Average memory bandwidth in MB/s, the task's memory traffic per job over
+	// its period, or 0 if it is not known
+	double bandwidth;
+}
+partition_task_t;
+
+// How tasks use the SMT siblings of a topology (see topology.h). Without a
+// topology every policy is PARTITION_SMT_IGNORE.
+enum partition_smt_policy
+{
+	// Every cpu is an independent core
+	PARTITION_SMT_IGNORE,
+	// Every cpu is a core, but the work and span of tasks that may share a
+	// physical core are multiplied by smt_slowdown: all tasks, if the problem's
+	// cpus include siblings
+	PARTITION_SMT_SHARED,
+	// Heavy task clusters take whole physical cores, one cpu each, and their
+	// siblings are left idle. Light tasks are slowed down as with
+	// PARTITION_SMT_SHARED if the cpus left for them include siblings.
+	PARTITION_SMT_WHOLE_CORES
+};
+
+typedef struct
+{
+	std::vector<partition_task_t> tasks;
+	unsigned num_cores;
+	// If not NULL, heavy task clusters are placed by topology_place_clusters
+	// (see topology.h); core 0 of the problem is cpu first_cpu
+	const topology_t *topology;
+	unsigned first_cpu;
+	partition_smt_policy smt_policy;
+	// Factor by which work and span grow on a cpu whose sibling is busy, at least 1
+	double smt_slowdown;
+	// Speed of each core relative to the one the task timings were measured on
+	// (see topology_speeds in topology.h), or empty if all cores run at speed 1.
+	// A task's work and span are divided by the speed of the core it runs on,
+	// and a heavy task's by the speed of the slowest core of its cluster. With
+	// speeds, heavy task clusters are placed by speed rather than topology
+	// domain: each heavy task, by decreasing utilization, takes the run of free
+	// cores that needs the fewest of them, the fastest of those, so heavy tasks
+	// go to fast cores first.
+	std::vector<double> core_speed;
+	// Memory domain of each core and bandwidth of each domain in MB/s (see
+	// topology_memory_domains in topology.h), or both empty if bandwidth is
+	// not limited. The average bandwidth of the tasks in a domain is packed like
+	// their utilization on a core: a light task is only admitted to a core
+	// whose domain has the bandwidth left for it, and a light task that uses
+	// any bandwidth goes to the domain with the most bandwidth left that has a
+	// core admitting it, so memory bound tasks spread over the domains instead
+	// of slowing each other down. A heavy task's bandwidth is shared among the
+	// domains of its cluster by their number of cores, and if that alone
+	// overloads a domain the partition is only worth a try.
+	std::vector<unsigned> core_domain;
+	std::vector<double> domain_bandwidth;
+	// Seconds that PARTITION_OPTIMAL_FIT may search for, or 0 for no limit
+	double search_seconds;
+	// Task indices by utilization, high to low, and by deadline, low to high
+	// (ties in utilization order), filled in by partition_problem_prepare
+	std::vector<unsigned> by_util;
+	std::vector<unsigned> by_deadline;
+}
+partition_problem_t;
+
+// Time limit of the optimal fit unless the problem is given another
+extern const double partition_default_search_seconds;
+
+// Most tasks of a taskset that partition_explorer runs the optimal fit on. The
+// search rarely finishes in its time limit on more, so it would only add that
+// much to the time taken for a heuristic packing.
+extern const unsigned partition_max_search_tasks;
+
+// Computes the task orders. Must be called after the tasks are filled in.
+void partition_problem_prepare(partition_problem_t *problem);
+
+// Where a split light task goes next: once its job has run for budget on the
+// previous core, the rest of it runs on core at priority
+typedef struct
+{
+	int64_t budget;
+	unsigned core;
+	int priority;
+}
+partition_segment_t;
+
+typedef struct
+{
+	unsigned first_core;
+	unsigned last_core;
+	int priority;
+	// For a semi-federated heavy task, its budget per budget_period on
+	// last_core, which it shares with light tasks; otherwise 0. The budget
+	// period divides the task's deadline into windows no longer than the
+	// shortest light task deadline, so that the reservation does not hold up
+	// light tasks for long.
+	int64_t budget;
+	int64_t budget_period;
+	// Factor by which the task's work and span were multiplied for sharing
+	// physical cores (see partition_smt_policy), 1 if they were not
+	double slowdown;
+	// For a split light task, the cores after first_core, otherwise empty. The
+	// budgets are times on the cores they run on.
+	std::vector<partition_segment_t> segments;
+}
+partition_placement_t;
+
+typedef struct
+{
+	partition_schedulability sched;
+	// Indexed like problem->tasks, empty if sched is PARTITION_UNSCHEDULABLE
+	std::vector<partition_placement_t> placement;
+	// Filled in by partition_evaluate
+	unsigned cores_used;
+	// Highest utilization of a core, with heavy tasks spread over their clusters
+	double max_core_util;
+	// Smallest (D-R)/D over all tasks, from response time analysis for light
+	// tasks, L+(C-L)/m for heavy tasks on m cores, and the bound of
+	// semi_federated for heavy tasks with a budget
+	double min_slack;
+	// Whether the light tasks would also meet their deadlines on the same cores
+	// with rate monotonic priorities. Cores with parts of split tasks are not
+	// compared.
+	bool rm_schedulable;
+	// Highest bandwidth of the tasks in a memory domain over the domain's
+	// bandwidth, 0 without memory domains
+	double max_domain_load;
+	// (D-R)/D of each task, indexed like problem->tasks, computed like
+	// min_slack; a split task's is that of its last part over its whole
+	// deadline
+	std::vector<double> task_slack;
+	// Whether the search of PARTITION_OPTIMAL_FIT ran out of time, so that the
+	// light tasks may fit on fewer of the cores left by the heavy tasks, or fit
+	// at all if they were packed by worst fit
+	bool search_timed_out;
+}
+partition_result_t;
+
+// Partitions the problem with one option and evaluates the result
+void partition_run(const partition_problem_t *problem, const partition_option_t *option, partition_result_t *result);
+
+// Computes cores_used, max_core_util, min_slack, rm_schedulable, max_domain_load and task_slack of a result, with the
+// slowdown of each placement. Siblings left idle by PARTITION_SMT_WHOLE_CORES
+// count as used.
+void partition_evaluate(const partition_problem_t *problem, partition_result_t *result);
+
+enum partition_objective
+{
+	PARTITION_FEWEST_CORES,
+	PARTITION_BEST_BALANCE,
+	PARTITION_MOST_SLACK
+};
+
+// Returns the objective with the given name ("cores", "balance" or "slack"),
+// or -1 if there is none
+int find_partition_objective(const char *name);
+
+// Returns whether a is strictly better than b: first by schedulability, then
+// by the objective, then by the other two metrics
+bool partition_better(const partition_result_t *a, const partition_result_t *b, partition_objective objective);
+
+// Runs every option on the problem in parallel on the OpenMP threads, storing
+// the result of options[i] in results[i], and returns the index of the best.
+// Ties go to the earlier option.
+unsigned partition_explore(const partition_problem_t *problem, const partition_option_t *options, unsigned num_options, partition_objective objective, std::vector<partition_result_t> & results);
+
+// Finds the fewest of the problem's cores, counted from core 0, on which the
+// option gives a schedulable partition, for capacity planning, and stores that
+// partition in result. The heuristics may fail on some number of cores and
+// succeed on fewer, so once all the cores are found to be enough, every count
+// is tried from the total utilization, which no partition beats (see
+// partition_min_cores_bound), up to the first that succeeds. The heavy tasks are placed once, on all the cores, and kept where
+// they are for the counts that hold their clusters, on which only the light
+// tasks are packed again. Returns 0, with the result for all the cores, if
+// they are not enough.
+unsigned partition_minimize(const partition_problem_t *problem, const partition_option_t *option, partition_result_t *result);
+
+// Fewest cores that any partition of the problem may use: its total
+// utilization over the top core speed, rounded up, and at least 1
+unsigned partition_min_cores_bound(const partition_problem_t *problem);
+
+// Minimizes the cores of every option in parallel as partition_explore runs
+// them, storing the count of options[i] in min_cores[i], and returns the index
+// of the option that needs the fewest. Ties go to the better result by the
+// objective, then to the earlier option.
+unsigned partition_explore_minimum(const partition_problem_t *problem, const partition_option_t *options, unsigned num_options,
+	partition_objective objective, std::vector<unsigned> & min_cores, std::vector<partition_result_t> & results);
+
+// WCET sensitivity of a partition: the critical scaling factor, the largest
+// factor by which the work and span of every task at once can be multiplied
+// with every deadline still met on the same cores at the same priorities by
+// the analysis of partition_evaluate, in all_tasks, and the factor for each
+// task on its own in task_factor. Reservation budgets and the budgets of the
+// parts of split tasks stay as they are, so only the last part of a split task
+// grows. A factor below 1 is how far the tasks must shrink for a partition
+// that misses deadlines, and a task's factor is 0 if no change to it alone
+// makes such a partition meet them. Each factor is found by doubling from 1
+// and then bisection to a relative precision of 1e-4, up to 1e6, and the tasks
+// are spread over the OpenMP threads. Factors are 0 for an unschedulable result.
+void partition_sensitivity(const partition_problem_t *problem, const partition_result_t *result, double *all_tasks, std::vector<double> & task_factor);
+
+#endif /* RT_GOMP_PARTITION_H */
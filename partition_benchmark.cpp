@@ -0,0 +1,80 @@
+// Measures how the running time of each partitioning option (see partition.h)
+// grows with the size of the taskset, up to about 10,000 tasks on 1,024 cores.
+// Usage: partition_benchmark [max_cores [num_repetitions]]
+// For 16 cores and each power of 4 up to max_cores (1024), random tasksets of
+// mostly light tasks, about ten per core, are generated with a total
+// utilization of 65% of the cores (see taskset_generator.h). Each heuristic
+// option partitions each taskset num_repetitions times (5) on one thread, and
+// the shortest time is reported in milliseconds, with the schedulability and
+// cores used. The optimal option is left out, since it searches until its time
+// limit on tasksets this large.
+
+#include <stdio.h>
+#include <sstream>
+#include <vector>
+#include "partition.h"
+#include "taskset_generator.h"
+#include "timespec_functions.h"
+
+enum rt_gomp_partition_benchmark_error_codes
+{
+	RT_GOMP_PARTITION_BENCHMARK_SUCCESS,
+	RT_GOMP_PARTITION_BENCHMARK_ARG_PARSE_ERROR
+};
+
+static const char *schedulability_names[] = { "schedulable", "may try", "unschedulable" };
+static const unsigned min_cores = 16;
+static const double normalized_util = 0.65;
+static const uint64_t benchmark_seed = 1;
+
+int main(int argc, char *argv[])
+{
+	unsigned max_cores = 1024, num_repetitions = 5;
+	if ((argc > 1 && !(std::istringstream(argv[1]) >> max_cores && max_cores >= min_cores)) ||
+		(argc > 2 && !(std::istringstream(argv[2]) >> num_repetitions && num_repetitions > 0)) || argc > 3)
+	{
+		fprintf(stderr, "Usage: partition_benchmark [max_cores [num_repetitions]]\n");
+		return RT_GOMP_PARTITION_BENCHMARK_ARG_PARSE_ERROR;
+	}
+
+	taskset_distribution_t distribution;
+	distribution.min_period = 10 * nanosec_in_millisec;
+	distribution.max_period = 1000 * nanosec_in_millisec;
+	distribution.min_deadline_ratio = 1;
+	distribution.max_deadline_ratio = 1;
+	distribution.heavy_fraction = 0.005;
+	distribution.min_heavy_util = 1;
+	distribution.max_heavy_util = 4;
+	distribution.min_light_util = 0.01;
+	distribution.max_light_util = 0.1;
+	distribution.min_span_ratio = 0.05;
+	distribution.max_span_ratio = 0.3;
+
+	printf("%6s %6s %-20s %-14s %6s %10s\n", "cores", "tasks", "option", "result", "used", "ms");
+	for (unsigned num_cores = min_cores; num_cores <= max_cores; num_cores *= 4)
+	{
+		distribution.num_cores = num_cores;
+		partition_problem_t problem;
+		generate_taskset(&distribution, normalized_util * num_cores, taskset_seed(benchmark_seed, num_cores, 0), &problem);
+
+		for (unsigned k = 0; k < num_partition_options; ++k)
+		{
+			if (partition_options[k].fit == PARTITION_OPTIMAL_FIT) continue;
+			partition_result_t result;
+			double best = 0;
+			for (unsigned r = 0; r < num_repetitions; ++r)
+			{
+				timespec start, end, elapsed;
+				get_time(&start);
+				partition_run(&problem, &partition_options[k], &result);
+				get_time(&end);
+				ts_diff(start, end, elapsed);
+				const double ms = elapsed.tv_sec * 1e3 + elapsed.tv_nsec / 1e6;
+				if (r == 0 || ms < best) best = ms;
+			}
+			printf("%6u %6zu %-20s %-14s %6u %10.3f\n", num_cores, problem.tasks.size(), partition_options[k].name,
+				schedulability_names[result.sched], result.cores_used, best);
+		}
+	}
+	return RT_GOMP_PARTITION_BENCHMARK_SUCCESS;
+}
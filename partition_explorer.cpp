@@ -0,0 +1,187 @@
+// Partitions a taskset with every option of partition.h at once and keeps the best.
+// Usage: partition_explorer taskset [cores|balance|slack|minimize [topology [ignore|shared|whole [slowdown]]]]
+// Like cluster.py, it reads taskset.rtpt and writes taskset.rtps, which
+// clustering_launcher then uses as long as it is newer than the .rtpt file. The
+// options run in parallel on the OpenMP threads over the same task data, and the
+// best schedulable partition is chosen by the objective: the fewest cores used
+// (the default), the lowest maximum core utilization, or the largest minimum
+// slack (D-R)/D. It notes when the chosen partition is only schedulable because
+// light tasks have other than rate monotonic priorities. With minimize, each
+// option is instead run on the fewest cores of the taskset it needs (see
+// partition_minimize), and the option that needs the fewest, with the most
+// slack among those, is written with its last core moved down to match and
+// the slack of every task printed, for consolidation planning. With a topology file
+// (see topology.h), or "sys" for the topology of this machine, heavy task
+// clusters are kept within the smallest cache or NUMA domain that holds them,
+// and SMT siblings are handled by the given policy (see partition_smt_policy
+// in partition.h): ignored (the default), shared with work and span multiplied
+// by the slowdown (2 by default, two siblings roughly halving each other's
+// throughput), or left idle next to the whole physical cores of heavy tasks.
+// If the topology file gives cpu speeds (see core_speed_benchmark), work and
+// span are scaled by them and heavy tasks go to the fastest cores that hold them.
+// If it gives the memory bandwidth of NUMA nodes, tasks annotated with their
+// memory traffic are spread so that no node is asked for more than it has.
+// The optimal option searches for up to partition_default_search_seconds and
+// notes when it runs out of time before proving that no packing of the light
+// tasks needs fewer cores. It is left out for tasksets of more than
+// partition_max_search_tasks tasks. Tasksets with shared resource annotations
+// are refused, since the blocking is not analyzed (see cluster.py).
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include "partition.h"
+#include "taskset_file.h"
+#include "timespec_functions.h"
+
+enum rt_gomp_partition_explorer_error_codes
+{
+	RT_GOMP_PARTITION_EXPLORER_SUCCESS,
+	RT_GOMP_PARTITION_EXPLORER_ARGUMENT_ERROR,
+	RT_GOMP_PARTITION_EXPLORER_FILE_ERROR,
+	RT_GOMP_PARTITION_EXPLORER_RESOURCES_ERROR
+};
+
+static const char *schedulability_names[] = { "schedulable", "may try", "unschedulable" };
+static const char *smt_policy_names[] = { "ignore", "shared", "whole" };
+static const double default_smt_slowdown = 2.0;
+
+// Returns the SMT policy with the given name, or -1 if there is none
+static int find_smt_policy(const char *name)
+{
+	for (unsigned i = 0; i < sizeof(smt_policy_names) / sizeof(smt_policy_names[0]); ++i)
+	{
+		if (std::string(name) == smt_policy_names[i]) return i;
+	}
+	return -1;
+}
+
+int main(int argc, char *argv[])
+{
+	int objective = PARTITION_FEWEST_CORES;
+	int smt_policy = PARTITION_SMT_IGNORE;
+	double smt_slowdown = default_smt_slowdown;
+	const bool minimize = argc > 2 && std::string(argv[2]) == "minimize";
+	if (minimize) objective = PARTITION_MOST_SLACK;
+	if (!(argc >= 2 && argc <= 6 && (argc <= 2 || minimize || (objective = find_partition_objective(argv[2])) >= 0) &&
+		(argc <= 4 || (smt_policy = find_smt_policy(argv[4])) >= 0) &&
+		(argc <= 5 || (sscanf(argv[5], "%lf", &smt_slowdown) == 1 && smt_slowdown >= 1.0))))
+	{
+		fprintf(stderr, "Usage: partition_explorer taskset [cores|balance|slack|minimize [topology [ignore|shared|whole [slowdown]]]]\n");
+		return RT_GOMP_PARTITION_EXPLORER_ARGUMENT_ERROR;
+	}
+
+	const std::string taskset_filename = std::string(argv[1]) + ".rtpt";
+	const std::string schedule_filename = std::string(argv[1]) + ".rtps";
+	taskset_file_t taskset;
+	partition_problem_t problem;
+	if (read_taskset_file(taskset_filename.c_str(), &taskset) != RT_GOMP_TASKSET_FILE_SUCCESS ||
+		taskset_problem(&taskset, &problem) != RT_GOMP_TASKSET_FILE_SUCCESS)
+	{
+		return RT_GOMP_PARTITION_EXPLORER_FILE_ERROR;
+	}
+	// A partition that leaves out the blocking would be wrongly guaranteed
+	if (taskset.has_resources)
+	{
+		fprintf(stderr, "ERROR: Blocking on shared resources is not analyzed, use cluster.py for %s\n", taskset_filename.c_str());
+		return RT_GOMP_PARTITION_EXPLORER_RESOURCES_ERROR;
+	}
+
+	topology_t topology;
+	if (argc >= 4)
+	{
+		const int ret_val = std::string(argv[3]) == "sys" ? read_topology(&topology) : read_topology_file(argv[3], &topology);
+		if (ret_val != RT_GOMP_TOPOLOGY_SUCCESS) return RT_GOMP_PARTITION_EXPLORER_FILE_ERROR;
+		problem.topology = &topology;
+		problem.smt_policy = static_cast<partition_smt_policy>(smt_policy);
+		problem.smt_slowdown = smt_slowdown;
+		topology_speeds(&topology, problem.first_cpu, problem.num_cores, problem.core_speed);
+		topology_memory_domains(&topology, problem.first_cpu, problem.num_cores, problem.core_domain, problem.domain_bandwidth);
+	}
+
+	// Start the OpenMP threads before timing, as a long running partitioner would have them
+	#pragma omp parallel
+	{
+	}
+
+	std::vector<partition_option_t> options(partition_options, partition_options + num_partition_options);
+	if (problem.tasks.size() > partition_max_search_tasks)
+	{
+		for (unsigned i = options.size(); i-- > 0; )
+		{
+			if (options[i].fit != PARTITION_OPTIMAL_FIT) continue;
+			printf("Leaving out %s, whose search is for tasksets of up to %u tasks.\n", options[i].name, partition_max_search_tasks);
+			options.erase(options.begin() + i);
+		}
+	}
+
+	std::vector<partition_result_t> results;
+	std::vector<unsigned> min_cores;
+	timespec start, end, elapsed;
+	get_time(&start);
+	const unsigned best = minimize ?
+		partition_explore_minimum(&problem, options.data(), options.size(), static_cast<partition_objective>(objective), min_cores, results) :
+		partition_explore(&problem, options.data(), options.size(), static_cast<partition_objective>(objective), results);
+	get_time(&end);
+	ts_diff(start, end, elapsed);
+
+	printf("%-20s %-14s %6s %14s %10s%s\n", "option", "result", "cores", "max core util", "min slack", minimize ? "  needs" : "");
+	for (unsigned i = 0; i < options.size(); ++i)
+	{
+		const partition_result_t & result = results[i];
+		printf("%-20s %-14s", options[i].name, schedulability_names[result.sched]);
+		if (result.sched != PARTITION_UNSCHEDULABLE)
+		{
+			printf(" %6u %14.3f %10.3f", result.cores_used, result.max_core_util, result.min_slack);
+		}
+		if (minimize && min_cores[i] > 0) printf(" %6u", min_cores[i]);
+		printf("%s\n", i == best ? "  <- chosen" : "");
+	}
+	for (unsigned i = 0; i < options.size(); ++i)
+	{
+		if (!results[i].search_timed_out) continue;
+		printf("The search of %s ran out of time after %.1f s, the light tasks may fit on fewer cores.\n", options[i].name,
+			problem.search_seconds);
+	}
+	printf("Explored %zu options for %zu tasks on %d threads in %.1f us\n", options.size(), problem.tasks.size(),
+		omp_get_max_threads(), elapsed.tv_sec * 1e6 + elapsed.tv_nsec / 1e3);
+
+	const partition_result_t & result = results[best];
+	if (result.sched == PARTITION_SCHEDULABLE) printf("Guaranteed schedulable.\n");
+	else if (result.sched == PARTITION_MAY_TRY) printf("Not guaranteed schedulable, partition available, may try.\n");
+	else printf("Not schedulable, no partition available.\n");
+	if (result.sched == PARTITION_SCHEDULABLE && !result.rm_schedulable)
+	{
+		printf("Rate monotonic priorities would miss deadlines on some of the cores of light tasks.\n");
+	}
+	if (result.sched != PARTITION_UNSCHEDULABLE && !problem.core_domain.empty())
+	{
+		printf("The busiest memory domain uses %.0f%% of its bandwidth.\n", 100 * result.max_domain_load);
+	}
+
+	if (minimize && min_cores[best] > 0)
+	{
+		taskset.last_core = taskset.first_core + min_cores[best] - 1;
+		printf("Needs %u of the %u cores, %u to %u, with this slack (D-R)/D:\n", min_cores[best], problem.num_cores,
+			taskset.first_core, taskset.last_core);
+		printf("%-30s %9s %9s %10s\n", "task", "cores", "priority", "slack");
+		for (unsigned i = 0; i < result.placement.size(); ++i)
+		{
+			const partition_placement_t & placement = result.placement[i];
+			char cores[32];
+			snprintf(cores, sizeof(cores), "%u-%u", taskset.first_core + placement.first_core, taskset.first_core + placement.last_core);
+			printf("%-30.30s %9s %9d %10.3f\n", taskset.entries[i].program.c_str(), cores, placement.priority, result.task_slack[i]);
+		}
+	}
+	else if (minimize)
+	{
+		printf("No option fits on all %u cores.\n", problem.num_cores);
+	}
+
+	if (write_schedule_file(schedule_filename.c_str(), &taskset, &result) != RT_GOMP_TASKSET_FILE_SUCCESS)
+	{
+		return RT_GOMP_PARTITION_EXPLORER_FILE_ERROR;
+	}
+	return RT_GOMP_PARTITION_EXPLORER_SUCCESS;
+}
@@ -0,0 +1,148 @@
+// Checks that the partitioning heuristics still give the partitions they gave
+// when partition_regression.txt was written, so that changes meant to make the
+// partitioner faster can be shown not to change what it decides.
+// Usage: partition_regression [runs]
+// Random tasksets are generated in five variants: implicit deadlines,
+// constrained deadlines, core speeds, memory domains with tasks annotated with
+// their bandwidth, and core speeds with memory domains together (see
+// taskset_generator.h). Every option but the optimal one, whose result depends
+// on its time limit, partitions each of them. For each option one line gives
+// the number of schedulable partitions, the cores they use and a hash of every
+// placement, which "make check" compares with partition_regression.txt. With
+// runs, a line is printed for each taskset and option instead, to diff against
+// the output of an older build and find the tasksets that changed.
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "partition.h"
+#include "taskset_generator.h"
+#include "timespec_functions.h"
+
+enum rt_gomp_partition_regression_error_codes
+{
+	RT_GOMP_PARTITION_REGRESSION_SUCCESS,
+	RT_GOMP_PARTITION_REGRESSION_ARG_PARSE_ERROR
+};
+
+enum regression_variant
+{
+	IMPLICIT_DEADLINES,
+	CONSTRAINED_DEADLINES,
+	CORE_SPEEDS,
+	MEMORY_DOMAINS,
+	SPEEDS_AND_DOMAINS,
+	NUM_VARIANTS
+};
+
+static const unsigned tasksets_per_variant = 150;
+static const unsigned max_cores = 200;
+static const unsigned num_domains = 4;
+static const uint64_t regression_seed = 1;
+
+// Mixes value into a 64 bit FNV-1a hash
+static void hash_value(uint64_t *hash, uint64_t value)
+{
+	*hash = (*hash ^ value) * 1099511628211ULL;
+}
+
+static uint64_t placement_hash(const partition_result_t & result)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	hash_value(&hash, result.sched);
+	for (unsigned i = 0; i < result.placement.size(); ++i)
+	{
+		const partition_placement_t & placement = result.placement[i];
+		hash_value(&hash, placement.first_core);
+		hash_value(&hash, placement.last_core);
+		hash_value(&hash, placement.priority);
+		hash_value(&hash, placement.budget);
+		hash_value(&hash, placement.budget_period);
+		for (unsigned k = 0; k < placement.segments.size(); ++k)
+		{
+			hash_value(&hash, placement.segments[k].budget);
+			hash_value(&hash, placement.segments[k].core);
+			hash_value(&hash, placement.segments[k].priority);
+		}
+	}
+	return hash;
+}
+
+static void generate(regression_variant variant, unsigned index, partition_problem_t *problem)
+{
+	taskset_rng_t rng = { taskset_seed(regression_seed, variant, index) };
+	taskset_distribution_t distribution;
+	distribution.num_cores = 2 + taskset_rng_next(&rng) % (max_cores - 1);
+	distribution.min_period = 10 * nanosec_in_millisec;
+	distribution.max_period = 1000 * nanosec_in_millisec;
+	distribution.min_deadline_ratio = variant == CONSTRAINED_DEADLINES ? 0.6 : 1;
+	distribution.max_deadline_ratio = 1;
+	distribution.heavy_fraction = (index % 4) * 0.05;
+	distribution.min_heavy_util = 1;
+	distribution.max_heavy_util = 4;
+	distribution.min_light_util = 0.01;
+	distribution.max_light_util = 0.1 + 0.4 * taskset_rng_uniform(&rng);
+	distribution.min_span_ratio = 0.05;
+	distribution.max_span_ratio = 0.3;
+	const double normalized_util = 0.3 + 0.75 * taskset_rng_uniform(&rng);
+	generate_taskset(&distribution, normalized_util * distribution.num_cores, taskset_rng_next(&rng), problem);
+
+	const unsigned num_cores = problem->num_cores;
+	if (variant == CORE_SPEEDS || variant == SPEEDS_AND_DOMAINS)
+	{
+		for (unsigned c = 0; c < num_cores; ++c) problem->core_speed.push_back(0.5 + 0.5 * (c % 3));
+	}
+	if (variant == MEMORY_DOMAINS || variant == SPEEDS_AND_DOMAINS)
+	{
+		for (unsigned c = 0; c < num_cores; ++c) problem->core_domain.push_back(c * num_domains / num_cores);
+		problem->domain_bandwidth.assign(num_domains, 300 + 100.0 * (index % 20));
+		for (unsigned i = 0; i < problem->tasks.size(); ++i)
+		{
+			if (i % 3 != 2) problem->tasks[i].bandwidth = 10 + 50 * taskset_rng_uniform(&rng);
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	const bool per_run = argc > 1 && strcmp(argv[1], "runs") == 0;
+	if ((argc > 1 && !per_run) || argc > 2)
+	{
+		fprintf(stderr, "Usage: partition_regression [runs]\n");
+		return RT_GOMP_PARTITION_REGRESSION_ARG_PARSE_ERROR;
+	}
+
+	std::vector<unsigned> num_schedulable(num_partition_options, 0), cores_used(num_partition_options, 0);
+	std::vector<uint64_t> hash(num_partition_options, 14695981039346656037ULL);
+	for (unsigned variant = 0; variant < NUM_VARIANTS; ++variant)
+	{
+		for (unsigned index = 0; index < tasksets_per_variant; ++index)
+		{
+			partition_problem_t problem;
+			generate(static_cast<regression_variant>(variant), index, &problem);
+			for (unsigned k = 0; k < num_partition_options; ++k)
+			{
+				if (partition_options[k].fit == PARTITION_OPTIMAL_FIT) continue;
+				partition_result_t result;
+				partition_run(&problem, &partition_options[k], &result);
+				const uint64_t run_hash = placement_hash(result);
+				if (per_run)
+				{
+					printf("%u %3u %-20s %d %4u %016llx\n", variant, index, partition_options[k].name, result.sched, result.cores_used,
+						static_cast<unsigned long long>(run_hash));
+				}
+				if (result.sched == PARTITION_SCHEDULABLE) num_schedulable[k] += 1;
+				cores_used[k] += result.cores_used;
+				hash_value(&hash[k], run_hash);
+			}
+		}
+	}
+
+	for (unsigned k = 0; k < num_partition_options && !per_run; ++k)
+	{
+		if (partition_options[k].fit == PARTITION_OPTIMAL_FIT) continue;
+		printf("%-20s %5u %8u %016llx\n", partition_options[k].name, num_schedulable[k], cores_used[k],
+			static_cast<unsigned long long>(hash[k]));
+	}
+	return RT_GOMP_PARTITION_REGRESSION_SUCCESS;
+}
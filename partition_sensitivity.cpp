@@ -0,0 +1,103 @@
+// Reports how much the tasks of a partitioned taskset can grow before the partition breaks.
+// Usage: partition_sensitivity taskset [topology]
+// Reads the schedule taskset.rtps written by cluster.py or partition_explorer and
+// finds the critical scaling factor of its partition (see partition_sensitivity
+// in partition.h): how far the work and span of all tasks together, and of
+// each task on its own, can be multiplied with every task still meeting its
+// deadline on the same cores at the same priorities. The margin above 1 is how
+// much profiling error or interference the deployment absorbs. With a topology
+// file that gives cpu speeds (see topology.h), tasks run at the speeds of their
+// cores. The .rtps file does not record SMT slowdowns, so a partition made with
+// an SMT policy other than ignore is analyzed without them.
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include "partition.h"
+#include "taskset_file.h"
+#include "timespec_functions.h"
+
+enum rt_gomp_partition_sensitivity_error_codes
+{
+	RT_GOMP_PARTITION_SENSITIVITY_SUCCESS,
+	RT_GOMP_PARTITION_SENSITIVITY_ARGUMENT_ERROR,
+	RT_GOMP_PARTITION_SENSITIVITY_FILE_ERROR,
+	RT_GOMP_PARTITION_SENSITIVITY_UNSCHEDULABLE_ERROR
+};
+
+static const char *schedulability_names[] = { "guaranteed schedulable", "not guaranteed schedulable", "unschedulable" };
+
+// Prints a factor with the change in work it stands for
+static void print_factor(double factor)
+{
+	printf("%8.3f %+9.1f%%", factor, 100 * (factor - 1));
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2 || argc > 3)
+	{
+		fprintf(stderr, "Usage: partition_sensitivity taskset [topology]\n");
+		return RT_GOMP_PARTITION_SENSITIVITY_ARGUMENT_ERROR;
+	}
+
+	const std::string schedule_filename = std::string(argv[1]) + ".rtps";
+	taskset_file_t taskset;
+	partition_problem_t problem;
+	partition_result_t result;
+	if (read_schedule_file(schedule_filename.c_str(), &taskset, &result) != RT_GOMP_TASKSET_FILE_SUCCESS ||
+		taskset_problem(&taskset, &problem) != RT_GOMP_TASKSET_FILE_SUCCESS)
+	{
+		return RT_GOMP_PARTITION_SENSITIVITY_FILE_ERROR;
+	}
+	if (result.sched == PARTITION_UNSCHEDULABLE || result.placement.size() != problem.tasks.size())
+	{
+		fprintf(stderr, "ERROR: %s has no partition to analyze\n", schedule_filename.c_str());
+		return RT_GOMP_PARTITION_SENSITIVITY_UNSCHEDULABLE_ERROR;
+	}
+	if (taskset.has_resources)
+	{
+		fprintf(stderr, "WARNING: Blocking on shared resources is not analyzed\n");
+	}
+
+	topology_t topology;
+	if (argc >= 3)
+	{
+		const int ret_val = std::string(argv[2]) == "sys" ? read_topology(&topology) : read_topology_file(argv[2], &topology);
+		if (ret_val != RT_GOMP_TOPOLOGY_SUCCESS) return RT_GOMP_PARTITION_SENSITIVITY_FILE_ERROR;
+		topology_speeds(&topology, problem.first_cpu, problem.num_cores, problem.core_speed);
+	}
+	partition_evaluate(&problem, &result);
+
+	double all_tasks;
+	std::vector<double> task_factor;
+	timespec start, end, elapsed;
+	get_time(&start);
+	partition_sensitivity(&problem, &result, &all_tasks, task_factor);
+	get_time(&end);
+	ts_diff(start, end, elapsed);
+
+	printf("%-30s %9s %9s %10s %8s %10s\n", "task", "cores", "priority", "slack", "factor", "margin");
+	unsigned tightest = 0;
+	for (unsigned i = 0; i < task_factor.size(); ++i)
+	{
+		const partition_placement_t & placement = result.placement[i];
+		char cores[32];
+		snprintf(cores, sizeof(cores), "%u-%u", taskset.first_core + placement.first_core, taskset.first_core + placement.last_core);
+		printf("%-30.30s %9s %9d %10.3f ", taskset.entries[i].program.c_str(), cores, placement.priority, result.task_slack[i]);
+		print_factor(task_factor[i]);
+		printf("\n");
+		if (task_factor[i] < task_factor[tightest]) tightest = i;
+	}
+	printf("Analyzed %zu tasks on %d threads in %.1f ms\n", problem.tasks.size(), omp_get_max_threads(),
+		elapsed.tv_sec * 1e3 + elapsed.tv_nsec / 1e6);
+
+	printf("The partition is %s. All tasks together: ", schedulability_names[result.sched]);
+	print_factor(all_tasks);
+	printf("\nOn its own, %s can change least: ", taskset.entries[tightest].program.c_str());
+	print_factor(task_factor[tightest]);
+	printf("\n");
+	if (all_tasks < 1) printf("Every task must shrink by the factor to meet every deadline.\n");
+	return RT_GOMP_PARTITION_SENSITIVITY_SUCCESS;
+}
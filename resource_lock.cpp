@@ -0,0 +1,292 @@
+#include "resource_lock.h"
+#include "timespec_functions.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+// Tasks whose pid is recorded in a lock, so that the references of those that
+// were killed can be taken back. Further tasks hold untracked references,
+// which a killed one leaks.
+static const unsigned max_lock_holders = 256;
+
+// The ticket counters are on separate cache lines, so that threads taking a
+// ticket do not disturb the line that waiting threads spin on
+typedef struct
+{
+	unsigned next_ticket;
+	char pad_next_ticket[64 - sizeof(unsigned)];
+	unsigned now_serving;
+	char pad_now_serving[64 - sizeof(unsigned)];
+	size_t data_size;
+	unsigned references;
+	// Tasks that have the lock open, 0 in free slots
+	pid_t holders[max_lock_holders];
+}
+lock_header_t;
+
+// The references of a lock while the task taking the first one resets it
+static const unsigned references_resetting = 1U << 31;
+static const timespec reset_poll_interval = {0, 500000};
+
+// Spins before a waiting thread that could not be boosted yields the processor
+static const unsigned spins_before_yield = 1000;
+
+static std::vector<resource_lock_t *> open_locks;
+
+// Boosting state of the calling thread. Nested requests boost only once.
+static __thread unsigned boost_depth = 0;
+static __thread int saved_policy;
+static __thread sched_param saved_param;
+static __thread bool boosted;
+
+static size_t round_up(size_t value, size_t multiple)
+{
+	return (value + multiple - 1) / multiple * multiple;
+}
+
+static unsigned long long now_ns()
+{
+	timespec ts;
+	get_time(&ts);
+	return (unsigned long long) ts.tv_sec * nanosec_in_sec + ts.tv_nsec;
+}
+
+static volatile lock_header_t *get_header(const resource_lock_t *lock)
+{
+	return static_cast<lock_header_t *>(lock->mapping);
+}
+
+// Whether a process exists. A pid reused by another process counts as alive,
+// which only keeps a reference that could have been taken back.
+static bool process_alive(pid_t pid)
+{
+	return kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+// Takes back the references of recorded tasks that were killed without closing
+// the lock. Of several tasks finding the same one, only the one that clears its
+// slot drops its reference.
+static void reclaim_references(volatile lock_header_t *header, const char *name)
+{
+	for (unsigned i = 0; i < max_lock_holders; ++i)
+	{
+		const pid_t pid = header->holders[i];
+		if (pid == 0 || process_alive(pid)) continue;
+		if (__sync_bool_compare_and_swap(&header->holders[i], pid, 0))
+		{
+			fprintf(stderr, "WARNING: Taking back the reference to resource lock %s of task %d, which no longer exists\n", name, (int) pid);
+			__sync_sub_and_fetch(&header->references, 1);
+		}
+	}
+}
+
+// Takes a reference to the lock and records the calling task, if a slot is
+// free. The task that takes the first one serves the tickets that killed tasks
+// left waiting or holding the lock, while the others wait.
+static void take_reference(volatile lock_header_t *header)
+{
+	unsigned references = header->references;
+	while (true)
+	{
+		if (references == references_resetting)
+		{
+			nanosleep(&reset_poll_interval, NULL);
+			references = header->references;
+			continue;
+		}
+		const unsigned previous = __sync_val_compare_and_swap(&header->references, references,
+			references == 0 ? references_resetting : references + 1);
+		if (previous == references) break;
+		references = previous;
+	}
+	if (references == 0)
+	{
+		header->now_serving = header->next_ticket;
+		__sync_synchronize();
+		header->references = 1;
+	}
+
+	const pid_t pid = getpid();
+	for (unsigned i = 0; i < max_lock_holders; ++i)
+	{
+		if (__sync_bool_compare_and_swap(&header->holders[i], 0, pid)) break;
+	}
+}
+
+static void boost_priority()
+{
+	if (boost_depth++ > 0) return;
+
+	boosted = false;
+	if (pthread_getschedparam(pthread_self(), &saved_policy, &saved_param) == 0)
+	{
+		sched_param boost;
+		boost.sched_priority = sched_get_priority_max(SCHED_FIFO);
+		boosted = (pthread_setschedparam(pthread_self(), SCHED_FIFO, &boost) == 0);
+	}
+}
+
+static void restore_priority()
+{
+	if (--boost_depth > 0) return;
+
+	if (boosted) pthread_setschedparam(pthread_self(), saved_policy, &saved_param);
+}
+
+int resource_lock_open(resource_lock_t *lock, const char *name, size_t data_size)
+{
+	memset(lock, 0, sizeof(*lock));
+	snprintf(lock->name, sizeof(lock->name), "%s", name);
+	lock->data_size = data_size;
+	lock->mapping_size = round_up(sizeof(lock_header_t), 64) + round_up(data_size, 64);
+
+	int fd = shm_open(name, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+	if (fd == -1)
+	{
+		fprintf(stderr, "ERROR: resource_lock call to shm_open failed for name %s: %s\n", name, strerror(errno));
+		return RT_GOMP_RESOURCE_LOCK_SHM_OPEN_FAILED_ERROR;
+	}
+
+	// A zero filled header is an unlocked lock, so whichever task comes first
+	// only has to size the file
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) == 0 && file_stat.st_size != 0 && file_stat.st_size != (off_t) lock->mapping_size)
+	{
+		fprintf(stderr, "ERROR: Resource lock %s was opened with a different data size\n", name);
+		close(fd);
+		return RT_GOMP_RESOURCE_LOCK_MISMATCH_ERROR;
+	}
+	if (ftruncate(fd, lock->mapping_size) == -1)
+	{
+		perror("ERROR: resource_lock call to ftruncate failed");
+		close(fd);
+		return RT_GOMP_RESOURCE_LOCK_FTRUNCATE_FAILED_ERROR;
+	}
+
+	void *mapping = mmap(NULL, lock->mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (close(fd) == -1)
+	{
+		perror("WARNING: resource_lock call to close file descriptor failed");
+	}
+	if (mapping == MAP_FAILED)
+	{
+		perror("ERROR: resource_lock call to mmap failed");
+		return RT_GOMP_RESOURCE_LOCK_MMAP_FAILED_ERROR;
+	}
+	lock->mapping = mapping;
+	lock->data = static_cast<char *>(mapping) + round_up(sizeof(lock_header_t), 64);
+
+	volatile lock_header_t *header = get_header(lock);
+	const size_t previous = __sync_val_compare_and_swap(&header->data_size, 0, data_size);
+	if (previous != 0 && previous != data_size)
+	{
+		fprintf(stderr, "ERROR: Resource lock %s was opened with a different data size\n", name);
+		munmap(lock->mapping, lock->mapping_size);
+		lock->mapping = NULL;
+		return RT_GOMP_RESOURCE_LOCK_MISMATCH_ERROR;
+	}
+
+	reclaim_references(header, name);
+	take_reference(header);
+	open_locks.push_back(lock);
+	return RT_GOMP_RESOURCE_LOCK_SUCCESS;
+}
+
+void resource_lock_close(resource_lock_t *lock)
+{
+	if (lock->mapping == NULL) return;
+
+	// The last task to close the lock removes it
+	volatile lock_header_t *header = get_header(lock);
+	const pid_t pid = getpid();
+	for (unsigned i = 0; i < max_lock_holders; ++i)
+	{
+		if (__sync_bool_compare_and_swap(&header->holders[i], pid, 0)) break;
+	}
+	if (__sync_sub_and_fetch(&header->references, 1) == 0)
+	{
+		if (shm_unlink(lock->name) == -1 && errno != ENOENT)
+		{
+			perror("WARNING: resource_lock call to shm_unlink failed");
+		}
+	}
+
+	if (munmap(lock->mapping, lock->mapping_size) == -1)
+	{
+		perror("WARNING: resource_lock call to munmap failed");
+	}
+	lock->mapping = NULL;
+	lock->data = NULL;
+	open_locks.erase(std::remove(open_locks.begin(), open_locks.end(), lock), open_locks.end());
+}
+
+void resource_lock_acquire(resource_lock_t *lock)
+{
+	volatile lock_header_t *header = get_header(lock);
+
+	boost_priority();
+	const unsigned long long request_ns = now_ns();
+	const unsigned ticket = __sync_fetch_and_add(&header->next_ticket, 1);
+	const unsigned queue_length = ticket - header->now_serving;
+
+	unsigned spins = 0;
+	while (header->now_serving != ticket)
+	{
+		__builtin_ia32_pause();
+		if (!boosted && ++spins == spins_before_yield)
+		{
+			sched_yield();
+			spins = 0;
+		}
+	}
+	__sync_synchronize();
+
+	// The statistics are updated inside the critical section
+	lock->acquired_ns = now_ns();
+	const unsigned long long wait_ns = lock->acquired_ns - request_ns;
+	lock->acquisitions += 1;
+	lock->total_wait_ns += wait_ns;
+	lock->max_wait_ns = std::max(lock->max_wait_ns, wait_ns);
+	lock->max_queue_length = std::max(lock->max_queue_length, queue_length);
+	if (!boosted) lock->boost_failures += 1;
+}
+
+void resource_lock_release(resource_lock_t *lock)
+{
+	volatile lock_header_t *header = get_header(lock);
+
+	const unsigned long long hold_ns = now_ns() - lock->acquired_ns;
+	lock->total_hold_ns += hold_ns;
+	lock->max_hold_ns = std::max(lock->max_hold_ns, hold_ns);
+
+	__sync_synchronize();
+	header->now_serving = header->now_serving + 1;
+	restore_priority();
+}
+
+void report_resource_locks(const char *task_name)
+{
+	for (size_t i = 0; i < open_locks.size(); ++i)
+	{
+		const resource_lock_t *lock = open_locks[i];
+		const unsigned long n = lock->acquisitions > 0 ? lock->acquisitions : 1;
+		fprintf(stderr, "Resource %s for task %s: %lu requests, wait mean %llu max %llu ns, hold mean %llu max %llu ns, max %u requests ahead\n",
+		        lock->name, task_name, lock->acquisitions, lock->total_wait_ns / n, lock->max_wait_ns,
+		        lock->total_hold_ns / n, lock->max_hold_ns, lock->max_queue_length);
+		if (lock->boost_failures > 0)
+		{
+			fprintf(stderr, "WARNING: %lu requests for resource %s by task %s could not be priority boosted\n",
+			        lock->boost_failures, lock->name, task_name);
+		}
+	}
+}
@@ -0,0 +1,82 @@
+#ifndef RT_GOMP_RESOURCE_LOCK_H
+#define RT_GOMP_RESOURCE_LOCK_H
+
+#include <stddef.h>
+
+// Locks for data shared by tasks on different clusters, following the spin
+// based variant of FMLP+ (and MSRP) for short critical sections:
+//
+//  - A thread is boosted to the highest SCHED_FIFO priority before it requests
+//    a resource and stays boosted until it releases it, so neither spinning nor
+//    the critical section can be preempted by other tasks on its core.
+//  - Waiting threads are served in FIFO order by a ticket lock. Since each core
+//    runs at most one boosted request at a time, a request waits for at most
+//    one critical section per other core that uses the resource.
+//
+// Together these bound the blocking of every job, which cluster.py accounts for
+// when it tests schedulability (see the resource annotations in README).
+// Unbounded blocking from priority inversion, as with pthread mutexes, cannot
+// occur.
+//
+// Each lock can carry a block of shared data that it protects, which is zero
+// filled when the lock is first created. Tasks open their locks in task.init.
+// Locks are reference counted and removed from /dev/shm when the last task
+// closes them. Tasks record their pid in the lock, so a task opening it takes
+// back the references of tasks that were killed, and the first task to open a
+// lock that only killed tasks had open frees it from their requests. A task
+// killed while it holds or waits for the lock still blocks the others of its
+// taskset. Wait and hold times are recorded per task and reported by
+// task_manager at the end of the run.
+//
+// Boosting requires real-time privileges. Without them a waiting thread yields
+// the processor while it spins, so tasks still make progress when testing
+// without privileges, but the blocking bound does not hold.
+
+enum rt_gomp_resource_lock_error_codes
+{
+	RT_GOMP_RESOURCE_LOCK_SUCCESS,
+	RT_GOMP_RESOURCE_LOCK_SHM_OPEN_FAILED_ERROR,
+	RT_GOMP_RESOURCE_LOCK_FTRUNCATE_FAILED_ERROR,
+	RT_GOMP_RESOURCE_LOCK_MMAP_FAILED_ERROR,
+	RT_GOMP_RESOURCE_LOCK_MISMATCH_ERROR
+};
+
+typedef struct
+{
+	void *mapping;
+	size_t mapping_size;
+	// The shared data protected by the lock
+	void *data;
+	size_t data_size;
+	char name[64];
+
+	// Statistics of this task's requests. They are only updated while the lock
+	// is held, so they need no synchronization between threads.
+	unsigned long long acquired_ns;
+	unsigned long acquisitions;
+	unsigned long long total_wait_ns, max_wait_ns;
+	unsigned long long total_hold_ns, max_hold_ns;
+	unsigned max_queue_length;
+	unsigned long boost_failures;
+}
+resource_lock_t;
+
+// Opens the lock called name, creating it if no task has opened it yet, along
+// with data_size bytes of shared data (which may be zero). Every task must pass
+// the same data size.
+int resource_lock_open(resource_lock_t *lock, const char *name, size_t data_size);
+
+// Closes the lock and removes it from /dev/shm once no task has it open
+void resource_lock_close(resource_lock_t *lock);
+
+// Acquires and releases the lock. Any thread of a task may request a lock, and
+// a thread may hold several locks at a time if every task acquires them in the
+// same order. Critical sections should be short and must not suspend.
+void resource_lock_acquire(resource_lock_t *lock);
+void resource_lock_release(resource_lock_t *lock);
+
+// Prints the wait and hold time statistics of every lock the calling process
+// has open, for the end of run report of a task
+void report_resource_locks(const char *task_name);
+
+#endif /* RT_GOMP_RESOURCE_LOCK_H */
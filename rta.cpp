@@ -0,0 +1,167 @@
+#include "rta.h"
+#include <limits.h>
+
+// Priority of budget reservations, above any SCHED_FIFO priority
+static const int reservation_priority = INT_MAX;
+
+int64_t rta_response_time(const rta_task_t *tasks, unsigned num_interfering, unsigned self, int64_t work, int64_t deadline, int64_t start)
+{
+	int64_t response = start > work ? start : work;
+	while (response <= deadline)
+	{
+		int64_t demand = work;
+		for (unsigned j = 0; j < num_interfering; ++j)
+		{
+			if (j == self) continue;
+			demand += (response + tasks[j].jitter + tasks[j].period - 1) / tasks[j].period * tasks[j].work;
+		}
+		if (demand == response) break;
+		response = demand;
+	}
+	return response;
+}
+
+rta_core_t *rta_core_create()
+{
+	rta_core_t *core = new rta_core_t;
+	core->schedulable = true;
+	return core;
+}
+
+void rta_core_destroy(rta_core_t *core)
+{
+	delete core;
+}
+
+// Returns the end of the run of tasks with the same priority as tasks[position]
+static unsigned priority_level_end(const std::vector<rta_task_t> & tasks, unsigned position)
+{
+	unsigned end = position + 1;
+	while (end < tasks.size() && tasks[end].priority == tasks[position].priority) ++end;
+	return end;
+}
+
+// Inserts the task after all tasks of higher or equal priority and updates the
+// response times of the tasks it can delay. If commit_on_failure is false and a deadline is
+// missed, the core is restored. Returns whether all deadlines are met.
+static bool add_task(rta_core_t *core, int64_t work, int64_t period, int64_t deadline, int64_t jitter, int priority, bool commit_on_failure)
+{
+	std::vector<rta_task_t> & tasks = core->tasks;
+	unsigned position = 0;
+	while (position < tasks.size() && tasks[position].priority >= priority) ++position;
+
+	rta_task_t task = { work, period, deadline, jitter, priority, 0 };
+	tasks.insert(tasks.begin() + position, task);
+
+	// The new task's response time depends only on the tasks above it and at its level
+	bool schedulable = true;
+	std::vector<int64_t> previous;
+	tasks[position].response = rta_response_time(&tasks[0], priority_level_end(tasks, position), position, work, deadline, 0);
+	if (tasks[position].response > deadline) schedulable = false;
+
+	// The tasks at its level and below gain one more interfering task, so their
+	// response times grow by at least its work
+	unsigned first_affected = position;
+	while (first_affected > 0 && tasks[first_affected - 1].priority == priority) --first_affected;
+	for (unsigned i = first_affected; i < tasks.size() && (schedulable || commit_on_failure); ++i)
+	{
+		if (i == position) continue;
+		previous.push_back(tasks[i].response);
+		tasks[i].response = rta_response_time(&tasks[0], priority_level_end(tasks, i), i, tasks[i].work, tasks[i].deadline, tasks[i].response + work);
+		if (tasks[i].response > tasks[i].deadline) schedulable = false;
+	}
+
+	if (!schedulable && !commit_on_failure)
+	{
+		unsigned restored = 0;
+		for (unsigned i = first_affected; restored < previous.size(); ++i)
+		{
+			if (i == position) continue;
+			tasks[i].response = previous[restored++];
+		}
+		tasks.erase(tasks.begin() + position);
+		return false;
+	}
+
+	core->schedulable = core->schedulable && schedulable;
+	return schedulable;
+}
+
+int rta_core_try_add(rta_core_t *core, int64_t work, int64_t period, int64_t deadline, int priority)
+{
+	if (!core->schedulable) return 0;
+	return add_task(core, work, period, deadline, 0, priority, false);
+}
+
+int rta_core_force_add(rta_core_t *core, int64_t work, int64_t period, int64_t deadline, int priority)
+{
+	add_task(core, work, period, deadline, 0, priority, true);
+	return core->schedulable;
+}
+
+int rta_core_add_reservation(rta_core_t *core, int64_t budget, int64_t period)
+{
+	add_task(core, budget, period, period, period - budget, reservation_priority, true);
+	return core->schedulable;
+}
+
+int rta_core_schedulable(const rta_core_t *core)
+{
+	return core->schedulable;
+}
+
+int rta_core_assign_priorities(rta_core_t *core, unsigned *order)
+{
+	const std::vector<rta_task_t> & tasks = core->tasks;
+	unsigned num_reservations = 0;
+	while (num_reservations < tasks.size() && tasks[num_reservations].priority == reservation_priority) ++num_reservations;
+
+	// Positions of the tasks not yet assigned a level, in the current order,
+	// and those tasks, which interfere with the candidate for the level
+	std::vector<unsigned> unassigned(tasks.size());
+	for (unsigned i = 0; i < tasks.size(); ++i) unassigned[i] = i;
+	std::vector<rta_task_t> above;
+	std::vector<int64_t> response(tasks.size());
+	for (unsigned i = 0; i < num_reservations; ++i)
+	{
+		order[i] = i;
+		response[i] = tasks[i].response;
+	}
+
+	for (unsigned level = tasks.size(); level > num_reservations; --level)
+	{
+		above.clear();
+		for (unsigned k = 0; k < unassigned.size(); ++k) above.push_back(tasks[unassigned[k]]);
+
+		unsigned k = unassigned.size();
+		for (; k > num_reservations; --k)
+		{
+			const rta_task_t & candidate = above[k - 1];
+			const int64_t bound = rta_response_time(&above[0], above.size(), k - 1, candidate.work, candidate.deadline, 0);
+			if (bound <= candidate.deadline)
+			{
+				order[level - 1] = unassigned[k - 1];
+				response[unassigned[k - 1]] = bound;
+				unassigned.erase(unassigned.begin() + (k - 1));
+				break;
+			}
+		}
+		if (k == num_reservations) return 0;
+	}
+
+	std::vector<rta_task_t> reordered(tasks.size());
+	for (unsigned k = 0; k < tasks.size(); ++k)
+	{
+		reordered[k] = tasks[order[k]];
+		reordered[k].priority = tasks[k].priority;
+		reordered[k].response = response[order[k]];
+	}
+	core->tasks.swap(reordered);
+	core->schedulable = true;
+	return 1;
+}
+
+int64_t rta_core_response_time(const rta_core_t *core, unsigned position)
+{
+	return position < core->tasks.size() ? core->tasks[position].response : -1;
+}
@@ -0,0 +1,88 @@
+#ifndef RT_GOMP_RTA_H
+#define RT_GOMP_RTA_H
+
+#include <stdint.h>
+#include <vector>
+
+// Exact response time analysis for sequential tasks under preemptive fixed
+// priority scheduling on one core, used as the admission test when cluster.py
+// packs light tasks onto cores.
+//
+// A core keeps its tasks in priority order with their last computed response
+// times. Adding a task computes its response time from the interference of the
+// higher priority tasks and then updates only the lower priority tasks, each
+// starting from its previous response time plus the new task's work, which is a
+// lower bound on the new fixed point. Every iteration stops as soon as the
+// response time exceeds the deadline. Deadlines may be shorter than periods
+// but not longer, so that each job finishes before the next one is released.
+//
+// A budget reservation (see budget_reservation.h) on the core preempts every
+// task. It may run its budget at the end of one period and again at the start
+// of the next, so it is analyzed as a task with release jitter period - budget.
+//
+// The functions are exported with C linkage so that lib_cluster.py can call
+// them through ctypes from libpartition.so. Times are integers (nanoseconds).
+
+typedef struct
+{
+	int64_t work;
+	int64_t period;
+	int64_t deadline;
+	// Release jitter: the task interferes ceil((R+jitter)/period) times in R
+	int64_t jitter;
+	int priority;
+	int64_t response;
+}
+rta_task_t;
+
+typedef struct
+{
+	// Highest priority first. Tasks of equal priority are served FIFO, so each
+	// is treated as interfering with the other.
+	std::vector<rta_task_t> tasks;
+	bool schedulable;
+}
+rta_core_t;
+
+extern "C"
+{
+
+rta_core_t *rta_core_create();
+void rta_core_destroy(rta_core_t *core);
+
+// Adds a task if every task on the core still meets its deadline and returns
+// 1, otherwise leaves the core unchanged and returns 0
+int rta_core_try_add(rta_core_t *core, int64_t work, int64_t period, int64_t deadline, int priority);
+
+// Adds a task regardless of the outcome and returns whether the core is schedulable
+int rta_core_force_add(rta_core_t *core, int64_t work, int64_t period, int64_t deadline, int priority);
+
+// Adds a budget reservation above every task regardless of the outcome and
+// returns whether the core is schedulable
+int rta_core_add_reservation(rta_core_t *core, int64_t budget, int64_t period);
+
+int rta_core_schedulable(const rta_core_t *core);
+
+// Audsley's optimal priority assignment. Gives the priorities that the tasks on
+// the core have now, other than those of reservations, to the tasks in a new
+// order: from the lowest level up, each level goes to the lowest task in the
+// current order that meets its deadline with every task not yet assigned above
+// it. A response time only depends on the set of tasks above, so this finds an
+// order that meets every deadline whenever there is one, and keeps the current
+// order if it is one. Priorities should be distinct. On success order[k]
+// receives the former position of the task now at position k and 1 is
+// returned; otherwise the core is unchanged and 0 is returned.
+int rta_core_assign_priorities(rta_core_t *core, unsigned *order);
+
+// Returns the response time bound of the task at the given priority position,
+// which is only meaningful if it does not exceed the task's deadline
+int64_t rta_core_response_time(const rta_core_t *core, unsigned position);
+
+}
+
+// Computes the response time of a task with the given work from the interference
+// of tasks[0, num_interfering) other than tasks[self], starting the iteration at
+// start. Stops early and returns a value above deadline if the task cannot meet it.
+int64_t rta_response_time(const rta_task_t *tasks, unsigned num_interfering, unsigned self, int64_t work, int64_t deadline, int64_t start);
+
+#endif /* RT_GOMP_RTA_H */
@@ -0,0 +1,17 @@
+#!/bin/bash
+
+# Profiles each of the benchmark tasks in turn. Adjust the task arguments
+# to change the problem sizes.
+
+first_core=0
+last_core=3
+bucket_width_sec=0
+bucket_width_ns=100000
+num_repetitions=100
+
+./gemm_task_utilization $first_core $last_core $bucket_width_sec $bucket_width_ns $num_repetitions 512
+./stencil_task_utilization $first_core $last_core $bucket_width_sec $bucket_width_ns $num_repetitions 1024 1024 10
+./spmv_task_utilization $first_core $last_core $bucket_width_sec $bucket_width_ns $num_repetitions 1000000 16
+./fft_task_utilization $first_core $last_core $bucket_width_sec $bucket_width_ns $num_repetitions 20
+./sort_task_utilization $first_core $last_core $bucket_width_sec $bucket_width_ns $num_repetitions 1000000
+./bfs_task_utilization $first_core $last_core $bucket_width_sec $bucket_width_ns $num_repetitions 1000000 8
@@ -0,0 +1,347 @@
+#include "shared_segment.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <string.h>
+
+// Instances whose pid is recorded in a segment, so that the references of those
+// that were killed can be taken back. Further instances hold untracked
+// references, which a killed one leaks as before.
+static const unsigned max_holders = 256;
+
+// The header lives in the page after the data, so that the data starts at the
+// beginning of the file and can be backed by huge pages where tmpfs allows it
+typedef struct
+{
+	size_t size;
+	unsigned state;
+	unsigned references;
+	// The instance filling the segment, and those holding a reference, 0 in
+	// free slots
+	pid_t creator;
+	pid_t holders[max_holders];
+}
+segment_header_t;
+
+enum segment_state
+{
+	SEGMENT_FILLING,
+	SEGMENT_READY,
+	SEGMENT_FAILED,
+	// The creator died while filling it; it is being unlinked
+	SEGMENT_STALE
+};
+
+// Instances poll every half millisecond, like single_use_barrier, and give up on
+// a segment that is not ready within a minute, which most likely was left behind
+// in /dev/shm by an instance that died before it could be told apart by its pid.
+static const timespec poll_interval = {0, 500000};
+static const unsigned max_polls = 120000;
+
+static size_t round_up(size_t value, size_t multiple)
+{
+	return (value + multiple - 1) / multiple * multiple;
+}
+
+static volatile segment_header_t *get_header(const shared_segment_t *segment)
+{
+	const size_t page_size = sysconf(_SC_PAGESIZE);
+	return reinterpret_cast<segment_header_t *>(static_cast<char *>(segment->mapping) + segment->mapping_size - page_size);
+}
+
+// Whether a process exists. A pid reused by another process counts as alive,
+// which only keeps a reference that could have been taken back.
+static bool process_alive(pid_t pid)
+{
+	return kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+// Records the calling instance as a holder of the segment, if a slot is free
+static void add_holder(volatile segment_header_t *header)
+{
+	const pid_t pid = getpid();
+	for (unsigned i = 0; i < max_holders; ++i)
+	{
+		if (__sync_bool_compare_and_swap(&header->holders[i], 0, pid)) return;
+	}
+}
+
+static void remove_holder(volatile segment_header_t *header)
+{
+	const pid_t pid = getpid();
+	for (unsigned i = 0; i < max_holders; ++i)
+	{
+		if (__sync_bool_compare_and_swap(&header->holders[i], pid, 0)) return;
+	}
+}
+
+// Drops a reference and unlinks the name with the last one. An instance that
+// opens the name afterwards sees no references and creates a new segment.
+static void drop_reference(volatile segment_header_t *header, const char *name)
+{
+	if (__sync_sub_and_fetch(&header->references, 1) == 0)
+	{
+		if (shm_unlink(name) == -1 && errno != ENOENT)
+		{
+			perror("WARNING: shared_segment call to shm_unlink failed");
+		}
+	}
+}
+
+// Takes back the references of recorded holders that no longer exist. Of
+// several instances finding the same one, only the one that clears its slot
+// drops its reference.
+static void reclaim_references(volatile segment_header_t *header, const char *name)
+{
+	for (unsigned i = 0; i < max_holders; ++i)
+	{
+		const pid_t pid = header->holders[i];
+		if (pid == 0 || process_alive(pid)) continue;
+		if (__sync_bool_compare_and_swap(&header->holders[i], pid, 0))
+		{
+			fprintf(stderr, "WARNING: Taking back the reference to shared segment %s of instance %d, which no longer exists\n", name, (int) pid);
+			drop_reference(header, name);
+		}
+	}
+}
+
+static int map_segment(shared_segment_t *segment, int fd, const char *name)
+{
+	segment->mapping = mmap(NULL, segment->mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (segment->mapping == MAP_FAILED)
+	{
+		fprintf(stderr, "ERROR: shared_segment call to mmap failed for name %s: %s\n", name, strerror(errno));
+		segment->mapping = NULL;
+		return RT_GOMP_SHARED_SEGMENT_MMAP_FAILED_ERROR;
+	}
+	return RT_GOMP_SHARED_SEGMENT_SUCCESS;
+}
+
+static void unmap_segment(shared_segment_t *segment)
+{
+	if (munmap(segment->mapping, segment->mapping_size) == -1)
+	{
+		perror("WARNING: shared_segment call to munmap failed");
+	}
+	segment->mapping = NULL;
+	segment->data = NULL;
+}
+
+static void close_descriptor(int fd)
+{
+	if (close(fd) == -1)
+	{
+		perror("WARNING: shared_segment call to close file descriptor failed");
+	}
+}
+
+// Creates the segment from the descriptor returned by an exclusive shm_open and fills it
+static int create_segment(shared_segment_t *segment, int fd, const char *name, shared_segment_fill_t fill, void *arg)
+{
+	if (ftruncate(fd, segment->mapping_size) == -1)
+	{
+		perror("ERROR: shared_segment call to ftruncate failed");
+		close_descriptor(fd);
+		shm_unlink(name);
+		return RT_GOMP_SHARED_SEGMENT_FTRUNCATE_FAILED_ERROR;
+	}
+
+	int ret_val = map_segment(segment, fd, name);
+	close_descriptor(fd);
+	if (ret_val != 0)
+	{
+		shm_unlink(name);
+		return ret_val;
+	}
+
+	// The file is zero filled, so the state already reads SEGMENT_FILLING
+	volatile segment_header_t *header = get_header(segment);
+	header->size = segment->size;
+	header->creator = getpid();
+	header->references = 1;
+	add_holder(header);
+
+	const size_t data_bytes = segment->mapping_size - sysconf(_SC_PAGESIZE);
+	madvise(segment->mapping, data_bytes, MADV_HUGEPAGE);
+
+	if (fill(segment->mapping, segment->size, arg) != 0)
+	{
+		fprintf(stderr, "ERROR: Failed to fill shared segment %s\n", name);
+		header->state = SEGMENT_FAILED;
+		shm_unlink(name);
+		unmap_segment(segment);
+		return RT_GOMP_SHARED_SEGMENT_FILL_FAILED_ERROR;
+	}
+
+	mprotect(segment->mapping, data_bytes, PROT_READ);
+	__sync_synchronize();
+	header->state = SEGMENT_READY;
+
+	segment->data = segment->mapping;
+	segment->created = true;
+	return RT_GOMP_SHARED_SEGMENT_SUCCESS;
+}
+
+// Joins a segment created by another instance. Sets *retry if the segment was
+// being torn down, in which case the caller should try to create it again.
+static int join_segment(shared_segment_t *segment, int fd, const char *name, bool *retry)
+{
+	*retry = false;
+
+	// The creator may not have sized the file yet
+	struct stat file_stat;
+	unsigned polls = 0;
+	while (fstat(fd, &file_stat) == 0 && file_stat.st_size == 0 && polls++ < max_polls)
+	{
+		nanosleep(&poll_interval, NULL);
+	}
+	if (file_stat.st_size != (off_t) segment->mapping_size)
+	{
+		fprintf(stderr, "ERROR: Shared segment %s exists with a different size or was never sized. Perhaps it is stale in /dev/shm?\n", name);
+		close_descriptor(fd);
+		return RT_GOMP_SHARED_SEGMENT_SIZE_MISMATCH_ERROR;
+	}
+
+	int ret_val = map_segment(segment, fd, name);
+	close_descriptor(fd);
+	if (ret_val != 0) return ret_val;
+
+	volatile segment_header_t *header = get_header(segment);
+	if (header->size != segment->size)
+	{
+		fprintf(stderr, "ERROR: Shared segment %s holds %zu bytes, expected %zu\n", name, header->size, segment->size);
+		unmap_segment(segment);
+		return RT_GOMP_SHARED_SEGMENT_SIZE_MISMATCH_ERROR;
+	}
+
+	// Take a reference unless the last instance has already dropped the segment,
+	// after taking back those of killed instances
+	reclaim_references(header, name);
+	unsigned references = header->references;
+	while (references != 0)
+	{
+		const unsigned previous = __sync_val_compare_and_swap(&header->references, references, references + 1);
+		if (previous == references) break;
+		references = previous;
+	}
+	if (references == 0)
+	{
+		unmap_segment(segment);
+		*retry = true;
+		return RT_GOMP_SHARED_SEGMENT_SUCCESS;
+	}
+
+	add_holder(header);
+
+	// If the creator died while filling the segment, the first instance to see
+	// it marks it stale and unlinks the name, and every instance tries again
+	polls = 0;
+	while (header->state == SEGMENT_FILLING && polls++ < max_polls)
+	{
+		if (!process_alive(header->creator) &&
+			__sync_bool_compare_and_swap(&header->state, SEGMENT_FILLING, SEGMENT_STALE))
+		{
+			fprintf(stderr, "WARNING: Instance %d died while filling shared segment %s, creating it again\n", (int) header->creator, name);
+			if (shm_unlink(name) == -1 && errno != ENOENT)
+			{
+				perror("WARNING: shared_segment call to shm_unlink failed");
+			}
+		}
+		nanosleep(&poll_interval, NULL);
+	}
+	if (header->state == SEGMENT_STALE)
+	{
+		unmap_segment(segment);
+		*retry = true;
+		return RT_GOMP_SHARED_SEGMENT_SUCCESS;
+	}
+
+	if (header->state != SEGMENT_READY)
+	{
+		if (header->state == SEGMENT_FILLING)
+		{
+			fprintf(stderr, "ERROR: Timed out waiting for shared segment %s. Perhaps it is stale in /dev/shm?\n", name);
+			ret_val = RT_GOMP_SHARED_SEGMENT_TIMEOUT_ERROR;
+		}
+		else
+		{
+			fprintf(stderr, "ERROR: The instance creating shared segment %s failed to fill it\n", name);
+			ret_val = RT_GOMP_SHARED_SEGMENT_FILL_FAILED_ERROR;
+		}
+		remove_holder(header);
+		__sync_sub_and_fetch(&header->references, 1);
+		unmap_segment(segment);
+		return ret_val;
+	}
+	__sync_synchronize();
+
+	const size_t data_bytes = segment->mapping_size - sysconf(_SC_PAGESIZE);
+	mprotect(segment->mapping, data_bytes, PROT_READ);
+
+	segment->data = segment->mapping;
+	segment->created = false;
+	return RT_GOMP_SHARED_SEGMENT_SUCCESS;
+}
+
+int shared_segment_open(shared_segment_t *segment, const char *name, size_t size, shared_segment_fill_t fill, void *arg)
+{
+	segment->data = NULL;
+	segment->size = size;
+	segment->mapping = NULL;
+	segment->created = false;
+
+	if (size == 0 || fill == NULL)
+	{
+		fprintf(stderr, "ERROR: A shared segment needs a size and a fill function");
+		return RT_GOMP_SHARED_SEGMENT_INVALID_VALUE_ERROR;
+	}
+
+	const size_t page_size = sysconf(_SC_PAGESIZE);
+	segment->mapping_size = round_up(size, page_size) + page_size;
+
+	for (unsigned attempts = 0; attempts < max_polls; ++attempts)
+	{
+		int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+		if (fd != -1)
+		{
+			return create_segment(segment, fd, name, fill, arg);
+		}
+		if (errno != EEXIST)
+		{
+			fprintf(stderr, "ERROR: shared_segment call to shm_open failed for name %s: %s\n", name, strerror(errno));
+			return RT_GOMP_SHARED_SEGMENT_SHM_OPEN_FAILED_ERROR;
+		}
+
+		fd = shm_open(name, O_RDWR, 0);
+		if (fd == -1)
+		{
+			// The segment was unlinked between the two calls, so try to create it
+			if (errno == ENOENT) continue;
+			fprintf(stderr, "ERROR: shared_segment call to shm_open failed for name %s: %s\n", name, strerror(errno));
+			return RT_GOMP_SHARED_SEGMENT_SHM_OPEN_FAILED_ERROR;
+		}
+
+		bool retry;
+		int ret_val = join_segment(segment, fd, name, &retry);
+		if (!retry) return ret_val;
+		nanosleep(&poll_interval, NULL);
+	}
+
+	fprintf(stderr, "ERROR: Timed out opening shared segment %s\n", name);
+	return RT_GOMP_SHARED_SEGMENT_TIMEOUT_ERROR;
+}
+
+void shared_segment_close(shared_segment_t *segment, const char *name)
+{
+	if (segment->mapping == NULL) return;
+
+	volatile segment_header_t *header = get_header(segment);
+	remove_holder(header);
+	drop_reference(header, name);
+	unmap_segment(segment);
+}
@@ -0,0 +1,60 @@
+#ifndef RT_GOMP_SHARED_SEGMENT_H
+#define RT_GOMP_SHARED_SEGMENT_H
+
+#include <stddef.h>
+
+// Read-only data shared by all instances of a task program. A taskset often runs
+// several instances of the same program on the same inputs (weights, lookup
+// tables, matrices). Instead of every instance building its own copy, the first
+// instance to open a named segment creates it in POSIX shared memory and fills
+// it, and every instance, including the first, maps the data read-only. The
+// other instances wait in init until the data is ready, so a taskset holds one
+// copy in memory and in the shared last level cache.
+//
+// Segments are reference counted and unlinked from /dev/shm when the last
+// instance closes them. Instances record their pid in the segment, so that one
+// opening it takes back the references of instances that were killed, and
+// creates it again if its creator died while filling it. The data is placed on
+// the NUMA nodes of the instance that fills it, so instances on other nodes
+// read it remotely, unless the name includes the nodes (see omp_thread_nodes
+// in first_touch.h); the NUMA report of task_manager lists shared segments
+// apart from the task's own memory (see report_numa_placement in
+// numa_placement.h).
+
+enum rt_gomp_shared_segment_error_codes
+{
+	RT_GOMP_SHARED_SEGMENT_SUCCESS,
+	RT_GOMP_SHARED_SEGMENT_INVALID_VALUE_ERROR,
+	RT_GOMP_SHARED_SEGMENT_SHM_OPEN_FAILED_ERROR,
+	RT_GOMP_SHARED_SEGMENT_FTRUNCATE_FAILED_ERROR,
+	RT_GOMP_SHARED_SEGMENT_MMAP_FAILED_ERROR,
+	RT_GOMP_SHARED_SEGMENT_SIZE_MISMATCH_ERROR,
+	RT_GOMP_SHARED_SEGMENT_FILL_FAILED_ERROR,
+	RT_GOMP_SHARED_SEGMENT_TIMEOUT_ERROR
+};
+
+// Writes the contents of a new segment. Returns zero on success. The function
+// runs in exactly one instance and may use OpenMP to fill the data in parallel.
+typedef int (*shared_segment_fill_t)(void *data, size_t size, void *arg);
+
+typedef struct
+{
+	const void *data;
+	size_t size;
+	void *mapping;
+	size_t mapping_size;
+	bool created;
+}
+shared_segment_t;
+
+// Maps the segment called name, which holds size bytes of data. If no instance
+// has created it yet, creates it and calls fill(data, size, arg); otherwise
+// waits until the creating instance has filled it. segment->created tells which
+// case happened. Instances opening the same name must agree on the size and the
+// contents, so the name should encode everything the contents depend on.
+int shared_segment_open(shared_segment_t *segment, const char *name, size_t size, shared_segment_fill_t fill, void *arg);
+
+// Unmaps the segment and unlinks it once no instance has it open
+void shared_segment_close(shared_segment_t *segment, const char *name);
+
+#endif /* RT_GOMP_SHARED_SEGMENT_H */
@@ -1,27 +1,48 @@
 // A simple matrix-vector multiplication task that uses OpenMP
-// Call the functions with the following arguments in argv: executable_name num_rows num_cols
+// Call the functions with the following arguments in argv: executable_name num_rows num_cols [kernel]
+// The optional kernel argument is one of scalar, sse2, avx2, avx512 or auto (the default),
+// see matvec.h. The scalar kernel is the unoptimized reference implementation.
+// The matrix is only read, so all instances with the same dimensions on the same
+// NUMA nodes share one copy in a shared segment (see shared_segment.h).
 
 #include <omp.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <sstream>
 #include "task.h"
+#include "matvec.h"
+#include "first_touch.h"
+#include "shared_segment.h"
+#include "trace.h"
 
-size_t M, N;
-double *matrix_1D, *vector, *result;
+size_t M, N, row_stride;
+const double *matrix_1D;
+double *vector, *result;
+char matrix_name[256];
+shared_segment_t matrix_segment;
+task_arena_t arena;
+matvec_kernel_t kernel;
 
 enum rt_gomp_simple_task_error_codes
 {
 	RT_GOMP_SIMPLE_TASK_SUCCESS,
 	RT_GOMP_SIMPLE_TASK_INVALID_ARGUMENTS,
-	RT_GOMP_SIMPLE_TASK_MEM_ALLOC_ERROR
+	RT_GOMP_SIMPLE_TASK_MEM_ALLOC_ERROR,
+	RT_GOMP_SIMPLE_TASK_UNSUPPORTED_KERNEL
 };
 
+// Zero fills the shared matrix from the threads of the instance that creates it
+static int fill_matrix(void *data, size_t size, void *arg)
+{
+	first_touch(data, M, row_stride*sizeof(double), matvec_row_tile);
+	return 0;
+}
+
 int init(int argc, char *argv[])
 {
 	// Read the matrix and vector sizes
 	if (!( 
-		argc == 3 &&
+		(argc == 3 || argc == 4) &&
 		std::istringstream(argv[1]) >> M &&
 		std::istringstream(argv[2]) >> N
 	))
@@ -30,44 +51,79 @@ int init(int argc, char *argv[])
 		return RT_GOMP_SIMPLE_TASK_INVALID_ARGUMENTS;
 	}
 	
-	// Allocate memory for the matrix and vectors
-	matrix_1D = new (std::nothrow) double[M*N];
-	if (!matrix_1D)
+	// Select the kernel
+	matvec_kernel_kind kind = MATVEC_KERNEL_AUTO;
+	if (argc == 4 && !matvec_parse_kernel_kind(argv[3], &kind))
+	{
+		fprintf(stderr, "ERROR: Unknown kernel %s", argv[3]);
+		return RT_GOMP_SIMPLE_TASK_INVALID_ARGUMENTS;
+	}
+	
+	kernel = matvec_get_kernel(kind, &kind);
+	if (!kernel)
+	{
+		fprintf(stderr, "ERROR: Kernel %s is not supported on this processor", argv[3]);
+		return RT_GOMP_SIMPLE_TASK_UNSUPPORTED_KERNEL;
+	}
+	fprintf(stderr, "Using %s matrix-vector kernel\n", matvec_kernel_name(kind));
+	
+	// Map the matrix shared by all instances with these dimensions on the same
+	// NUMA nodes, creating it if this is the first one, so that it is read from
+	// local memory. Rows are padded so that each one is aligned.
+	row_stride = matvec_row_stride(N);
+	numa_node_mask_t nodes;
+	omp_thread_nodes(&nodes);
+	int length = snprintf(matrix_name, sizeof(matrix_name), "RT_GOMP_SIMPLE_TASK_MATRIX_%zux%zu_NODES", M, N);
+	for (unsigned node = 0; node < max_numa_nodes && length < (int) sizeof(matrix_name); ++node)
+	{
+		if (numa_node_mask_isset(&nodes, node)) length += snprintf(matrix_name + length, sizeof(matrix_name) - length, "_%u", node);
+	}
+	if (shared_segment_open(&matrix_segment, matrix_name, M*row_stride*sizeof(double), fill_matrix, NULL) != 0)
 	{
 		fprintf(stderr, "ERROR: Memory allocation failed");
 		return RT_GOMP_SIMPLE_TASK_MEM_ALLOC_ERROR;
 	}
+	matrix_1D = static_cast<const double *>(matrix_segment.data);
+	fprintf(stderr, "Task %s shared matrix %s\n", matrix_segment.created ? "created" : "mapped", matrix_name);
 	
-	vector = new (std::nothrow) double[N];
-	if (!vector)
+	// Allocate memory for the private vectors from a huge page arena, faulted in
+	// by the threads of the task
+	const size_t vector_bytes = matvec_row_stride(N)*sizeof(double);
+	const size_t result_bytes = matvec_row_stride(M)*sizeof(double);
+	if (task_arena_create(&arena, vector_bytes + result_bytes, TASK_ARENA_PREFAULT) != 0)
 	{
 		fprintf(stderr, "ERROR: Memory allocation failed");
 		return RT_GOMP_SIMPLE_TASK_MEM_ALLOC_ERROR;
 	}
+	fprintf(stderr, "Task memory uses %s\n", task_arena_page_kind_name(arena.page_kind));
 	
-	result = new (std::nothrow) double[M];
-	if (!result)
+	vector = static_cast<double *>(task_arena_alloc(&arena, vector_bytes, matvec_alignment));
+	result = static_cast<double *>(task_arena_alloc(&arena, result_bytes, matvec_alignment));
+	if (!vector || !result)
 	{
 		fprintf(stderr, "ERROR: Memory allocation failed");
 		return RT_GOMP_SIMPLE_TASK_MEM_ALLOC_ERROR;
-	}	
+	}
+	
+	// Zero the vectors from the threads that will use them in run. Results are
+	// split the same way as in run; the vector is read by every thread.
+	first_touch(result, M, sizeof(double), matvec_row_tile);
+	first_touch(vector, N, sizeof(double));
 	
 	return 0;
 }
 
 int run(int argc, char *argv[])
 {
-	double (*matrix_2D)[N] = reinterpret_cast<double (*)[N]>(matrix_1D);
-
-	// Perform matrix-vector multiplication
-	#pragma omp parallel for
-	for (size_t r = 0; r < M; ++r)
+	// Perform matrix-vector multiplication. Each thread takes a contiguous
+	// range of whole row tiles.
+	#pragma omp parallel
 	{
-		result[r] = 0;
-		for (size_t c = 0; c < N; ++c)
-		{
-			result[r] += matrix_2D[r][c] * vector[c];
-		}
+		size_t row_begin, row_end;
+		matvec_thread_rows(M, &row_begin, &row_end);
+		trace_segment_begin(0);
+		kernel(matrix_1D, row_stride, vector, result, row_begin, row_end, N);
+		trace_segment_end(0);
 	}
 	
 	return 0;
@@ -75,11 +131,9 @@ int run(int argc, char *argv[])
 
 int finalize(int argc, char *argv[])
 {
-	delete[] matrix_1D;
-	delete[] vector;
-	delete[] result;
+	shared_segment_close(&matrix_segment, matrix_name);
+	task_arena_destroy(&arena);
 	return 0;
 }
 
 task_t task = { init, run, finalize };
-
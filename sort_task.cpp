@@ -0,0 +1,139 @@
+// A parallel merge sort task that uses OpenMP
+// Call the functions with the following arguments in argv: executable_name num_keys [seed]
+// Each job copies the same unsorted 64 bit keys into a work buffer, sorts one contiguous
+// run per thread and then merges pairs of runs in log2(threads) rounds. Parallelism halves
+// with every round, so the span is dominated by the final merge. finalize checks the
+// result against std::sort.
+
+#include <omp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+#include <sstream>
+#include <new>
+#include "task.h"
+#include "first_touch.h"
+
+size_t num_keys;
+unsigned seed = 1;
+uint64_t *input, *work[2];
+const uint64_t *sorted;
+size_t *run_bounds;
+unsigned jobs_completed = 0;
+
+enum rt_gomp_sort_task_error_codes
+{
+	RT_GOMP_SORT_TASK_SUCCESS,
+	RT_GOMP_SORT_TASK_INVALID_ARGUMENTS,
+	RT_GOMP_SORT_TASK_MEM_ALLOC_ERROR,
+	RT_GOMP_SORT_TASK_VERIFY_ERROR
+};
+
+int init(int argc, char *argv[])
+{
+	if (!(
+		(argc == 2 || argc == 3) &&
+		std::istringstream(argv[1]) >> num_keys && num_keys > 0 &&
+		(argc == 2 || std::istringstream(argv[2]) >> seed)
+	))
+	{
+		fprintf(stderr, "ERROR: Invalid initialization arguments");
+		return RT_GOMP_SORT_TASK_INVALID_ARGUMENTS;
+	}
+
+	input = new (std::nothrow) uint64_t[num_keys];
+	work[0] = new (std::nothrow) uint64_t[num_keys];
+	work[1] = new (std::nothrow) uint64_t[num_keys];
+	run_bounds = new (std::nothrow) size_t[omp_get_max_threads() + 1];
+	if (!input || !work[0] || !work[1] || !run_bounds)
+	{
+		fprintf(stderr, "ERROR: Memory allocation failed");
+		return RT_GOMP_SORT_TASK_MEM_ALLOC_ERROR;
+	}
+
+	first_touch(input, num_keys, sizeof(uint64_t));
+	first_touch(work[0], num_keys, sizeof(uint64_t));
+	first_touch(work[1], num_keys, sizeof(uint64_t));
+
+	srand48(seed);
+	for (size_t i = 0; i < num_keys; ++i)
+	{
+		input[i] = (uint64_t(lrand48()) << 32) ^ uint64_t(lrand48());
+	}
+
+	return 0;
+}
+
+int run(int argc, char *argv[])
+{
+	int src = 0;
+
+	#pragma omp parallel firstprivate(src)
+	{
+		const int num_threads = omp_get_num_threads();
+		const int thread_num = omp_get_thread_num();
+		size_t begin, end;
+		omp_static_range(num_keys, 1, &begin, &end);
+
+		memcpy(work[0] + begin, input + begin, (end - begin) * sizeof(uint64_t));
+		std::sort(work[0] + begin, work[0] + end);
+		run_bounds[thread_num] = begin;
+		if (thread_num == num_threads - 1) run_bounds[num_threads] = num_keys;
+		#pragma omp barrier
+
+		// Merge adjacent pairs of runs, doubling the run width each round
+		for (int width = 1; width < num_threads; width *= 2)
+		{
+			#pragma omp for schedule(static)
+			for (int r = 0; r < num_threads; r += 2 * width)
+			{
+				const size_t lo = run_bounds[r];
+				const size_t mid = run_bounds[std::min(r + width, num_threads)];
+				const size_t hi = run_bounds[std::min(r + 2 * width, num_threads)];
+				std::merge(work[src] + lo, work[src] + mid, work[src] + mid, work[src] + hi, work[1 - src] + lo);
+			}
+			src = 1 - src;
+		}
+
+		#pragma omp single
+		sorted = work[src];
+	}
+
+	jobs_completed += 1;
+	return 0;
+}
+
+int finalize(int argc, char *argv[])
+{
+	int ret_val = RT_GOMP_SORT_TASK_SUCCESS;
+
+	if (jobs_completed > 0)
+	{
+		uint64_t *reference = new (std::nothrow) uint64_t[num_keys];
+		if (!reference)
+		{
+			fprintf(stderr, "ERROR: Memory allocation failed");
+			return RT_GOMP_SORT_TASK_MEM_ALLOC_ERROR;
+		}
+
+		memcpy(reference, input, num_keys * sizeof(uint64_t));
+		std::sort(reference, reference + num_keys);
+		if (memcmp(reference, sorted, num_keys * sizeof(uint64_t)) != 0)
+		{
+			fprintf(stderr, "ERROR: sort result does not match std::sort\n");
+			ret_val = RT_GOMP_SORT_TASK_VERIFY_ERROR;
+		}
+
+		delete[] reference;
+	}
+
+	delete[] input;
+	delete[] work[0];
+	delete[] work[1];
+	delete[] run_bounds;
+	return ret_val;
+}
+
+task_t task = { init, run, finalize };
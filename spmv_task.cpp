@@ -0,0 +1,158 @@
+// A sparse matrix-vector multiplication task (y = A * x, A in CSR format) that uses OpenMP
+// Call the functions with the following arguments in argv: executable_name num_rows avg_nonzeros_per_row [seed]
+// Row lengths vary uniformly between 1 and twice the average and column indices are
+// random, so the access pattern to x is irregular and the work per row is unbalanced.
+// Memory latency bound. finalize checks y against a serial computation.
+
+#include <omp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <sstream>
+#include <new>
+#include "task.h"
+#include "first_touch.h"
+
+size_t num_rows, avg_nonzeros;
+unsigned seed = 1;
+size_t *row_start, *col_index;
+double *values, *x, *y;
+unsigned jobs_completed = 0;
+
+enum rt_gomp_spmv_task_error_codes
+{
+	RT_GOMP_SPMV_TASK_SUCCESS,
+	RT_GOMP_SPMV_TASK_INVALID_ARGUMENTS,
+	RT_GOMP_SPMV_TASK_MEM_ALLOC_ERROR,
+	RT_GOMP_SPMV_TASK_VERIFY_ERROR
+};
+
+static void spmv_rows(double *out, size_t row_begin, size_t row_end)
+{
+	for (size_t r = row_begin; r < row_end; ++r)
+	{
+		double sum = 0;
+		for (size_t k = row_start[r]; k < row_start[r + 1]; ++k)
+		{
+			sum += values[k] * x[col_index[k]];
+		}
+		out[r] = sum;
+	}
+}
+
+int init(int argc, char *argv[])
+{
+	if (!(
+		(argc == 3 || argc == 4) &&
+		std::istringstream(argv[1]) >> num_rows && num_rows > 0 &&
+		std::istringstream(argv[2]) >> avg_nonzeros && avg_nonzeros > 0 &&
+		(argc == 3 || std::istringstream(argv[3]) >> seed)
+	))
+	{
+		fprintf(stderr, "ERROR: Invalid initialization arguments");
+		return RT_GOMP_SPMV_TASK_INVALID_ARGUMENTS;
+	}
+
+	// Generate the row lengths first so that the nonzero arrays can be sized exactly
+	row_start = new (std::nothrow) size_t[num_rows + 1];
+	if (!row_start)
+	{
+		fprintf(stderr, "ERROR: Memory allocation failed");
+		return RT_GOMP_SPMV_TASK_MEM_ALLOC_ERROR;
+	}
+
+	srand48(seed);
+	row_start[0] = 0;
+	for (size_t r = 0; r < num_rows; ++r)
+	{
+		row_start[r + 1] = row_start[r] + 1 + lrand48() % (2 * avg_nonzeros);
+	}
+	const size_t num_nonzeros = row_start[num_rows];
+
+	col_index = new (std::nothrow) size_t[num_nonzeros];
+	values = new (std::nothrow) double[num_nonzeros];
+	x = new (std::nothrow) double[num_rows];
+	y = new (std::nothrow) double[num_rows];
+	if (!col_index || !values || !x || !y)
+	{
+		fprintf(stderr, "ERROR: Memory allocation failed");
+		return RT_GOMP_SPMV_TASK_MEM_ALLOC_ERROR;
+	}
+
+	// Rows are split evenly between threads in run, so the nonzeros of each
+	// thread's rows are touched by that thread. x is read by every thread.
+	#pragma omp parallel
+	{
+		size_t row_begin, row_end;
+		omp_static_range(num_rows, 1, &row_begin, &row_end);
+		for (size_t k = row_start[row_begin]; k < row_start[row_end]; ++k)
+		{
+			col_index[k] = 0;
+			values[k] = 0;
+		}
+	}
+	first_touch(y, num_rows, sizeof(double));
+	first_touch(x, num_rows, sizeof(double));
+
+	for (size_t k = 0; k < num_nonzeros; ++k)
+	{
+		col_index[k] = lrand48() % num_rows;
+		values[k] = drand48() - 0.5;
+	}
+	for (size_t r = 0; r < num_rows; ++r)
+	{
+		x[r] = drand48() - 0.5;
+	}
+
+	return 0;
+}
+
+int run(int argc, char *argv[])
+{
+	#pragma omp parallel
+	{
+		size_t row_begin, row_end;
+		omp_static_range(num_rows, 1, &row_begin, &row_end);
+		spmv_rows(y, row_begin, row_end);
+	}
+
+	jobs_completed += 1;
+	return 0;
+}
+
+int finalize(int argc, char *argv[])
+{
+	int ret_val = RT_GOMP_SPMV_TASK_SUCCESS;
+
+	if (jobs_completed > 0)
+	{
+		double *reference = new (std::nothrow) double[num_rows];
+		if (!reference)
+		{
+			fprintf(stderr, "ERROR: Memory allocation failed");
+			return RT_GOMP_SPMV_TASK_MEM_ALLOC_ERROR;
+		}
+
+		spmv_rows(reference, 0, num_rows);
+		for (size_t r = 0; r < num_rows; ++r)
+		{
+			if (y[r] != reference[r])
+			{
+				fprintf(stderr, "ERROR: spmv result y[%zu] = %g, expected %g\n", r, y[r], reference[r]);
+				ret_val = RT_GOMP_SPMV_TASK_VERIFY_ERROR;
+				break;
+			}
+		}
+
+		delete[] reference;
+	}
+
+	delete[] row_start;
+	delete[] col_index;
+	delete[] values;
+	delete[] x;
+	delete[] y;
+	return ret_val;
+}
+
+task_t task = { init, run, finalize };
@@ -0,0 +1,162 @@
+// A 2D five point Jacobi stencil task that uses OpenMP
+// Call the functions with the following arguments in argv: executable_name num_rows num_cols num_sweeps
+// Each job performs num_sweeps Jacobi sweeps over a num_rows x num_cols grid with fixed
+// boundary values. Memory bandwidth bound, with a barrier between sweeps. Every job starts
+// from the same initial grid, which is only read, so all jobs compute the same result and
+// finalize can check the last one against a serial computation.
+
+#include <omp.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <sstream>
+#include <new>
+#include "task.h"
+#include "first_touch.h"
+
+size_t rows, cols;
+unsigned num_sweeps;
+double *initial, *grid[2];
+unsigned jobs_completed = 0;
+
+enum rt_gomp_stencil_task_error_codes
+{
+	RT_GOMP_STENCIL_TASK_SUCCESS,
+	RT_GOMP_STENCIL_TASK_INVALID_ARGUMENTS,
+	RT_GOMP_STENCIL_TASK_MEM_ALLOC_ERROR,
+	RT_GOMP_STENCIL_TASK_VERIFY_ERROR
+};
+
+// Performs one sweep over the interior rows [row_begin, row_end) of dst
+static void sweep(const double *src, double *dst, size_t row_begin, size_t row_end)
+{
+	if (row_begin < 1) row_begin = 1;
+	if (row_end > rows - 1) row_end = rows - 1;
+	for (size_t r = row_begin; r < row_end; ++r)
+	{
+		const double *up = src + (r - 1)*cols;
+		const double *mid = src + r*cols;
+		const double *down = src + (r + 1)*cols;
+		double *out = dst + r*cols;
+		for (size_t c = 1; c < cols - 1; ++c)
+		{
+			out[c] = 0.25 * (up[c] + down[c] + mid[c - 1] + mid[c + 1]);
+		}
+	}
+}
+
+// Returns the grid holding the result after the given number of sweeps
+static const double *sweep_result(unsigned sweeps)
+{
+	return sweeps == 0 ? initial : grid[(sweeps - 1) % 2];
+}
+
+int init(int argc, char *argv[])
+{
+	if (!(
+		argc == 4 &&
+		std::istringstream(argv[1]) >> rows && rows >= 3 &&
+		std::istringstream(argv[2]) >> cols && cols >= 3 &&
+		std::istringstream(argv[3]) >> num_sweeps
+	))
+	{
+		fprintf(stderr, "ERROR: Invalid initialization arguments");
+		return RT_GOMP_STENCIL_TASK_INVALID_ARGUMENTS;
+	}
+
+	initial = new (std::nothrow) double[rows*cols];
+	grid[0] = new (std::nothrow) double[rows*cols];
+	grid[1] = new (std::nothrow) double[rows*cols];
+	if (!initial || !grid[0] || !grid[1])
+	{
+		fprintf(stderr, "ERROR: Memory allocation failed");
+		return RT_GOMP_STENCIL_TASK_MEM_ALLOC_ERROR;
+	}
+
+	first_touch(initial, rows, cols*sizeof(double));
+	first_touch(grid[0], rows, cols*sizeof(double));
+	first_touch(grid[1], rows, cols*sizeof(double));
+
+	// Hot top edge, cold elsewhere, with a smooth interior starting point
+	for (size_t r = 0; r < rows; ++r)
+	{
+		for (size_t c = 0; c < cols; ++c)
+		{
+			const bool boundary = (r == 0 || r == rows - 1 || c == 0 || c == cols - 1);
+			if (boundary) initial[r*cols + c] = (r == 0) ? 100.0 : 0.0;
+			else initial[r*cols + c] = sin(0.01 * r) * cos(0.02 * c);
+		}
+	}
+
+	// The boundary is never written by a sweep, so copy it into both grids once
+	memcpy(grid[0], initial, rows*cols*sizeof(double));
+	memcpy(grid[1], initial, rows*cols*sizeof(double));
+	return 0;
+}
+
+int run(int argc, char *argv[])
+{
+	#pragma omp parallel
+	{
+		size_t row_begin, row_end;
+		omp_static_range(rows, 1, &row_begin, &row_end);
+
+		for (unsigned s = 1; s <= num_sweeps; ++s)
+		{
+			sweep(sweep_result(s - 1), grid[(s - 1) % 2], row_begin, row_end);
+			#pragma omp barrier
+		}
+	}
+
+	jobs_completed += 1;
+	return 0;
+}
+
+int finalize(int argc, char *argv[])
+{
+	int ret_val = RT_GOMP_STENCIL_TASK_SUCCESS;
+
+	if (jobs_completed > 0 && num_sweeps > 0)
+	{
+		// Repeat the sweeps serially and compare
+		double *reference[2];
+		reference[0] = new (std::nothrow) double[rows*cols];
+		reference[1] = new (std::nothrow) double[rows*cols];
+		if (!reference[0] || !reference[1])
+		{
+			fprintf(stderr, "ERROR: Memory allocation failed");
+			return RT_GOMP_STENCIL_TASK_MEM_ALLOC_ERROR;
+		}
+		memcpy(reference[0], initial, rows*cols*sizeof(double));
+		memcpy(reference[1], initial, rows*cols*sizeof(double));
+
+		const double *src = initial;
+		for (unsigned s = 1; s <= num_sweeps; ++s)
+		{
+			sweep(src, reference[(s - 1) % 2], 0, rows);
+			src = reference[(s - 1) % 2];
+		}
+
+		const double *result = sweep_result(num_sweeps);
+		for (size_t i = 0; i < rows*cols; ++i)
+		{
+			if (result[i] != src[i])
+			{
+				fprintf(stderr, "ERROR: stencil result differs at row %zu column %zu\n", i / cols, i % cols);
+				ret_val = RT_GOMP_STENCIL_TASK_VERIFY_ERROR;
+				break;
+			}
+		}
+
+		delete[] reference[0];
+		delete[] reference[1];
+	}
+
+	delete[] initial;
+	delete[] grid[0];
+	delete[] grid[1];
+	return ret_val;
+}
+
+task_t task = { init, run, finalize };
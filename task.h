@@ -1,6 +1,9 @@
 #ifndef RT_GOMP_TASK_H
 #define RT_GOMP_TASK_H
 
+// Tasks may allocate their working sets from a huge page backed arena
+#include "task_arena.h"
+
 // Task struct type used by task_manager.cpp to control a task.
 typedef struct
 {
@@ -0,0 +1,185 @@
+#include "task_arena.h"
+#include "first_touch.h"
+#include <sys/mman.h>
+#include <stdint.h>
+#include <stdio.h>
+
+static size_t round_up(size_t value, size_t multiple)
+{
+	return (value + multiple - 1) / multiple * multiple;
+}
+
+// Maps size bytes aligned to a huge page boundary, so that transparent huge pages
+// can back the whole range. Returns MAP_FAILED on error.
+static void *map_huge_page_aligned(size_t size)
+{
+	const size_t padded_size = size + task_arena_huge_page_size;
+	char *raw = static_cast<char *>(mmap(NULL, padded_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+	if (raw == MAP_FAILED) return MAP_FAILED;
+
+	// Trim the unaligned head and the leftover tail
+	char *aligned = reinterpret_cast<char *>(round_up(reinterpret_cast<uintptr_t>(raw), task_arena_huge_page_size));
+	if (aligned > raw) munmap(raw, aligned - raw);
+	char *tail = aligned + size;
+	if (raw + padded_size > tail) munmap(tail, raw + padded_size - tail);
+	return aligned;
+}
+
+int task_arena_create(task_arena_t *arena, size_t size, int flags)
+{
+	arena->base = NULL;
+	arena->size = 0;
+	arena->used = 0;
+
+	if (size == 0)
+	{
+		fprintf(stderr, "ERROR: A task arena cannot be empty\n");
+		return RT_GOMP_TASK_ARENA_INVALID_VALUE_ERROR;
+	}
+
+	size = round_up(size, task_arena_huge_page_size);
+	void *base = MAP_FAILED;
+
+	if (!(flags & TASK_ARENA_SMALL_PAGES))
+	{
+		// Explicit huge pages only work if the administrator reserved enough of them
+		base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		arena->page_kind = TASK_ARENA_HUGETLB_PAGES;
+	}
+
+	if (base == MAP_FAILED)
+	{
+		base = map_huge_page_aligned(size);
+		if (base == MAP_FAILED)
+		{
+			perror("ERROR: task_arena call to mmap failed");
+			return RT_GOMP_TASK_ARENA_MMAP_ERROR;
+		}
+
+		if (flags & TASK_ARENA_SMALL_PAGES)
+		{
+			madvise(base, size, MADV_NOHUGEPAGE);
+			arena->page_kind = TASK_ARENA_BASE_PAGES;
+		}
+		else if (madvise(base, size, MADV_HUGEPAGE) == 0)
+		{
+			arena->page_kind = TASK_ARENA_TRANSPARENT_HUGE_PAGES;
+		}
+		else
+		{
+			arena->page_kind = TASK_ARENA_BASE_PAGES;
+		}
+	}
+
+	arena->base = static_cast<char *>(base);
+	arena->size = size;
+
+	if (flags & TASK_ARENA_PREFAULT)
+	{
+		first_touch(arena->base, size / task_arena_huge_page_size, task_arena_huge_page_size);
+	}
+
+	return RT_GOMP_TASK_ARENA_SUCCESS;
+}
+
+void task_arena_destroy(task_arena_t *arena)
+{
+	if (arena->base != NULL && munmap(arena->base, arena->size) != 0)
+	{
+		perror("WARNING: task_arena call to munmap failed");
+	}
+	arena->base = NULL;
+	arena->size = 0;
+	arena->used = 0;
+}
+
+void *task_arena_alloc(task_arena_t *arena, size_t size, size_t alignment)
+{
+	size_t offset = round_up(arena->used, alignment);
+	if (offset > arena->size || size > arena->size - offset)
+	{
+		return NULL;
+	}
+	arena->used = offset + size;
+	return arena->base + offset;
+}
+
+size_t task_arena_mark(const task_arena_t *arena)
+{
+	return arena->used;
+}
+
+void task_arena_reset(task_arena_t *arena, size_t mark)
+{
+	if (mark <= arena->used) arena->used = mark;
+}
+
+const char *task_arena_page_kind_name(task_arena_page_kind kind)
+{
+	switch (kind)
+	{
+		case TASK_ARENA_HUGETLB_PAGES: return "hugetlb 2 MB pages";
+		case TASK_ARENA_TRANSPARENT_HUGE_PAGES: return "transparent huge pages";
+		default: return "4 KB pages";
+	}
+}
+
+int task_pool_create(task_pool_t *pool, task_arena_t *arena, size_t block_size, size_t num_blocks, size_t alignment)
+{
+	pool->free_list = NULL;
+	pool->num_blocks = 0;
+	pool->num_free = 0;
+
+	// Each free block holds the pointer to the next free block
+	if (block_size < sizeof(void *)) block_size = sizeof(void *);
+	block_size = round_up(block_size, alignment);
+	pool->block_size = block_size;
+
+	if (num_blocks > 0 && block_size > arena->size / num_blocks)
+	{
+		return RT_GOMP_TASK_ARENA_OUT_OF_MEMORY_ERROR;
+	}
+
+	char *blocks = static_cast<char *>(task_arena_alloc(arena, block_size * num_blocks, alignment));
+	if (blocks == NULL && num_blocks > 0)
+	{
+		return RT_GOMP_TASK_ARENA_OUT_OF_MEMORY_ERROR;
+	}
+
+	// Thread the blocks onto the free list so that they are handed out in address
+	// order. Each block only points to the next one, so the OpenMP threads link
+	// contiguous shares of whole huge pages in parallel, faulting the pages in
+	// on their own nodes as first_touch does.
+	const size_t blocks_per_page = block_size < task_arena_huge_page_size ? task_arena_huge_page_size / block_size : 1;
+	#pragma omp parallel
+	{
+		size_t begin, end;
+		omp_static_range(num_blocks, blocks_per_page, &begin, &end);
+		for (size_t i = begin; i < end; ++i)
+		{
+			*reinterpret_cast<void **>(blocks + i * block_size) = i + 1 < num_blocks ? blocks + (i + 1) * block_size : NULL;
+		}
+	}
+	if (num_blocks > 0) pool->free_list = blocks;
+	pool->num_blocks = num_blocks;
+	pool->num_free = num_blocks;
+	return RT_GOMP_TASK_ARENA_SUCCESS;
+}
+
+void *task_pool_alloc(task_pool_t *pool)
+{
+	void *block = pool->free_list;
+	if (block != NULL)
+	{
+		pool->free_list = *static_cast<void **>(block);
+		pool->num_free -= 1;
+	}
+	return block;
+}
+
+void task_pool_free(task_pool_t *pool, void *block)
+{
+	*static_cast<void **>(block) = pool->free_list;
+	pool->free_list = block;
+	pool->num_free += 1;
+}
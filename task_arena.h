@@ -0,0 +1,96 @@
+#ifndef RT_GOMP_TASK_ARENA_H
+#define RT_GOMP_TASK_ARENA_H
+
+#include <stddef.h>
+
+// A memory arena for task working sets. The arena is one mapping backed by 2 MB
+// huge pages: explicit hugetlbfs pages (MAP_HUGETLB) when the system has them
+// reserved, otherwise transparent huge pages requested with madvise(MADV_HUGEPAGE).
+// It is created and faulted in during task.init, after which memory is handed out
+// by a bump allocator (task_arena_alloc) or by fixed size block pools
+// (task_pool_t) without ever calling malloc, so run() sees neither allocator
+// latency nor page faults and uses far fewer TLB entries than with 4 KB pages.
+//
+// Neither the arena nor the pools are thread safe. Allocate from one thread, or
+// give each thread its own pool.
+
+enum rt_gomp_task_arena_error_codes
+{
+	RT_GOMP_TASK_ARENA_SUCCESS,
+	RT_GOMP_TASK_ARENA_MMAP_ERROR,
+	RT_GOMP_TASK_ARENA_OUT_OF_MEMORY_ERROR,
+	RT_GOMP_TASK_ARENA_INVALID_VALUE_ERROR
+};
+
+const size_t task_arena_huge_page_size = 2 * 1024 * 1024;
+
+// Flags for task_arena_create
+enum task_arena_flags
+{
+	// Fault in the whole arena in parallel before returning. Each OpenMP thread
+	// touches a contiguous share of huge pages. Without this flag, the task
+	// should first_touch what it allocates (see first_touch.h); any pages left
+	// untouched are faulted in when task_manager locks memory after init.
+	TASK_ARENA_PREFAULT = 1,
+	// Use 4 KB pages, for comparison with huge pages
+	TASK_ARENA_SMALL_PAGES = 2
+};
+
+// How an arena's memory is backed
+enum task_arena_page_kind
+{
+	TASK_ARENA_HUGETLB_PAGES,
+	TASK_ARENA_TRANSPARENT_HUGE_PAGES,
+	TASK_ARENA_BASE_PAGES
+};
+
+typedef struct
+{
+	char *base;
+	size_t size;
+	size_t used;
+	task_arena_page_kind page_kind;
+}
+task_arena_t;
+
+// Maps an arena of at least size bytes (rounded up to whole huge pages)
+int task_arena_create(task_arena_t *arena, size_t size, int flags);
+
+// Unmaps the arena. All memory allocated from it becomes invalid.
+void task_arena_destroy(task_arena_t *arena);
+
+// Bump allocates size bytes aligned to alignment (a power of two). Returns NULL if
+// the arena is exhausted.
+void *task_arena_alloc(task_arena_t *arena, size_t size, size_t alignment = 64);
+
+// A mark and reset pair releases everything allocated after the mark, which
+// gives run() per-job scratch memory: take a mark at the start of the job and
+// reset to it at the end.
+size_t task_arena_mark(const task_arena_t *arena);
+void task_arena_reset(task_arena_t *arena, size_t mark);
+
+const char *task_arena_page_kind_name(task_arena_page_kind kind);
+
+// A pool of equally sized blocks carved out of an arena, with O(1) allocation
+// and release through an intrusive free list
+typedef struct
+{
+	void *free_list;
+	size_t block_size;
+	size_t num_blocks;
+	size_t num_free;
+}
+task_pool_t;
+
+// Reserves num_blocks blocks of block_size bytes (rounded up to the alignment) from
+// arena. The OpenMP threads build the free list in parallel, each over a
+// contiguous share of huge pages, so the blocks are faulted in like first_touch.
+int task_pool_create(task_pool_t *pool, task_arena_t *arena, size_t block_size, size_t num_blocks, size_t alignment = 64);
+
+// Returns a block, or NULL if all blocks are in use
+void *task_pool_alloc(task_pool_t *pool);
+
+// Returns a block obtained from task_pool_alloc to the pool
+void task_pool_free(task_pool_t *pool, void *block);
+
+#endif /* RT_GOMP_TASK_ARENA_H */
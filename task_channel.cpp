@@ -0,0 +1,404 @@
+#include "task_channel.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+const unsigned max_task_channel_buffers = 2 * max_task_channel_consumers + 3;
+
+// A pair of buffers is packed into one word so that both can be claimed with a
+// single compare-and-swap: the latest message in the low half and the one
+// before it in the high half. In a consumer's holding word the top bit marks
+// that the pair is held; a holding word of zero means the consumer is sampling.
+typedef unsigned long long buffer_pair_t;
+static const buffer_pair_t pair_held = 1ULL << 63;
+
+static unsigned pair_latest(buffer_pair_t pair) { return pair & 0xffffffffULL; }
+static unsigned pair_previous(buffer_pair_t pair) { return (pair & ~pair_held) >> 32; }
+static buffer_pair_t make_pair(unsigned previous, unsigned latest) { return (buffer_pair_t) previous << 32 | latest; }
+
+// The shared state in front of the buffers. A zero filled header is a valid
+// empty channel whose latest and previous messages are both the zero filled
+// buffer 0, so tasks can open a channel in any order without a setup step.
+typedef struct
+{
+	size_t message_size;
+	unsigned max_consumers;
+	unsigned references;
+	// Pid of the task in each role, 0 if the role is free
+	pid_t producer_taken;
+	pid_t consumer_taken[max_task_channel_consumers];
+	buffer_pair_t published;
+	buffer_pair_t holding[max_task_channel_consumers];
+	unsigned long long visible_at_ns[max_task_channel_buffers];
+	unsigned long sequence[max_task_channel_buffers];
+	unsigned long num_published;
+}
+channel_header_t;
+
+static std::vector<task_channel_t *> open_channels;
+
+// The references of a channel while the task taking the first one resets it,
+// and the role of a killed consumer while its buffers are given back
+static const unsigned references_resetting = 1U << 31;
+static const pid_t role_reclaiming = -1;
+static const timespec reset_poll_interval = {0, 500000};
+
+static size_t round_up(size_t value, size_t multiple)
+{
+	return (value + multiple - 1) / multiple * multiple;
+}
+
+static unsigned long long to_ns(const timespec & ts)
+{
+	return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static volatile channel_header_t *get_header(const task_channel_t *channel)
+{
+	return static_cast<channel_header_t *>(channel->mapping);
+}
+
+static char *get_buffer(const task_channel_t *channel, unsigned index)
+{
+	return static_cast<char *>(channel->mapping) + round_up(sizeof(channel_header_t), 64) + index * channel->buffer_stride;
+}
+
+// Claims header field from zero to value, or checks that another task set it to value
+static bool agree(volatile unsigned *field, unsigned value)
+{
+	const unsigned previous = __sync_val_compare_and_swap(field, 0, value);
+	return previous == 0 || previous == value;
+}
+
+static bool agree(volatile size_t *field, size_t value)
+{
+	const size_t previous = __sync_val_compare_and_swap(field, 0, value);
+	return previous == 0 || previous == value;
+}
+
+// Whether a process exists. A pid reused by another process counts as alive,
+// which only keeps a role that could have been taken back.
+static bool process_alive(pid_t pid)
+{
+	return kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+// Frees the roles of tasks that were killed without closing the channel and
+// drops their references. Of several tasks finding the same one, only the one
+// whose compare-and-swap succeeds frees it.
+static void reclaim_roles(volatile channel_header_t *header, const char *name)
+{
+	const pid_t producer = header->producer_taken;
+	if (producer > 0 && !process_alive(producer) && __sync_bool_compare_and_swap(&header->producer_taken, producer, 0))
+	{
+		fprintf(stderr, "WARNING: Taking back the producer of task channel %s from task %d, which no longer exists\n", name, (int) producer);
+		__sync_sub_and_fetch(&header->references, 1);
+	}
+	for (unsigned c = 0; c < header->max_consumers; ++c)
+	{
+		const pid_t consumer = header->consumer_taken[c];
+		if (consumer <= 0 || process_alive(consumer) || !__sync_bool_compare_and_swap(&header->consumer_taken[c], consumer, role_reclaiming))
+		{
+			continue;
+		}
+		fprintf(stderr, "WARNING: Taking back a consumer of task channel %s from task %d, which no longer exists\n", name, (int) consumer);
+		header->holding[c] = 0;
+		__sync_synchronize();
+		header->consumer_taken[c] = 0;
+		__sync_sub_and_fetch(&header->references, 1);
+	}
+}
+
+// Clears the messages of a channel that no task has open, which were left by
+// killed tasks, so that consumers start from the zero filled message again
+static void reset_channel(const task_channel_t *channel)
+{
+	volatile channel_header_t *header = get_header(channel);
+	header->published = 0;
+	for (unsigned c = 0; c < max_task_channel_consumers; ++c) header->holding[c] = 0;
+	for (unsigned b = 0; b < max_task_channel_buffers; ++b)
+	{
+		header->visible_at_ns[b] = 0;
+		header->sequence[b] = 0;
+	}
+	header->num_published = 0;
+	memset(get_buffer(channel, 0), 0, channel->buffer_stride);
+}
+
+// Takes a reference to the channel. The task that takes the first one resets
+// the channel while the others wait.
+static void take_reference(const task_channel_t *channel)
+{
+	volatile channel_header_t *header = get_header(channel);
+	unsigned references = header->references;
+	while (true)
+	{
+		if (references == references_resetting)
+		{
+			nanosleep(&reset_poll_interval, NULL);
+			references = header->references;
+			continue;
+		}
+		const unsigned previous = __sync_val_compare_and_swap(&header->references, references,
+			references == 0 ? references_resetting : references + 1);
+		if (previous == references) break;
+		references = previous;
+	}
+	if (references == 0)
+	{
+		reset_channel(channel);
+		__sync_synchronize();
+		header->references = 1;
+	}
+}
+
+// Picks a buffer for the producer that is neither published nor held by a consumer
+static unsigned find_free_buffer(const task_channel_t *channel)
+{
+	volatile channel_header_t *header = get_header(channel);
+	bool used[max_task_channel_buffers] = { false };
+
+	const buffer_pair_t published = header->published;
+	used[pair_latest(published)] = true;
+	used[pair_previous(published)] = true;
+
+	for (unsigned c = 0; c < header->max_consumers; ++c)
+	{
+		const buffer_pair_t holding = header->holding[c];
+		if (holding & pair_held)
+		{
+			used[pair_latest(holding)] = true;
+			used[pair_previous(holding)] = true;
+		}
+	}
+
+	unsigned index = 0;
+	while (used[index]) ++index;
+	return index;
+}
+
+int task_channel_open(task_channel_t *channel, const char *name, size_t message_size, unsigned max_consumers, task_channel_role role)
+{
+	channel->mapping = NULL;
+	channel->role = role;
+	channel->pending = false;
+	channel->read_index = 0;
+
+	if (message_size == 0 || max_consumers == 0 || max_consumers > max_task_channel_consumers)
+	{
+		fprintf(stderr, "ERROR: A task channel needs a message size and between 1 and %u consumers\n", max_task_channel_consumers);
+		return RT_GOMP_TASK_CHANNEL_INVALID_VALUE_ERROR;
+	}
+
+	channel->num_buffers = 2 * max_consumers + 3;
+	channel->buffer_stride = round_up(message_size, 64);
+	channel->mapping_size = round_up(sizeof(channel_header_t), 64) + channel->num_buffers * channel->buffer_stride;
+
+	int fd = shm_open(name, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+	if (fd == -1)
+	{
+		fprintf(stderr, "ERROR: task_channel call to shm_open failed for name %s: %s\n", name, strerror(errno));
+		return RT_GOMP_TASK_CHANNEL_SHM_OPEN_FAILED_ERROR;
+	}
+
+	// Whichever task comes first sizes the file. Extending it to the same size
+	// again is harmless, but a different size means the tasks disagree.
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) == 0 && file_stat.st_size != 0 && file_stat.st_size != (off_t) channel->mapping_size)
+	{
+		fprintf(stderr, "ERROR: Task channel %s was opened with a different message size or number of consumers\n", name);
+		close(fd);
+		return RT_GOMP_TASK_CHANNEL_MISMATCH_ERROR;
+	}
+	if (ftruncate(fd, channel->mapping_size) == -1)
+	{
+		perror("ERROR: task_channel call to ftruncate failed");
+		close(fd);
+		return RT_GOMP_TASK_CHANNEL_FTRUNCATE_FAILED_ERROR;
+	}
+
+	void *mapping = mmap(NULL, channel->mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (close(fd) == -1)
+	{
+		perror("WARNING: task_channel call to close file descriptor failed");
+	}
+	if (mapping == MAP_FAILED)
+	{
+		perror("ERROR: task_channel call to mmap failed");
+		return RT_GOMP_TASK_CHANNEL_MMAP_FAILED_ERROR;
+	}
+	channel->mapping = mapping;
+
+	volatile channel_header_t *header = get_header(channel);
+	if (!agree(&header->message_size, message_size) || !agree(&header->max_consumers, max_consumers))
+	{
+		fprintf(stderr, "ERROR: Task channel %s was opened with a different message size or number of consumers\n", name);
+		munmap(channel->mapping, channel->mapping_size);
+		channel->mapping = NULL;
+		return RT_GOMP_TASK_CHANNEL_MISMATCH_ERROR;
+	}
+
+	reclaim_roles(header, name);
+	const pid_t pid = getpid();
+	bool role_taken = true;
+	if (role == TASK_CHANNEL_PRODUCER)
+	{
+		role_taken = (__sync_val_compare_and_swap(&header->producer_taken, 0, pid) != 0);
+	}
+	else
+	{
+		for (unsigned c = 0; c < max_consumers && role_taken; ++c)
+		{
+			if (__sync_val_compare_and_swap(&header->consumer_taken[c], 0, pid) == 0)
+			{
+				channel->consumer = c;
+				role_taken = false;
+			}
+		}
+	}
+	if (role_taken)
+	{
+		fprintf(stderr, "ERROR: Task channel %s already has a %s\n", name, role == TASK_CHANNEL_PRODUCER ? "producer" : "full set of consumers");
+		munmap(channel->mapping, channel->mapping_size);
+		channel->mapping = NULL;
+		return RT_GOMP_TASK_CHANNEL_ROLE_TAKEN_ERROR;
+	}
+
+	take_reference(channel);
+	if (role == TASK_CHANNEL_PRODUCER)
+	{
+		channel->write_index = find_free_buffer(channel);
+	}
+	else
+	{
+		const timespec start_of_time = { 0, 0 };
+		task_channel_sample(channel, start_of_time);
+	}
+
+	open_channels.push_back(channel);
+	return RT_GOMP_TASK_CHANNEL_SUCCESS;
+}
+
+void task_channel_close(task_channel_t *channel, const char *name)
+{
+	if (channel->mapping == NULL) return;
+
+	volatile channel_header_t *header = get_header(channel);
+	if (channel->role == TASK_CHANNEL_PRODUCER)
+	{
+		header->producer_taken = 0;
+	}
+	else
+	{
+		header->holding[channel->consumer] = 0;
+		__sync_synchronize();
+		header->consumer_taken[channel->consumer] = 0;
+	}
+
+	// The last task to close the channel removes it
+	if (__sync_sub_and_fetch(&header->references, 1) == 0)
+	{
+		if (shm_unlink(name) == -1 && errno != ENOENT)
+		{
+			perror("WARNING: task_channel call to shm_unlink failed");
+		}
+	}
+
+	if (munmap(channel->mapping, channel->mapping_size) == -1)
+	{
+		perror("WARNING: task_channel call to munmap failed");
+	}
+	channel->mapping = NULL;
+	open_channels.erase(std::remove(open_channels.begin(), open_channels.end(), channel), open_channels.end());
+}
+
+void *task_channel_write_buffer(task_channel_t *channel)
+{
+	channel->pending = true;
+	return get_buffer(channel, channel->write_index);
+}
+
+const void *task_channel_read_buffer(const task_channel_t *channel)
+{
+	return get_buffer(channel, channel->read_index);
+}
+
+unsigned long task_channel_read_sequence(const task_channel_t *channel)
+{
+	return get_header(channel)->sequence[channel->read_index];
+}
+
+void task_channel_publish(task_channel_t *channel, const timespec & visible_at)
+{
+	if (channel->role != TASK_CHANNEL_PRODUCER || !channel->pending) return;
+
+	volatile channel_header_t *header = get_header(channel);
+	const unsigned index = channel->write_index;
+	header->num_published += 1;
+	header->sequence[index] = header->num_published;
+	header->visible_at_ns[index] = to_ns(visible_at);
+
+	// Make the message the latest, keeping the one before it for consumers that
+	// are released before the new message becomes visible
+	const buffer_pair_t published = make_pair(pair_latest(header->published), index);
+	__sync_synchronize();
+	header->published = published;
+	__sync_synchronize();
+
+	// Hand the new pair to every consumer that is in the middle of sampling, so
+	// that none of them can end up holding a buffer that is about to be reused
+	for (unsigned c = 0; c < header->max_consumers; ++c)
+	{
+		if (header->consumer_taken[c])
+		{
+			__sync_val_compare_and_swap(&header->holding[c], 0, published | pair_held);
+		}
+	}
+
+	channel->write_index = find_free_buffer(channel);
+	channel->pending = false;
+}
+
+void task_channel_sample(task_channel_t *channel, const timespec & release)
+{
+	if (channel->role != TASK_CHANNEL_CONSUMER) return;
+
+	volatile channel_header_t *header = get_header(channel);
+	volatile buffer_pair_t *holding = &header->holding[channel->consumer];
+
+	// Release the old pair and claim the published one, unless the producer
+	// publishes in between and claims its new pair for us
+	*holding = 0;
+	__sync_synchronize();
+	const buffer_pair_t published = header->published;
+	__sync_val_compare_and_swap(holding, 0, published | pair_held);
+	const buffer_pair_t held = *holding;
+	__sync_synchronize();
+
+	const unsigned latest = pair_latest(held);
+	channel->read_index = (header->visible_at_ns[latest] <= to_ns(release)) ? latest : pair_previous(held);
+}
+
+void task_channels_publish(const timespec & visible_at)
+{
+	for (size_t i = 0; i < open_channels.size(); ++i)
+	{
+		task_channel_publish(open_channels[i], visible_at);
+	}
+}
+
+void task_channels_sample(const timespec & release)
+{
+	for (size_t i = 0; i < open_channels.size(); ++i)
+	{
+		task_channel_sample(open_channels[i], release);
+	}
+}
@@ -0,0 +1,106 @@
+#ifndef RT_GOMP_TASK_CHANNEL_H
+#define RT_GOMP_TASK_CHANNEL_H
+
+#include <stddef.h>
+#include <time.h>
+
+// Wait-free shared memory channels between tasks with logical execution time
+// (LET) semantics.
+//
+// A channel carries fixed size messages from one producer task to up to
+// max_task_channel_consumers consumer tasks (one consumer gives an SPSC
+// channel). Messages live in a set of buffers in POSIX shared memory and are
+// never copied: a producer job writes its output straight into the buffer
+// returned by task_channel_write_buffer, and a consumer job reads its input
+// straight from the buffer returned by task_channel_read_buffer.
+//
+// Under LET, the output of a job becomes visible at the end of the job's
+// period, and a job's inputs are sampled at its release and stay fixed while
+// it runs. task_manager implements this without any blocking: when a producer
+// job completes its message is published stamped with the end of the period,
+// and when a consumer job is released it takes the newest message whose stamp
+// is not after the release time. What a consumer job sees therefore depends
+// only on the release times of the jobs, not on how long the jobs ran, as long
+// as the consumer samples within one producer period of its release.
+//
+// Publishing and sampling are wait-free. The producer picks a buffer that no
+// consumer holds, and a consumer that is sampling while the producer publishes
+// is handed the new message by the producer (the protocol of Chen and Burns),
+// so with 2 * consumers + 3 buffers neither side ever waits for the other.
+//
+// Tasks open their channels in task.init. Channels are reference counted and
+// removed from /dev/shm when the last task closes them. Each role records the
+// pid of its task, so a task opening the channel takes back the roles of tasks
+// that were killed, and a channel that only killed tasks had open starts over
+// from the zero filled message.
+
+enum rt_gomp_task_channel_error_codes
+{
+	RT_GOMP_TASK_CHANNEL_SUCCESS,
+	RT_GOMP_TASK_CHANNEL_INVALID_VALUE_ERROR,
+	RT_GOMP_TASK_CHANNEL_SHM_OPEN_FAILED_ERROR,
+	RT_GOMP_TASK_CHANNEL_FTRUNCATE_FAILED_ERROR,
+	RT_GOMP_TASK_CHANNEL_MMAP_FAILED_ERROR,
+	RT_GOMP_TASK_CHANNEL_MISMATCH_ERROR,
+	RT_GOMP_TASK_CHANNEL_ROLE_TAKEN_ERROR
+};
+
+const unsigned max_task_channel_consumers = 16;
+
+enum task_channel_role
+{
+	TASK_CHANNEL_PRODUCER,
+	TASK_CHANNEL_CONSUMER
+};
+
+typedef struct
+{
+	void *mapping;
+	size_t mapping_size;
+	size_t buffer_stride;
+	unsigned num_buffers;
+	task_channel_role role;
+	// The producer's buffer for the current job, or the consumer's slot
+	unsigned write_index;
+	unsigned consumer;
+	bool pending;
+	// The buffer sampled by a consumer at the last release
+	unsigned read_index;
+}
+task_channel_t;
+
+// Opens the channel called name as its producer or as one of its consumers,
+// creating it if no task has opened it yet. Every task must pass the same
+// message size and maximum number of consumers. Until the first message is
+// published, consumers read a zero filled message with sequence number 0.
+int task_channel_open(task_channel_t *channel, const char *name, size_t message_size, unsigned max_consumers, task_channel_role role);
+
+// Closes the channel and removes it from /dev/shm once no task has it open
+void task_channel_close(task_channel_t *channel, const char *name);
+
+// Returns the buffer for the output of the current job (producer only). The job
+// must write the whole message, since the buffer holds older data. The message
+// is published when the job completes.
+void *task_channel_write_buffer(task_channel_t *channel);
+
+// Returns the input of the current job (consumer only), which is sampled at the
+// job's release and does not change until the next release
+const void *task_channel_read_buffer(const task_channel_t *channel);
+
+// Returns the number of messages the producer had published when the current
+// input was written, counting from 1, or 0 for the initial message
+unsigned long task_channel_read_sequence(const task_channel_t *channel);
+
+// Publishes the message written since the last call, if any, to become visible
+// at visible_at. Consumers with a release before visible_at do not see it.
+void task_channel_publish(task_channel_t *channel, const timespec & visible_at);
+
+// Samples the newest message visible at release
+void task_channel_sample(task_channel_t *channel, const timespec & release);
+
+// Publish or sample every channel that the calling process has open. task_manager
+// calls these at job completion and at job release.
+void task_channels_publish(const timespec & visible_at);
+void task_channels_sample(const timespec & release);
+
+#endif /* RT_GOMP_TASK_CHANNEL_H */
@@ -2,16 +2,29 @@
 // in compilation. The task struct declared in task.h must be defined by the real time task.
 
 #include <sched.h>
+#include <pthread.h>
 #include <unistd.h> 
 #include <stdio.h>
+#include <errno.h>
+#include <string.h>
 #include <math.h>
 #include <sstream>
 #include <signal.h>
 #include <omp.h>
+#include <sys/mman.h>
+#include <linux/mempolicy.h>
 #include <iostream>
 #include "task.h"
 #include "single_use_barrier.h"
 #include "timespec_functions.h"
+#include "first_touch.h"
+#include "numa_placement.h"
+#include "task_channel.h"
+#include "resource_lock.h"
+#include "job_counters.h"
+#include "trace.h"
+#include "budget_reservation.h"
+#include "job_migration.h"
 
 enum rt_gomp_task_manager_error_codes
 { 
@@ -23,7 +36,9 @@ enum rt_gomp_task_manager_error_codes
 	RT_GOMP_TASK_MANAGER_BARRIER_ERROR,
 	RT_GOMP_TASK_MANAGER_BAD_DEADLINE_ERROR,
 	RT_GOMP_TASK_MANAGER_ARG_PARSE_ERROR,
-	RT_GOMP_TASK_MANAGER_ARG_COUNT_ERROR
+	RT_GOMP_TASK_MANAGER_ARG_COUNT_ERROR,
+	RT_GOMP_TASK_MANAGER_RESERVE_BUDGET_ERROR,
+	RT_GOMP_TASK_MANAGER_FINALIZE_TASK_ERROR
 };
 
 int main(int argc, char *argv[])
@@ -31,7 +46,7 @@ int main(int argc, char *argv[])
 	// Process command line arguments
 	
 	const char *task_name = argv[0];
-	const int num_req_args = 13;
+	const int num_req_args = 18;
 	if (argc < num_req_args)
 	{
 		fprintf(stderr, "ERROR: Too few arguments for task %s", task_name);
@@ -41,18 +56,22 @@ int main(int argc, char *argv[])
 	
 	int priority;
 	unsigned first_core, last_core, num_iters;
-	long period_sec, period_ns, deadline_sec, deadline_ns, relative_release_sec, relative_release_ns;
+	long budget_sec, budget_ns, budget_period_sec, budget_period_ns, period_sec, period_ns, deadline_sec, deadline_ns, relative_release_sec, relative_release_ns;
 	if (!(
 		std::istringstream(argv[1]) >> first_core &&
 		std::istringstream(argv[2]) >> last_core &&
 		std::istringstream(argv[3]) >> priority &&
-		std::istringstream(argv[4]) >> period_sec &&
-		std::istringstream(argv[5]) >> period_ns &&
-		std::istringstream(argv[6]) >> deadline_sec &&
-		std::istringstream(argv[7]) >> deadline_ns &&
-		std::istringstream(argv[8]) >> relative_release_sec &&
-		std::istringstream(argv[9]) >> relative_release_ns &&
-		std::istringstream(argv[10]) >> num_iters
+		std::istringstream(argv[4]) >> budget_sec &&
+		std::istringstream(argv[5]) >> budget_ns &&
+		std::istringstream(argv[6]) >> budget_period_sec &&
+		std::istringstream(argv[7]) >> budget_period_ns &&
+		std::istringstream(argv[9]) >> period_sec &&
+		std::istringstream(argv[10]) >> period_ns &&
+		std::istringstream(argv[11]) >> deadline_sec &&
+		std::istringstream(argv[12]) >> deadline_ns &&
+		std::istringstream(argv[13]) >> relative_release_sec &&
+		std::istringstream(argv[14]) >> relative_release_ns &&
+		std::istringstream(argv[15]) >> num_iters
 	))
 	{
 		fprintf(stderr, "ERROR: Cannot parse input argument for task %s", task_name);
@@ -60,10 +79,19 @@ int main(int argc, char *argv[])
 		return RT_GOMP_TASK_MANAGER_ARG_PARSE_ERROR;
 	}
 	
-	char *barrier_name = argv[11];
+	std::vector<job_migration_t> migrations;
+	if (parse_job_migrations(argv[8], migrations) != RT_GOMP_JOB_MIGRATION_SUCCESS)
+	{
+		kill(0, SIGTERM);
+		return RT_GOMP_TASK_MANAGER_ARG_PARSE_ERROR;
+	}
+	
+	char *barrier_name = argv[16];
 	int task_argc = argc - (num_req_args-1);
 	char **task_argv = &argv[num_req_args-1];
 	
+	timespec budget = { budget_sec, budget_ns };
+	timespec budget_period = { budget_period_sec, budget_period_ns };
 	timespec period = { period_sec, period_ns };
 	timespec deadline = { deadline_sec, deadline_ns };
 	timespec relative_release = { relative_release_sec, relative_release_ns };
@@ -114,6 +142,80 @@ int main(int argc, char *argv[])
 	omp_get_schedule(&omp_sched, &omp_mod);
 	fprintf(stderr, "OMP sched: %u %u\n", omp_sched, omp_mod);
 	
+	// Bind each OpenMP thread to its own core of the cluster so that data first
+	// touched by a thread during init is placed on that core's NUMA node and is
+	// processed by the same thread during run
+	const int bind_error = bind_omp_threads(first_core, last_core);
+	if (bind_error != 0)
+	{
+		fprintf(stderr, "ERROR: Could not bind OpenMP threads to cores: %s\n", strerror(bind_error));
+		kill(0, SIGTERM);
+		return RT_GOMP_TASK_MANAGER_CORE_BIND_ERROR;
+	}
+	
+	// A semi-federated task shares its last core with light tasks, and its
+	// thread there may only use its budget in each budget period. Neither the
+	// task nor the light tasks on that core are guaranteed without the
+	// reservation, so failing to make it is fatal.
+	if (budget > timespec{ 0, 0 })
+	{
+		int reservation_errno = 0;
+		#pragma omp parallel
+		{
+			if (first_core + omp_get_thread_num() % (last_core - first_core + 1) == last_core &&
+				reserve_budget(budget, budget_period) != RT_GOMP_BUDGET_RESERVATION_SUCCESS)
+			{
+				const int error = errno;
+				#pragma omp critical
+				reservation_errno = error;
+			}
+		}
+		if (reservation_errno != 0)
+		{
+			fprintf(stderr, "ERROR: Could not reserve the budget of task %s on core %u: %s\n", task_name, last_core, strerror(reservation_errno));
+			kill(0, SIGTERM);
+			return RT_GOMP_TASK_MANAGER_RESERVE_BUDGET_ERROR;
+		}
+	}
+	
+	// A split task moves between cores during its jobs (see job_migration.h)
+	if (job_migration_init(first_core, priority, migrations) != RT_GOMP_JOB_MIGRATION_SUCCESS)
+	{
+		perror("ERROR: Could not set up the migrations of a split task");
+		kill(0, SIGTERM);
+		return RT_GOMP_TASK_MANAGER_SET_PRIORITY_ERROR;
+	}
+	
+	// Restrict the task's memory to the NUMA nodes of its cores. Binding is tried
+	// first; if the kernel refuses it the first node is only preferred. Placement
+	// is a performance matter, so failures are warnings.
+	numa_node_mask_t memory_nodes;
+	const char *memory_policy = "default";
+	int policy_error = 0;
+	bool memory_nodes_known = (numa_nodes_of_cores(first_core, last_core, &memory_nodes) == 0);
+	if (!memory_nodes_known)
+	{
+		fprintf(stderr, "WARNING: Cannot determine NUMA nodes of task %s\n", task_name);
+	}
+	else if (set_omp_memory_policy(MPOL_BIND, &memory_nodes) == 0)
+	{
+		memory_policy = "bind";
+	}
+	else if ((policy_error = set_omp_memory_policy(MPOL_PREFERRED, &memory_nodes)) == 0)
+	{
+		memory_policy = "preferred";
+	}
+	else
+	{
+		fprintf(stderr, "WARNING: Could not set NUMA memory policy: %s\n", strerror(policy_error));
+	}
+	
+	if (memory_nodes_known)
+	{
+		fprintf(stderr, "Task %s on cores %u-%u uses memory nodes %s, policy %s\n", task_name,
+		        first_core, last_core, numa_node_mask_string(&memory_nodes).c_str(), memory_policy);
+	}
+	
 	fprintf(stderr, "Initializing task %s\n", task_name);
 
 	// Initialize the task
@@ -128,6 +230,35 @@ int main(int argc, char *argv[])
 		}
 	}
 	
+	// Keep the pages faulted in by init resident so that no page faults occur while
+	// jobs are running. This is not fatal since the task can still run without it.
+	ret_val = mlockall(MCL_CURRENT | MCL_FUTURE);
+	if (ret_val != 0)
+	{
+		perror("WARNING: Could not lock task memory");
+	}
+	
+	// Open the performance counters of the task's threads. They only explain
+	// overruns, so a task runs without them if the kernel refuses.
+	job_counters_t counters;
+	job_counter_stats_t counter_stats;
+	job_counter_stats_init(&counter_stats);
+	bool counters_open = (job_counters_open(&counters) == 0);
+	if (!counters_open)
+	{
+		fprintf(stderr, "WARNING: Cannot open performance counters for task %s\n", task_name);
+	}
+	else if (!counters.available[JOB_COUNTER_CYCLES])
+	{
+		fprintf(stderr, "WARNING: Hardware performance counters are not available, task %s only counts software events\n", task_name);
+	}
+	
+	// Record a timeline of the jobs if RT_GOMP_TRACE_DIR is set
+	if (trace_open(task_name, first_core, last_core, priority, period, deadline) != 0)
+	{
+		fprintf(stderr, "WARNING: Tracing disabled for task %s\n", task_name);
+	}
+	
 	fprintf(stderr, "Task %s reached barrier\n", task_name);
 	
 	// Wait at barrier for the other tasks
@@ -141,7 +272,7 @@ int main(int argc, char *argv[])
 	
 	// Initialize timing controls
 	unsigned deadlines_missed = 0;
-	timespec correct_period_start, actual_period_start, period_finish, period_runtime;
+	timespec correct_period_start, actual_period_start, period_finish, period_runtime, period_response;
 	get_time(&correct_period_start);
 	correct_period_start = correct_period_start + relative_release;
 	timespec max_period_runtime = { 0, 0 };
@@ -150,39 +281,79 @@ int main(int argc, char *argv[])
 	{
 		// Sleep until the start of the period
 		sleep_until_ts(correct_period_start);
+		
+		// The budgets of a split task count the CPU time from here to the
+		// second counter read, the span that utilization_calculator measures
+		// as the task's work, so that the overhead around run is charged to
+		// the parts as it is to the work they split
+		job_migration_start();
+		
+		// Sample the job's inputs at its release
+		task_channels_sample(correct_period_start);
+		job_counts_t counts_before, counts_after;
+		if (counters_open) job_counters_read(&counters, &counts_before);
 		get_time(&actual_period_start);
 	
 		// Run the task
 		ret_val = task.run(task_argc, task_argv);
 		get_time(&period_finish);
+		if (counters_open) job_counters_read(&counters, &counts_after);
+		job_migration_end();
+		
+		// Publish the job's outputs, to become visible at the end of its period
+		task_channels_publish(correct_period_start + period);
 		if (ret_val != 0)
 		{
 			fprintf(stderr, "ERROR: Task run failed for task %s", task_name);
 			return RT_GOMP_TASK_MANAGER_RUN_TASK_ERROR;
 		}
 		
-		// Check if the task finished before its deadline and record the maximum running time
+		// Check if the task finished before its deadline, which counts from the
+		// release and may be shorter than the period, and record the maximum running time
 		ts_diff(actual_period_start, period_finish, period_runtime);
-		if (period_runtime > deadline) deadlines_missed += 1;
+		ts_diff(correct_period_start, period_finish, period_response);
+		const bool missed_deadline = period_response > deadline;
+		if (missed_deadline) deadlines_missed += 1;
 		if (period_runtime > max_period_runtime) max_period_runtime = period_runtime;
+		if (counters_open)
+		{
+			job_counter_stats_add(&counter_stats, &counts_before, &counts_after, period_runtime, missed_deadline);
+		}
+		trace_job(i, correct_period_start, actual_period_start, period_finish, missed_deadline);
+		trace_flush();
 		
 		// Update the period_start time
 		correct_period_start = correct_period_start + period;
 	}
 	
-	// Finalize the task
+	trace_close();
+	
+	// Report where the task's memory ended up and how long it waited for shared
+	// resources before finalize releases them
+	if (memory_nodes_known) report_numa_placement(task_name, &memory_nodes);
+	report_resource_locks(task_name);
+	
+	// Finalize the task. A failure is reported with the exit status once the
+	// statistics below are printed, since the jobs themselves ran.
+	bool finalize_failed = false;
 	if (task.finalize != NULL) 
 	{
 		ret_val = task.finalize(task_argc, task_argv);
 		if (ret_val != 0)
 		{
-			fprintf(stderr, "WARNING: Task finalization failed for task %s\n", task_name);
+			fprintf(stderr, "ERROR: Task finalization failed for task %s\n", task_name);
+			finalize_failed = true;
 		}
 	}
 	
 	std::cerr << "Deadlines missed for task " << task_name << ": " << deadlines_missed << " / " << num_iters << std::endl;
 	std::cerr << "Max running time for task " << task_name << ": " << max_period_runtime << " secs" << std::endl;
+	if (counters_open)
+	{
+		report_job_counters(task_name, &counters, &counter_stats);
+		job_counters_close(&counters);
+	}
 	
-	return 0;
+	return finalize_failed ? RT_GOMP_TASK_MANAGER_FINALIZE_TASK_ERROR : RT_GOMP_TASK_MANAGER_SUCCESS;
 }
 
@@ -0,0 +1,306 @@
+#include "taskset_file.h"
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+// Whether a word on line C is a memory:mb annotation rather than a resource
+static bool is_memory_annotation(const std::string & word)
+{
+	return word.compare(0, 7, "memory:") == 0;
+}
+
+// Converts the seconds and nanoseconds words at timing[index] to nanoseconds
+static bool parse_time(const std::vector<std::string> & timing, unsigned index, int64_t *ns)
+{
+	long long sec, nsec;
+	if (!(std::istringstream(timing[index]) >> sec && std::istringstream(timing[index + 1]) >> nsec))
+	{
+		return false;
+	}
+	*ns = sec * 1000000000LL + nsec;
+	return true;
+}
+
+int read_taskset_file(const char *filename, taskset_file_t *taskset)
+{
+	std::ifstream ifs(filename);
+	if (!ifs.is_open())
+	{
+		fprintf(stderr, "ERROR: Cannot open taskset file %s\n", filename);
+		return RT_GOMP_TASKSET_FILE_OPEN_ERROR;
+	}
+
+	taskset->entries.clear();
+	taskset->has_resources = false;
+
+	std::string line;
+	if (!(std::getline(ifs, line) && std::istringstream(line) >> taskset->first_core >> taskset->last_core) || taskset->last_core < taskset->first_core)
+	{
+		fprintf(stderr, "ERROR: First line of %s should be: first_core last_core\n", filename);
+		return RT_GOMP_TASKSET_FILE_PARSE_ERROR;
+	}
+
+	// Lines B and C alternate, blank lines are skipped
+	bool expect_timing = false;
+	while (std::getline(ifs, line))
+	{
+		std::istringstream words(line);
+		std::string word;
+		if (!(words >> word)) continue;
+
+		if (!expect_timing)
+		{
+			taskset_entry_t entry;
+			entry.program = line.substr(line.find_first_not_of(" \t"));
+			entry.program = entry.program.substr(0, entry.program.find_last_not_of(" \t\r") + 1);
+			taskset->entries.push_back(entry);
+		}
+		else
+		{
+			std::vector<std::string> & timing = taskset->entries.back().timing;
+			do { timing.push_back(word); } while (words >> word);
+			if (timing.size() < taskset_num_timing_params)
+			{
+				fprintf(stderr, "ERROR: Invalid parameters: %s\n", line.c_str());
+				return RT_GOMP_TASKSET_FILE_PARSE_ERROR;
+			}
+			for (unsigned k = taskset_num_timing_params; k < timing.size(); ++k)
+			{
+				if (!is_memory_annotation(timing[k])) taskset->has_resources = true;
+			}
+		}
+		expect_timing = !expect_timing;
+	}
+
+	if (expect_timing)
+	{
+		fprintf(stderr, "ERROR: No parameters for the last program in %s\n", filename);
+		return RT_GOMP_TASKSET_FILE_PARSE_ERROR;
+	}
+	return RT_GOMP_TASKSET_FILE_SUCCESS;
+}
+
+int taskset_problem(const taskset_file_t *taskset, partition_problem_t *problem)
+{
+	int ret_val = RT_GOMP_TASKSET_FILE_SUCCESS;
+	problem->num_cores = taskset->last_core - taskset->first_core + 1;
+	problem->topology = NULL;
+	problem->first_cpu = taskset->first_core;
+	problem->smt_policy = PARTITION_SMT_IGNORE;
+	problem->smt_slowdown = 1.0;
+	problem->core_speed.clear();
+	problem->core_domain.clear();
+	problem->domain_bandwidth.clear();
+	problem->search_seconds = partition_default_search_seconds;
+	problem->tasks.clear();
+
+	for (unsigned i = 0; i < taskset->entries.size(); ++i)
+	{
+		const std::vector<std::string> & timing = taskset->entries[i].timing;
+		partition_task_t task;
+		if (!(parse_time(timing, 0, &task.work) && parse_time(timing, 2, &task.span) &&
+			parse_time(timing, 4, &task.period) && parse_time(timing, 6, &task.deadline) && task.period > 0))
+		{
+			fprintf(stderr, "ERROR: Invalid timing parameters for %s\n", taskset->entries[i].program.c_str());
+			ret_val = RT_GOMP_TASKSET_FILE_PARSE_ERROR;
+			continue;
+		}
+		if (task.deadline > task.period || task.deadline <= 0)
+		{
+			fprintf(stderr, "ERROR: Deadline not within the period for %s\n", taskset->entries[i].program.c_str());
+			ret_val = RT_GOMP_TASKSET_FILE_PARSE_ERROR;
+		}
+		task.util = 1.0 * task.work / task.period;
+		// Memory traffic per job over the period
+		task.bandwidth = 0;
+		for (unsigned k = taskset_num_timing_params; k < timing.size(); ++k)
+		{
+			double traffic;
+			char trailing;
+			if (!is_memory_annotation(timing[k])) continue;
+			if (sscanf(timing[k].c_str() + 7, "%lf%c", &traffic, &trailing) != 1 || traffic < 0)
+			{
+				fprintf(stderr, "ERROR: Invalid memory traffic, should be memory:mb: %s\n", timing[k].c_str());
+				ret_val = RT_GOMP_TASKSET_FILE_PARSE_ERROR;
+				continue;
+			}
+			task.bandwidth = traffic / (task.period / 1e9);
+		}
+		if (task.util >= 1.0 && 2 * task.span > task.deadline)
+		{
+			fprintf(stderr, "ERROR: Critical path length too long for %s\n", taskset->entries[i].program.c_str());
+			ret_val = RT_GOMP_TASKSET_FILE_PARSE_ERROR;
+		}
+		problem->tasks.push_back(task);
+	}
+
+	partition_problem_prepare(problem);
+	return ret_val;
+}
+
+int write_schedule_file(const char *filename, const taskset_file_t *taskset, const partition_result_t *result)
+{
+	FILE *file = fopen(filename, "w");
+	if (file == NULL)
+	{
+		perror("ERROR: write_schedule_file call to fopen failed");
+		return RT_GOMP_TASKSET_FILE_OPEN_ERROR;
+	}
+
+	fprintf(file, "%d\n%u %u\n", result->sched, taskset->first_core, taskset->last_core);
+	for (unsigned i = 0; i < result->placement.size(); ++i)
+	{
+		const taskset_entry_t & entry = taskset->entries[i];
+		fprintf(file, "%s\n", entry.program.c_str());
+		for (unsigned k = 0; k < entry.timing.size(); ++k)
+		{
+			fprintf(file, k == 0 ? "%s" : " %s", entry.timing[k].c_str());
+		}
+		const partition_placement_t & placement = result->placement[i];
+		fprintf(file, "\n%u %u %d", taskset->first_core + placement.first_core, taskset->first_core + placement.last_core, placement.priority);
+		if (placement.budget > 0)
+		{
+			fprintf(file, " %lld %lld %lld %lld", static_cast<long long>(placement.budget / 1000000000), static_cast<long long>(placement.budget % 1000000000),
+				static_cast<long long>(placement.budget_period / 1000000000), static_cast<long long>(placement.budget_period % 1000000000));
+		}
+		for (unsigned k = 0; k < placement.segments.size(); ++k)
+		{
+			const partition_segment_t & segment = placement.segments[k];
+			fprintf(file, " %lld:%lld:%u:%d", static_cast<long long>(segment.budget / 1000000000), static_cast<long long>(segment.budget % 1000000000),
+				taskset->first_core + segment.core, segment.priority);
+		}
+		fprintf(file, "\n");
+	}
+
+	if (fclose(file) != 0)
+	{
+		perror("ERROR: write_schedule_file call to fclose failed");
+		return RT_GOMP_TASKSET_FILE_OPEN_ERROR;
+	}
+	return RT_GOMP_TASKSET_FILE_SUCCESS;
+}
+
+// Parses line D of a task: its cores and priority, then the budget of a
+// semi-federated task or the migrations of a split task
+static bool parse_placement(const std::string & line, unsigned first_core, partition_placement_t *placement)
+{
+	std::istringstream words(line);
+	unsigned task_first, task_last;
+	if (!(words >> task_first >> task_last >> placement->priority) || task_first < first_core || task_last < task_first)
+	{
+		return false;
+	}
+	placement->first_core = task_first - first_core;
+	placement->last_core = task_last - first_core;
+	placement->budget = 0;
+	placement->budget_period = 0;
+	placement->slowdown = 1.0;
+	placement->segments.clear();
+
+	std::vector<std::string> rest;
+	std::string word;
+	while (words >> word) rest.push_back(word);
+	unsigned k = 0;
+	if (!rest.empty() && rest[0].find(':') == std::string::npos)
+	{
+		std::vector<std::string> budget(rest.begin(), rest.begin() + std::min<size_t>(rest.size(), 4));
+		if (budget.size() < 4 || !parse_time(budget, 0, &placement->budget) || !parse_time(budget, 2, &placement->budget_period))
+		{
+			return false;
+		}
+		k = 4;
+	}
+	for (; k < rest.size(); ++k)
+	{
+		long long sec, nsec;
+		unsigned core;
+		int priority;
+		char trailing;
+		if (sscanf(rest[k].c_str(), "%lld:%lld:%u:%d%c", &sec, &nsec, &core, &priority, &trailing) != 4 || core < first_core)
+		{
+			return false;
+		}
+		partition_segment_t segment = { sec * 1000000000LL + nsec, core - first_core, priority };
+		placement->segments.push_back(segment);
+	}
+	return true;
+}
+
+int read_schedule_file(const char *filename, taskset_file_t *taskset, partition_result_t *result)
+{
+	std::ifstream ifs(filename);
+	if (!ifs.is_open())
+	{
+		fprintf(stderr, "ERROR: Cannot open schedule file %s\n", filename);
+		return RT_GOMP_TASKSET_FILE_OPEN_ERROR;
+	}
+
+	taskset->entries.clear();
+	taskset->has_resources = false;
+	result->placement.clear();
+
+	std::string line;
+	int sched;
+	if (!(std::getline(ifs, line) && std::istringstream(line) >> sched && sched >= PARTITION_SCHEDULABLE && sched <= PARTITION_UNSCHEDULABLE) ||
+		!(std::getline(ifs, line) && std::istringstream(line) >> taskset->first_core >> taskset->last_core) || taskset->last_core < taskset->first_core)
+	{
+		fprintf(stderr, "ERROR: First lines of %s should be: schedulability, then first_core last_core\n", filename);
+		return RT_GOMP_TASKSET_FILE_PARSE_ERROR;
+	}
+	result->sched = static_cast<partition_schedulability>(sched);
+	result->search_timed_out = false;
+
+	// Lines B, C and D follow for each task, blank lines are skipped
+	unsigned line_kind = 0;
+	while (std::getline(ifs, line))
+	{
+		std::istringstream words(line);
+		std::string word;
+		if (!(words >> word)) continue;
+
+		if (line_kind == 0)
+		{
+			taskset_entry_t entry;
+			entry.program = line.substr(line.find_first_not_of(" \t"));
+			entry.program = entry.program.substr(0, entry.program.find_last_not_of(" \t\r") + 1);
+			taskset->entries.push_back(entry);
+		}
+		else if (line_kind == 1)
+		{
+			std::vector<std::string> & timing = taskset->entries.back().timing;
+			do { timing.push_back(word); } while (words >> word);
+			if (timing.size() < taskset_num_timing_params)
+			{
+				fprintf(stderr, "ERROR: Invalid parameters: %s\n", line.c_str());
+				return RT_GOMP_TASKSET_FILE_PARSE_ERROR;
+			}
+			for (unsigned k = taskset_num_timing_params; k < timing.size(); ++k)
+			{
+				if (!is_memory_annotation(timing[k])) taskset->has_resources = true;
+			}
+		}
+		else
+		{
+			partition_placement_t placement;
+			const unsigned num_cores = taskset->last_core - taskset->first_core + 1;
+			bool valid = parse_placement(line, taskset->first_core, &placement) && placement.last_core < num_cores;
+			for (unsigned k = 0; valid && k < placement.segments.size(); ++k) valid = placement.segments[k].core < num_cores;
+			if (!valid)
+			{
+				fprintf(stderr, "ERROR: Invalid placement, should be first_core last_core priority [budget] [migrations]: %s\n", line.c_str());
+				return RT_GOMP_TASKSET_FILE_PARSE_ERROR;
+			}
+			result->placement.push_back(placement);
+		}
+		line_kind = (line_kind + 1) % 3;
+	}
+
+	if (line_kind != 0)
+	{
+		fprintf(stderr, "ERROR: Provide three lines for each task in %s\n", filename);
+		return RT_GOMP_TASKSET_FILE_PARSE_ERROR;
+	}
+	return RT_GOMP_TASKSET_FILE_SUCCESS;
+}
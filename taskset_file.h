@@ -0,0 +1,57 @@
+#ifndef RT_GOMP_TASKSET_FILE_H
+#define RT_GOMP_TASKSET_FILE_H
+
+#include <string>
+#include <vector>
+#include "partition.h"
+
+// Reading taskset (.rtpt) files and writing schedule (.rtps) files in the
+// formats described at the top of cluster.py, for the C++ partitioning tools.
+
+enum rt_gomp_taskset_file_error_codes
+{
+	RT_GOMP_TASKSET_FILE_SUCCESS,
+	RT_GOMP_TASKSET_FILE_OPEN_ERROR,
+	RT_GOMP_TASKSET_FILE_PARSE_ERROR
+};
+
+// The timing parameters on line C of a task
+const unsigned taskset_num_timing_params = 11;
+
+typedef struct
+{
+	// Line B as written: program name and arguments
+	std::string program;
+	// Line C split into words: the timing parameters and any annotations
+	std::vector<std::string> timing;
+}
+taskset_entry_t;
+
+typedef struct
+{
+	unsigned first_core;
+	unsigned last_core;
+	std::vector<taskset_entry_t> entries;
+	// Whether any task has shared resource annotations (see resource_lock.h).
+	// Memory traffic annotations are not resources.
+	bool has_resources;
+}
+taskset_file_t;
+
+// Reads filename (including the .rtpt extension)
+int read_taskset_file(const char *filename, taskset_file_t *taskset);
+
+// Fills in problem->tasks and problem->num_cores and prepares the problem.
+// Reports the same errors as readinput() in cluster.py.
+int taskset_problem(const taskset_file_t *taskset, partition_problem_t *problem);
+
+// Writes the partition of taskset to filename (including the .rtps extension)
+int write_schedule_file(const char *filename, const taskset_file_t *taskset, const partition_result_t *result);
+
+// Reads a schedule (.rtps) file written by cluster.py or partition_explorer:
+// the tasks into taskset, as read_taskset_file would, and the partition into
+// result, with cores relative to the first core and no SMT slowdown. The
+// metrics of the result are left for partition_evaluate.
+int read_schedule_file(const char *filename, taskset_file_t *taskset, partition_result_t *result);
+
+#endif /* RT_GOMP_TASKSET_FILE_H */
@@ -0,0 +1,61 @@
+#include "taskset_generator.h"
+#include <math.h>
+#include <algorithm>
+
+uint64_t taskset_seed(uint64_t seed, uint64_t point, uint64_t index)
+{
+	taskset_rng_t rng = { seed };
+	rng.state ^= taskset_rng_next(&rng) + point;
+	rng.state ^= taskset_rng_next(&rng) + index;
+	return taskset_rng_next(&rng);
+}
+
+static double uniform(taskset_rng_t *rng, double min, double max)
+{
+	return min + (max - min) * taskset_rng_uniform(rng);
+}
+
+void generate_taskset(const taskset_distribution_t *distribution, double total_util, uint64_t seed, partition_problem_t *problem)
+{
+	taskset_rng_t rng = { seed };
+	problem->num_cores = distribution->num_cores;
+	problem->topology = NULL;
+	problem->first_cpu = 0;
+	problem->smt_policy = PARTITION_SMT_IGNORE;
+	problem->smt_slowdown = 1.0;
+	problem->core_speed.clear();
+	problem->core_domain.clear();
+	problem->domain_bandwidth.clear();
+	problem->search_seconds = partition_default_search_seconds;
+	problem->tasks.clear();
+
+	const double log_min_period = log(static_cast<double>(distribution->min_period));
+	const double log_max_period = log(static_cast<double>(distribution->max_period));
+	double remaining = total_util;
+	while (remaining > 1e-9)
+	{
+		partition_task_t task;
+		const bool heavy = taskset_rng_uniform(&rng) < distribution->heavy_fraction;
+		task.util = heavy ? uniform(&rng, distribution->min_heavy_util, distribution->max_heavy_util)
+		                  : uniform(&rng, distribution->min_light_util, distribution->max_light_util);
+		if (task.util > remaining) task.util = remaining;
+		remaining -= task.util;
+
+		task.period = static_cast<int64_t>(exp(uniform(&rng, log_min_period, log_max_period)));
+		task.work = static_cast<int64_t>(task.util * task.period);
+		if (task.work < 1) task.work = 1;
+		task.util = 1.0 * task.work / task.period;
+		task.bandwidth = 0;
+
+		const double span_ratio = uniform(&rng, distribution->min_span_ratio, distribution->max_span_ratio);
+		// Implicit deadlines take no draw, so they keep the tasksets of earlier experiments
+		const double deadline_ratio = distribution->min_deadline_ratio == distribution->max_deadline_ratio ? distribution->min_deadline_ratio
+			: uniform(&rng, distribution->min_deadline_ratio, distribution->max_deadline_ratio);
+		task.deadline = std::max<int64_t>(static_cast<int64_t>(deadline_ratio * task.period), 1);
+		task.span = heavy ? static_cast<int64_t>(span_ratio * task.work) : task.work;
+		if (heavy && 2 * task.span > task.deadline) task.span = task.deadline / 2;
+		problem->tasks.push_back(task);
+	}
+
+	partition_problem_prepare(problem);
+}
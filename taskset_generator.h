@@ -0,0 +1,64 @@
+#ifndef RT_GOMP_TASKSET_GENERATOR_H
+#define RT_GOMP_TASKSET_GENERATOR_H
+
+#include <stdint.h>
+#include "partition.h"
+
+// Random tasksets for evaluating the partitioner (see acceptance_experiment).
+// A taskset is a function of the distribution, the total utilization and a
+// 64 bit seed only, so experiments give the same tasksets whatever the number
+// of threads or the order in which tasksets are generated.
+
+typedef struct
+{
+	unsigned num_cores;
+	// Periods are log-uniform in [min_period, max_period] (ns), and deadlines
+	// uniform in [min_deadline_ratio, max_deadline_ratio] times the period
+	int64_t min_period;
+	int64_t max_period;
+	double min_deadline_ratio;
+	double max_deadline_ratio;
+	// Each task is heavy with probability heavy_fraction. Heavy task utilizations
+	// are uniform in [min_heavy_util, max_heavy_util], light ones in
+	// [min_light_util, max_light_util].
+	double heavy_fraction;
+	double min_heavy_util;
+	double max_heavy_util;
+	double min_light_util;
+	double max_light_util;
+	// The span of a heavy task is uniform in [min_span_ratio, max_span_ratio]
+	// times its work, and at most half its deadline. Light tasks are sequential.
+	double min_span_ratio;
+	double max_span_ratio;
+}
+taskset_distribution_t;
+
+// A small, fast generator (splitmix64) for per taskset random streams
+typedef struct
+{
+	uint64_t state;
+}
+taskset_rng_t;
+
+inline uint64_t taskset_rng_next(taskset_rng_t *rng)
+{
+	uint64_t z = (rng->state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+// Uniform in [0, 1)
+inline double taskset_rng_uniform(taskset_rng_t *rng)
+{
+	return (taskset_rng_next(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Combines an experiment seed with the coordinates of a taskset into its seed
+uint64_t taskset_seed(uint64_t seed, uint64_t point, uint64_t index);
+
+// Fills problem with tasks drawn from the distribution until their utilization
+// sums to total_util (the last task is cut short), and prepares it.
+void generate_taskset(const taskset_distribution_t *distribution, double total_util, uint64_t seed, partition_problem_t *problem);
+
+#endif /* RT_GOMP_TASKSET_GENERATOR_H */
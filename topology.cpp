@@ -0,0 +1,332 @@
+#include "topology.h"
+#include "numa_placement.h"
+#include <limits.h>
+#include <math.h>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+static bool read_first_line(const std::string & path, std::string & line)
+{
+	std::ifstream ifs(path.c_str());
+	return ifs.is_open() && std::getline(ifs, line);
+}
+
+// Returns the first cpu of the cpu list in the file at path, or fallback
+static int first_cpu_of_list(const std::string & path, int fallback)
+{
+	std::string line;
+	std::vector<unsigned> cpus;
+	if (!read_first_line(path, line) || !parse_cpu_list(line, cpus) || cpus.empty()) return fallback;
+	return cpus[0];
+}
+
+int read_topology(topology_t *topology)
+{
+	topology->cpus.clear();
+	topology->node_bandwidth.clear();
+	std::string line;
+	std::vector<unsigned> online;
+	if (!read_first_line("/sys/devices/system/cpu/online", line) || !parse_cpu_list(line, online))
+	{
+		fprintf(stderr, "ERROR: Cannot read the online cpus from /sys\n");
+		return RT_GOMP_TOPOLOGY_SYSFS_ERROR;
+	}
+
+	std::vector<unsigned> node_of_cpu;
+	if (read_numa_node_of_cpus(node_of_cpu) != RT_GOMP_NUMA_PLACEMENT_SUCCESS)
+	{
+		return RT_GOMP_TOPOLOGY_SYSFS_ERROR;
+	}
+
+	for (unsigned i = 0; i < online.size(); ++i)
+	{
+		std::ostringstream cpu_dir;
+		cpu_dir << "/sys/devices/system/cpu/cpu" << online[i] << "/";
+		topology_cpu_t cpu;
+		cpu.cpu = online[i];
+		cpu.socket = 0;
+		if (read_first_line(cpu_dir.str() + "topology/physical_package_id", line))
+		{
+			std::istringstream(line) >> cpu.socket;
+		}
+		cpu.node = online[i] < node_of_cpu.size() ? node_of_cpu[online[i]] : 0;
+		cpu.core = first_cpu_of_list(cpu_dir.str() + "topology/thread_siblings_list", online[i]);
+		cpu.speed = 1.0;
+
+		// The last level cache is the highest level index, and is named after
+		// its first cpu. Without cache information, the socket stands in for it.
+		cpu.llc = first_cpu_of_list(cpu_dir.str() + "topology/core_siblings_list", online[i]);
+		int llc_level = 0;
+		for (unsigned index = 0; ; ++index)
+		{
+			std::ostringstream cache_dir;
+			cache_dir << cpu_dir.str() << "cache/index" << index << "/";
+			int level;
+			if (!read_first_line(cache_dir.str() + "level", line)) break;
+			if (std::istringstream(line) >> level && level > llc_level)
+			{
+				llc_level = level;
+				cpu.llc = first_cpu_of_list(cache_dir.str() + "shared_cpu_list", cpu.llc);
+			}
+		}
+		topology->cpus.push_back(cpu);
+	}
+	return RT_GOMP_TOPOLOGY_SUCCESS;
+}
+
+int read_topology_file(const char *filename, topology_t *topology)
+{
+	topology->cpus.clear();
+	topology->node_bandwidth.clear();
+	std::ifstream ifs(filename);
+	if (!ifs.is_open())
+	{
+		fprintf(stderr, "ERROR: Cannot open topology file %s\n", filename);
+		return RT_GOMP_TOPOLOGY_FILE_OPEN_ERROR;
+	}
+
+	std::string line;
+	while (std::getline(ifs, line))
+	{
+		std::istringstream words(line);
+		std::string first;
+		if (!(words >> first) || first[0] == '#') continue;
+		if (first == "bandwidth")
+		{
+			int node;
+			double bandwidth;
+			std::string extra;
+			if (!(words >> node >> bandwidth) || bandwidth <= 0 || words >> extra)
+			{
+				fprintf(stderr, "ERROR: Invalid bandwidth line, should be bandwidth node mb_per_sec: %s\n", line.c_str());
+				return RT_GOMP_TOPOLOGY_FILE_PARSE_ERROR;
+			}
+			topology->node_bandwidth[node] = bandwidth;
+			continue;
+		}
+
+		topology_cpu_t cpu;
+		std::istringstream fields(line);
+		std::string extra;
+		cpu.speed = 1.0;
+		if (!(fields >> cpu.cpu >> cpu.socket >> cpu.node >> cpu.llc >> cpu.core) ||
+			(fields >> extra && !(std::istringstream(extra) >> cpu.speed && cpu.speed > 0 && !(fields >> extra))))
+		{
+			fprintf(stderr, "ERROR: Invalid topology line, should be cpu socket node llc core [speed]: %s\n", line.c_str());
+			return RT_GOMP_TOPOLOGY_FILE_PARSE_ERROR;
+		}
+		topology->cpus.push_back(cpu);
+	}
+
+	std::sort(topology->cpus.begin(), topology->cpus.end(),
+		[](const topology_cpu_t & a, const topology_cpu_t & b) { return a.cpu < b.cpu; });
+	return RT_GOMP_TOPOLOGY_SUCCESS;
+}
+
+void write_topology_file(FILE *file, const topology_t *topology)
+{
+	fprintf(file, "# cpu socket node llc core speed\n");
+	for (unsigned i = 0; i < topology->cpus.size(); ++i)
+	{
+		const topology_cpu_t & cpu = topology->cpus[i];
+		fprintf(file, "%u %d %d %d %d %.3f\n", cpu.cpu, cpu.socket, cpu.node, cpu.llc, cpu.core, cpu.speed);
+	}
+	if (topology->node_bandwidth.empty()) return;
+	fprintf(file, "# bandwidth node mb_per_sec\n");
+	for (std::map<int, double>::const_iterator it = topology->node_bandwidth.begin(); it != topology->node_bandwidth.end(); ++it)
+	{
+		fprintf(file, "bandwidth %d %.0f\n", it->first, it->second);
+	}
+}
+
+void topology_speeds(const topology_t *topology, unsigned first_cpu, unsigned num_cpus, std::vector<double> & speeds)
+{
+	speeds.assign(num_cpus, 1.0);
+	bool uniform = true;
+	for (unsigned c = 0; c < num_cpus; ++c)
+	{
+		const topology_cpu_t *entry = topology_find_cpu(topology, first_cpu + c);
+		if (entry != NULL) speeds[c] = entry->speed;
+		if (speeds[c] != 1.0) uniform = false;
+	}
+	if (uniform) speeds.clear();
+}
+
+void topology_memory_domains(const topology_t *topology, unsigned first_cpu, unsigned num_cpus,
+	std::vector<unsigned> & core_domain, std::vector<double> & domain_bandwidth)
+{
+	core_domain.clear();
+	domain_bandwidth.clear();
+	if (topology->node_bandwidth.empty()) return;
+
+	std::map<int, unsigned> domain_of_node;
+	for (unsigned c = 0; c < num_cpus; ++c)
+	{
+		const int node = topology_domain(topology, first_cpu + c, TOPOLOGY_NUMA_NODE);
+		std::map<int, unsigned>::const_iterator domain = domain_of_node.find(node);
+		if (domain == domain_of_node.end())
+		{
+			std::map<int, double>::const_iterator bandwidth = topology->node_bandwidth.find(node);
+			domain = domain_of_node.insert(std::make_pair(node, domain_bandwidth.size())).first;
+			domain_bandwidth.push_back(bandwidth == topology->node_bandwidth.end() ? HUGE_VAL : bandwidth->second);
+		}
+		core_domain.push_back(domain->second);
+	}
+}
+
+const topology_cpu_t *topology_find_cpu(const topology_t *topology, unsigned cpu)
+{
+	std::vector<topology_cpu_t>::const_iterator it = std::lower_bound(topology->cpus.begin(), topology->cpus.end(), cpu,
+		[](const topology_cpu_t & a, unsigned b) { return a.cpu < b; });
+	return it != topology->cpus.end() && it->cpu == cpu ? &*it : NULL;
+}
+
+int topology_domain(const topology_t *topology, unsigned cpu, topology_level level)
+{
+	if (level == TOPOLOGY_MACHINE) return 0;
+	const topology_cpu_t *entry = topology_find_cpu(topology, cpu);
+	if (entry == NULL) return -1;
+	switch (level)
+	{
+		case TOPOLOGY_LLC: return entry->llc;
+		case TOPOLOGY_NUMA_NODE: return entry->node;
+		default: return entry->socket;
+	}
+}
+
+void topology_siblings(const topology_t *topology, unsigned cpu, std::vector<unsigned> & siblings)
+{
+	const topology_cpu_t *entry = topology_find_cpu(topology, cpu);
+	if (entry == NULL) return;
+	for (unsigned i = 0; i < topology->cpus.size(); ++i)
+	{
+		if (topology->cpus[i].core == entry->core && topology->cpus[i].cpu != cpu) siblings.push_back(topology->cpus[i].cpu);
+	}
+}
+
+// For each cpu of the range starting at first_cpu, the other cpus of its
+// physical core within the range
+static void siblings_in_range(const topology_t *topology, unsigned first_cpu, unsigned num_cpus,
+	std::vector<std::vector<unsigned> > & siblings)
+{
+	std::map<int, std::vector<unsigned> > cpus_of_core;
+	for (unsigned c = 0; c < num_cpus; ++c)
+	{
+		const topology_cpu_t *entry = topology_find_cpu(topology, first_cpu + c);
+		if (entry != NULL) cpus_of_core[entry->core].push_back(c);
+	}
+
+	siblings.assign(num_cpus, std::vector<unsigned>());
+	for (std::map<int, std::vector<unsigned> >::const_iterator it = cpus_of_core.begin(); it != cpus_of_core.end(); ++it)
+	{
+		for (unsigned i = 0; i < it->second.size(); ++i)
+		{
+			for (unsigned k = 0; k < it->second.size(); ++k)
+			{
+				if (k != i) siblings[it->second[i]].push_back(it->second[k]);
+			}
+		}
+	}
+}
+
+bool topology_shares_cores(const topology_t *topology, unsigned first_cpu, const std::vector<bool> & cpus)
+{
+	std::vector<std::vector<unsigned> > siblings;
+	siblings_in_range(topology, first_cpu, cpus.size(), siblings);
+	for (unsigned c = 0; c < cpus.size(); ++c)
+	{
+		if (!cpus[c]) continue;
+		for (unsigned k = 0; k < siblings[c].size(); ++k)
+		{
+			if (cpus[siblings[c][k]]) return true;
+		}
+	}
+	return false;
+}
+
+bool topology_place_clusters(const topology_t *topology, unsigned first_cpu, const std::vector<unsigned> & sizes,
+	bool whole_cores, std::vector<bool> & used, std::vector<unsigned> & first_cores)
+{
+	const unsigned num_cpus = used.size();
+	std::vector<bool> placed = used;
+	first_cores.assign(sizes.size(), 0);
+
+	std::vector<std::vector<unsigned> > siblings;
+	if (whole_cores) siblings_in_range(topology, first_cpu, num_cpus, siblings);
+	// Whether cpu c can join a cluster that starts at start
+	auto usable = [&](unsigned c, unsigned start)
+	{
+		if (placed[c]) return false;
+		if (!whole_cores) return true;
+		for (unsigned k = 0; k < siblings[c].size(); ++k)
+		{
+			const unsigned sibling = siblings[c][k];
+			if (placed[sibling] || (sibling >= start && sibling < c)) return false;
+		}
+		return true;
+	};
+
+	std::vector<unsigned> order(sizes.size());
+	for (unsigned i = 0; i < order.size(); ++i) order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&sizes](unsigned a, unsigned b) { return sizes[a] > sizes[b]; });
+
+	for (unsigned i = 0; i < order.size(); ++i)
+	{
+		const unsigned size = sizes[order[i]];
+		bool found = false;
+		for (int level = TOPOLOGY_LLC; level < num_topology_levels && !found; ++level)
+		{
+			// Best fit among the runs of free cpus within one domain
+			unsigned best_start = 0, best_length = UINT_MAX;
+			for (unsigned c = 0; c < num_cpus; )
+			{
+				if (!usable(c, c))
+				{
+					++c;
+					continue;
+				}
+				const int domain = topology_domain(topology, first_cpu + c, static_cast<topology_level>(level));
+				const unsigned start = c;
+				while (c < num_cpus && usable(c, start) && topology_domain(topology, first_cpu + c, static_cast<topology_level>(level)) == domain) ++c;
+				if (c - start >= size && c - start < best_length)
+				{
+					best_start = start;
+					best_length = c - start;
+				}
+			}
+
+			if (best_length != UINT_MAX)
+			{
+				for (unsigned c = best_start; c < best_start + size; ++c)
+				{
+					placed[c] = true;
+					if (!whole_cores) continue;
+					for (unsigned k = 0; k < siblings[c].size(); ++k) placed[siblings[c][k]] = true;
+				}
+				first_cores[order[i]] = best_start;
+				found = true;
+			}
+		}
+		if (!found) return false;
+	}
+
+	used = placed;
+	return true;
+}
+
+int topology_place(const char *topology_file, unsigned first_cpu, unsigned num_cpus,
+	const unsigned *sizes, unsigned num_clusters, unsigned *first_cores)
+{
+	topology_t topology;
+	const int ret_val = topology_file == NULL ? read_topology(&topology) : read_topology_file(topology_file, &topology);
+	if (ret_val != RT_GOMP_TOPOLOGY_SUCCESS) return 0;
+
+	std::vector<bool> used(num_cpus, false);
+	std::vector<unsigned> cluster_sizes(sizes, sizes + num_clusters), cluster_first_cores;
+	if (!topology_place_clusters(&topology, first_cpu, cluster_sizes, false, used, cluster_first_cores)) return 0;
+	std::copy(cluster_first_cores.begin(), cluster_first_cores.end(), first_cores);
+	return 1;
+}
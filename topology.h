@@ -0,0 +1,113 @@
+#ifndef RT_GOMP_TOPOLOGY_H
+#define RT_GOMP_TOPOLOGY_H
+
+#include <stdio.h>
+#include <map>
+#include <vector>
+
+// The processor topology used to place the clusters of heavy tasks: for every
+// cpu its socket, NUMA node, last level cache and physical core (SMT siblings
+// share a core), and its speed. It is read from /sys, or from a file for
+// planning on another machine, with one line per cpu:
+//   cpu socket node llc core [speed]
+// where the llc and core ids are any numbers shared by the cpus of one cache or
+// core. Lines starting with # are comments; write_topology_file gives an example.
+//
+// The speed of a cpu is relative to the cpu that task timings were measured
+// on: work that takes time t there takes t/speed on the cpu. It is 1 if the
+// file does not give it, and in the topology read from /sys, which cannot tell.
+// core_speed_benchmark measures the speeds of the cpus of a machine and writes
+// its topology file with them.
+//
+// A file may also give the memory bandwidth of NUMA nodes, in MB/s, on lines
+//   bandwidth node mb_per_sec
+// which the partitioner shares out among the tasks on the cpus of each node
+// (see partition_problem_t). core_speed_benchmark measures these too.
+
+enum rt_gomp_topology_error_codes
+{
+	RT_GOMP_TOPOLOGY_SUCCESS,
+	RT_GOMP_TOPOLOGY_SYSFS_ERROR,
+	RT_GOMP_TOPOLOGY_FILE_OPEN_ERROR,
+	RT_GOMP_TOPOLOGY_FILE_PARSE_ERROR
+};
+
+// Domains from the smallest to the whole machine. Each one is contained in the next.
+enum topology_level
+{
+	TOPOLOGY_LLC,
+	TOPOLOGY_NUMA_NODE,
+	TOPOLOGY_SOCKET,
+	TOPOLOGY_MACHINE,
+	num_topology_levels
+};
+
+typedef struct
+{
+	unsigned cpu;
+	int socket;
+	int node;
+	int llc;
+	int core;
+	double speed;
+}
+topology_cpu_t;
+
+typedef struct
+{
+	// Sorted by cpu number
+	std::vector<topology_cpu_t> cpus;
+	// Memory bandwidth in MB/s of the NUMA nodes that a file gives it for
+	std::map<int, double> node_bandwidth;
+}
+topology_t;
+
+// Reads the topology of the online cpus from /sys
+int read_topology(topology_t *topology);
+
+int read_topology_file(const char *filename, topology_t *topology);
+void write_topology_file(FILE *file, const topology_t *topology);
+
+// Fills in the speeds of cpus first_cpu..first_cpu+num_cpus-1, 1 for those the
+// topology does not list, or leaves speeds empty if they are all 1
+void topology_speeds(const topology_t *topology, unsigned first_cpu, unsigned num_cpus, std::vector<double> & speeds);
+
+// Fills in the memory domain of cpus first_cpu..first_cpu+num_cpus-1, which
+// is their NUMA node numbered from 0 in order of appearance, and the bandwidth
+// of each domain, unlimited for nodes the topology gives none for. Leaves both
+// empty if the topology gives no bandwidths.
+void topology_memory_domains(const topology_t *topology, unsigned first_cpu, unsigned num_cpus,
+	std::vector<unsigned> & core_domain, std::vector<double> & domain_bandwidth);
+
+// Returns the entry of a cpu, or NULL if the topology does not list it
+const topology_cpu_t *topology_find_cpu(const topology_t *topology, unsigned cpu);
+
+// Returns the id of the domain at level that contains cpu. Cpus missing from the
+// topology are all in domain -1.
+int topology_domain(const topology_t *topology, unsigned cpu, topology_level level);
+
+// Appends the other cpus of the physical core of cpu (its SMT siblings) to siblings
+void topology_siblings(const topology_t *topology, unsigned cpu, std::vector<unsigned> & siblings);
+
+// Returns whether two of the cpus marked in cpus, which start at first_cpu,
+// are SMT siblings
+bool topology_shares_cores(const topology_t *topology, unsigned first_cpu, const std::vector<bool> & cpus);
+
+// Places clusters of consecutive cpus within cpus first_cpu..first_cpu+num_cpus-1,
+// skipping the cpus already marked in used. Each cluster, largest first, goes to
+// the smallest run of free cpus that fits it in the lowest level domain that
+// has one. With whole_cores, a cluster takes at most one cpu of each physical
+// core, and only cores whose cpus are all free; their other cpus are marked
+// used too, so that nothing runs on them. first_cores[i] receives the first
+// core of cluster i, relative to first_cpu, and used is updated. Returns false,
+// leaving used unchanged, if some cluster does not fit in any run of free cpus.
+bool topology_place_clusters(const topology_t *topology, unsigned first_cpu, const std::vector<unsigned> & sizes,
+	bool whole_cores, std::vector<bool> & used, std::vector<unsigned> & first_cores);
+
+// topology_place_clusters for lib_cluster.py, with the topology read from
+// topology_file, or from /sys if it is NULL, and no cpus in use. Returns 1 on
+// success and 0 otherwise.
+extern "C" int topology_place(const char *topology_file, unsigned first_cpu, unsigned num_cpus,
+	const unsigned *sizes, unsigned num_clusters, unsigned *first_cores);
+
+#endif /* RT_GOMP_TOPOLOGY_H */
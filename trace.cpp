@@ -0,0 +1,231 @@
+#include "trace.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <omp.h>
+
+// Records buffered before task_manager writes them out
+static const size_t job_buffer_records = 4096;
+static const size_t thread_buffer_records = 4096;
+// Segments can nest this deep on one thread
+static const unsigned max_segment_depth = 8;
+
+typedef struct
+{
+	std::vector<trace_record_t> records;
+	size_t count;
+	unsigned long dropped;
+	unsigned depth;
+	int64_t open_begin_ns[max_segment_depth];
+	uint32_t open_id[max_segment_depth];
+	// Keep the buffers of different threads on different cache lines
+	char pad[64];
+}
+thread_buffer_t;
+
+static int trace_fd = -1;
+static std::vector<trace_record_t> job_records;
+static std::vector<thread_buffer_t> thread_buffers;
+static uint32_t current_job = 0;
+
+static int64_t to_ns(const timespec & ts)
+{
+	return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int64_t now_ns()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return to_ns(ts);
+}
+
+static int write_all(const void *data, size_t size)
+{
+	const char *bytes = static_cast<const char *>(data);
+	while (size > 0)
+	{
+		const ssize_t written = write(trace_fd, bytes, size);
+		if (written <= 0)
+		{
+			perror("WARNING: trace call to write failed");
+			return RT_GOMP_TRACE_WRITE_FAILED_ERROR;
+		}
+		bytes += written;
+		size -= written;
+	}
+	return RT_GOMP_TRACE_SUCCESS;
+}
+
+int trace_open(const char *task_name, unsigned first_core, unsigned last_core, int priority,
+               const timespec & period, const timespec & deadline)
+{
+	const char *dir = getenv("RT_GOMP_TRACE_DIR");
+	if (dir == NULL || dir[0] == '\0') return RT_GOMP_TRACE_SUCCESS;
+
+	const char *base_name = strrchr(task_name, '/');
+	base_name = (base_name != NULL) ? base_name + 1 : task_name;
+
+	char pid_string[32];
+	snprintf(pid_string, sizeof(pid_string), "_%d.trace", (int) getpid());
+	const std::string filename = std::string(dir) + "/" + base_name + pid_string;
+
+	trace_fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (trace_fd == -1)
+	{
+		fprintf(stderr, "ERROR: Cannot open trace file %s\n", filename.c_str());
+		return RT_GOMP_TRACE_OPEN_FAILED_ERROR;
+	}
+
+	trace_file_header_t header;
+	memset(&header, 0, sizeof(header));
+	header.magic = trace_file_magic;
+	header.version = trace_file_version;
+	snprintf(header.task_name, sizeof(header.task_name), "%s", base_name);
+	header.pid = getpid();
+	header.first_core = first_core;
+	header.last_core = last_core;
+	header.priority = priority;
+	header.period_ns = to_ns(period);
+	header.deadline_ns = to_ns(deadline);
+	if (write_all(&header, sizeof(header)) != 0)
+	{
+		trace_close();
+		return RT_GOMP_TRACE_WRITE_FAILED_ERROR;
+	}
+
+	// Allocate every buffer up front so that recording never allocates
+	job_records.reserve(job_buffer_records);
+	thread_buffers.resize(omp_get_max_threads());
+	for (size_t t = 0; t < thread_buffers.size(); ++t)
+	{
+		thread_buffers[t].records.resize(thread_buffer_records);
+		thread_buffers[t].count = 0;
+		thread_buffers[t].dropped = 0;
+		thread_buffers[t].depth = 0;
+	}
+
+	fprintf(stderr, "Tracing to %s\n", filename.c_str());
+	return RT_GOMP_TRACE_SUCCESS;
+}
+
+bool trace_enabled()
+{
+	return trace_fd != -1;
+}
+
+void trace_job(unsigned job, const timespec & release, const timespec & start, const timespec & finish, bool missed_deadline)
+{
+	if (trace_fd == -1) return;
+
+	trace_record_t record;
+	memset(&record, 0, sizeof(record));
+	record.type = TRACE_RECORD_JOB;
+	record.missed_deadline = missed_deadline;
+	record.id = job;
+	record.job = job;
+	record.release_ns = to_ns(release);
+	record.begin_ns = to_ns(start);
+	record.end_ns = to_ns(finish);
+	job_records.push_back(record);
+	current_job = job + 1;
+}
+
+// Returns the calling thread's buffer, or NULL if tracing is off or the thread
+// is not in the default team
+static thread_buffer_t *get_thread_buffer()
+{
+	if (trace_fd == -1) return NULL;
+	const size_t thread = omp_get_level() > 0 ? omp_get_thread_num() : 0;
+	return thread < thread_buffers.size() ? &thread_buffers[thread] : NULL;
+}
+
+void trace_segment_begin(uint32_t id)
+{
+	thread_buffer_t *buffer = get_thread_buffer();
+	if (buffer == NULL) return;
+
+	if (buffer->depth < max_segment_depth)
+	{
+		buffer->open_id[buffer->depth] = id;
+		buffer->open_begin_ns[buffer->depth] = now_ns();
+	}
+	buffer->depth += 1;
+}
+
+void trace_segment_end(uint32_t id)
+{
+	const int64_t end_ns = now_ns();
+	thread_buffer_t *buffer = get_thread_buffer();
+	if (buffer == NULL || buffer->depth == 0) return;
+
+	buffer->depth -= 1;
+	if (buffer->depth >= max_segment_depth) return;
+	if (buffer->count == buffer->records.size())
+	{
+		buffer->dropped += 1;
+		return;
+	}
+
+	trace_record_t & record = buffer->records[buffer->count++];
+	memset(&record, 0, sizeof(record));
+	record.type = TRACE_RECORD_SEGMENT;
+	record.thread = buffer - &thread_buffers[0];
+	record.core = sched_getcpu();
+	record.id = buffer->open_id[buffer->depth];
+	record.job = current_job;
+	record.begin_ns = buffer->open_begin_ns[buffer->depth];
+	record.end_ns = end_ns;
+}
+
+// Writes out the buffers. Unless forced, only buffers that are at least half full are written.
+static int write_buffers(bool force)
+{
+	if (trace_fd == -1) return RT_GOMP_TRACE_SUCCESS;
+
+	int ret_val = RT_GOMP_TRACE_SUCCESS;
+	if (force || job_records.size() >= job_buffer_records / 2)
+	{
+		if (!job_records.empty()) ret_val = write_all(&job_records[0], job_records.size() * sizeof(trace_record_t));
+		job_records.clear();
+	}
+
+	for (size_t t = 0; t < thread_buffers.size() && ret_val == 0; ++t)
+	{
+		thread_buffer_t & buffer = thread_buffers[t];
+		if (buffer.count > 0 && (force || buffer.count >= buffer.records.size() / 2))
+		{
+			ret_val = write_all(&buffer.records[0], buffer.count * sizeof(trace_record_t));
+			buffer.count = 0;
+		}
+	}
+	return ret_val;
+}
+
+int trace_flush()
+{
+	int ret_val = write_buffers(false);
+	if (ret_val != 0) trace_close();
+	return ret_val;
+}
+
+void trace_close()
+{
+	if (trace_fd == -1) return;
+
+	write_buffers(true);
+	unsigned long dropped = 0;
+	for (size_t t = 0; t < thread_buffers.size(); ++t) dropped += thread_buffers[t].dropped;
+	if (dropped > 0)
+	{
+		fprintf(stderr, "WARNING: %lu trace segments were dropped because a job recorded too many\n", dropped);
+	}
+
+	close(trace_fd);
+	trace_fd = -1;
+}
@@ -0,0 +1,85 @@
+#ifndef RT_GOMP_TRACE_H
+#define RT_GOMP_TRACE_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Timeline tracing of a taskset run. If the environment variable
+// RT_GOMP_TRACE_DIR names a directory, task_manager records the release, start
+// and finish of every job in a binary trace file per task in that directory,
+// and tasks may additionally mark segments of their threads' work with
+// trace_segment_begin and trace_segment_end. trace_export converts the files of
+// all tasks into one Chrome trace event file.
+//
+// Records are kept in memory buffers and written out by task_manager between
+// jobs, so a job never makes a system call for tracing. Segments recorded
+// after a thread's buffer fills up within a job are dropped and counted.
+
+enum rt_gomp_trace_error_codes
+{
+	RT_GOMP_TRACE_SUCCESS,
+	RT_GOMP_TRACE_OPEN_FAILED_ERROR,
+	RT_GOMP_TRACE_WRITE_FAILED_ERROR
+};
+
+const uint32_t trace_file_magic = 0x52544754; // "RTGT"
+const uint32_t trace_file_version = 1;
+
+// The header at the start of each trace file
+typedef struct
+{
+	uint32_t magic;
+	uint32_t version;
+	char task_name[64];
+	int32_t pid;
+	uint32_t first_core;
+	uint32_t last_core;
+	int32_t priority;
+	int64_t period_ns;
+	int64_t deadline_ns;
+}
+trace_file_header_t;
+
+enum trace_record_type
+{
+	TRACE_RECORD_JOB,
+	TRACE_RECORD_SEGMENT
+};
+
+// A job (id is the job number, begin and end are its start and finish) or a
+// segment (id is the segment id given by the task, thread and core tell where
+// it ran). Times are CLOCK_MONOTONIC nanoseconds.
+typedef struct
+{
+	uint8_t type;
+	uint8_t missed_deadline;
+	uint16_t thread;
+	uint32_t core;
+	uint32_t id;
+	uint32_t job;
+	int64_t release_ns;
+	int64_t begin_ns;
+	int64_t end_ns;
+}
+trace_record_t;
+
+// Opens the trace file of the calling task if tracing is enabled. Must be called
+// by the initial thread, outside of any parallel region.
+int trace_open(const char *task_name, unsigned first_core, unsigned last_core, int priority,
+               const timespec & period, const timespec & deadline);
+bool trace_enabled();
+
+// Records a job. Called by task_manager after each job.
+void trace_job(unsigned job, const timespec & release, const timespec & start, const timespec & finish, bool missed_deadline);
+
+// Marks the beginning and end of a segment of work on the calling thread. The
+// id is chosen by the task and shows up as the name of the segment in the trace.
+// Does nothing if tracing is disabled.
+void trace_segment_begin(uint32_t id);
+void trace_segment_end(uint32_t id);
+
+// Writes out the buffered records. Called by task_manager between jobs.
+int trace_flush();
+void trace_close();
+
+#endif /* RT_GOMP_TRACE_H */
@@ -0,0 +1,227 @@
+// Converts the trace files written by task_manager (see trace.h) into one Chrome
+// trace event JSON file, which chrome://tracing and the Perfetto UI open.
+// Usage: trace_export [--jobs-only] output.json trace_file...
+// The timeline has a track per core, showing the jobs of the tasks assigned to
+// it and the segments that ran on it, and a process per task with a track for
+// its jobs and one for each of its threads' segments. Deadline misses are marked
+// with instant events. The files are streamed record by record, so traces of
+// any length can be converted.
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "trace.h"
+
+enum rt_gomp_trace_export_error_codes
+{
+	RT_GOMP_TRACE_EXPORT_SUCCESS,
+	RT_GOMP_TRACE_EXPORT_ARGUMENT_ERROR,
+	RT_GOMP_TRACE_EXPORT_FILE_OPEN_ERROR,
+	RT_GOMP_TRACE_EXPORT_FILE_FORMAT_ERROR
+};
+
+// Records read at a time from each trace file
+static const size_t chunk_records = 4096;
+
+// Chrome trace process ids: one process holds the core tracks, then one per task
+static const int cores_pid = 1;
+static const int first_task_pid = 100;
+
+typedef struct
+{
+	FILE *file;
+	trace_file_header_t header;
+}
+trace_input_t;
+
+static bool first_event = true;
+
+// Starts a new event, separating it from the previous one
+static void begin_event(FILE *out)
+{
+	fputs(first_event ? "\n" : ",\n", out);
+	first_event = false;
+}
+
+// Writes a string with the characters that JSON requires escaped
+static void write_json_string(FILE *out, const char *text)
+{
+	fputc('"', out);
+	for (const char *c = text; *c != '\0'; ++c)
+	{
+		if (*c == '"' || *c == '\\') fputc('\\', out);
+		if ((unsigned char) *c >= 0x20) fputc(*c, out);
+	}
+	fputc('"', out);
+}
+
+static void write_track_name(FILE *out, int pid, int tid, const char *kind, const char *name)
+{
+	begin_event(out);
+	if (tid < 0) fprintf(out, "{\"ph\":\"M\",\"pid\":%d,\"name\":\"%s\",\"args\":{\"name\":", pid, kind);
+	else fprintf(out, "{\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"name\":\"%s\",\"args\":{\"name\":", pid, tid, kind);
+	write_json_string(out, name);
+	fputs("}}", out);
+}
+
+static void write_complete_event(FILE *out, int pid, int tid, const char *category, const std::string & name,
+                                 int64_t begin_ns, int64_t end_ns, int64_t origin_ns, const std::string & args)
+{
+	begin_event(out);
+	fprintf(out, "{\"ph\":\"X\",\"cat\":\"%s\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"name\":",
+	        category, pid, tid, (begin_ns - origin_ns) / 1000.0, (end_ns - begin_ns) / 1000.0);
+	write_json_string(out, name.c_str());
+	if (!args.empty()) fprintf(out, ",\"args\":{%s}", args.c_str());
+	fputc('}', out);
+}
+
+int main(int argc, char *argv[])
+{
+	int arg = 1;
+	bool jobs_only = false;
+	if (arg < argc && strcmp(argv[arg], "--jobs-only") == 0)
+	{
+		jobs_only = true;
+		arg += 1;
+	}
+	if (argc - arg < 2)
+	{
+		fprintf(stderr, "Usage: trace_export [--jobs-only] output.json trace_file...\n");
+		return RT_GOMP_TRACE_EXPORT_ARGUMENT_ERROR;
+	}
+	const char *output_name = argv[arg++];
+
+	// Read the headers, and the first record of each file to find the start of the run
+	std::vector<trace_input_t> inputs;
+	int64_t origin_ns = INT64_MAX;
+	for (; arg < argc; ++arg)
+	{
+		trace_input_t input;
+		input.file = fopen(argv[arg], "rb");
+		if (input.file == NULL)
+		{
+			fprintf(stderr, "ERROR: Cannot open trace file %s\n", argv[arg]);
+			return RT_GOMP_TRACE_EXPORT_FILE_OPEN_ERROR;
+		}
+		if (fread(&input.header, sizeof(input.header), 1, input.file) != 1 ||
+		    input.header.magic != trace_file_magic || input.header.version != trace_file_version)
+		{
+			fprintf(stderr, "ERROR: %s is not a trace file of this version\n", argv[arg]);
+			return RT_GOMP_TRACE_EXPORT_FILE_FORMAT_ERROR;
+		}
+		input.header.task_name[sizeof(input.header.task_name) - 1] = '\0';
+
+		trace_record_t record;
+		if (fread(&record, sizeof(record), 1, input.file) == 1)
+		{
+			const int64_t first_ns = record.type == TRACE_RECORD_JOB ? record.release_ns : record.begin_ns;
+			if (first_ns < origin_ns) origin_ns = first_ns;
+		}
+		fseek(input.file, sizeof(input.header), SEEK_SET);
+		inputs.push_back(input);
+	}
+	if (origin_ns == INT64_MAX) origin_ns = 0;
+
+	FILE *out = fopen(output_name, "w");
+	if (out == NULL)
+	{
+		fprintf(stderr, "ERROR: Cannot open output file %s\n", output_name);
+		return RT_GOMP_TRACE_EXPORT_FILE_OPEN_ERROR;
+	}
+	fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", out);
+
+	// Name the tracks
+	write_track_name(out, cores_pid, -1, "process_name", "Cores");
+	std::vector<bool> core_named;
+	for (size_t f = 0; f < inputs.size(); ++f)
+	{
+		const trace_file_header_t & header = inputs[f].header;
+		for (unsigned core = header.first_core; core <= header.last_core; ++core)
+		{
+			if (core >= core_named.size()) core_named.resize(core + 1, false);
+			if (core_named[core]) continue;
+			core_named[core] = true;
+			char core_name[32];
+			snprintf(core_name, sizeof(core_name), "core %u", core);
+			write_track_name(out, cores_pid, core, "thread_name", core_name);
+		}
+
+		char task_name[160];
+		snprintf(task_name, sizeof(task_name), "%s (pid %d) on cores %u-%u, priority %d", header.task_name,
+		         header.pid, header.first_core, header.last_core, header.priority);
+		write_track_name(out, first_task_pid + f, -1, "process_name", task_name);
+		write_track_name(out, first_task_pid + f, 0, "thread_name", "jobs");
+	}
+
+	// Stream the records of each file
+	std::vector<trace_record_t> records(chunk_records);
+	unsigned long num_jobs = 0, num_segments = 0, num_missed = 0;
+	for (size_t f = 0; f < inputs.size(); ++f)
+	{
+		const trace_file_header_t & header = inputs[f].header;
+		const int task_pid = first_task_pid + f;
+		std::vector<bool> thread_named;
+
+		size_t count;
+		while ((count = fread(&records[0], sizeof(trace_record_t), chunk_records, inputs[f].file)) > 0)
+		{
+			for (size_t r = 0; r < count; ++r)
+			{
+				const trace_record_t & record = records[r];
+				char text[256];
+
+				if (record.type == TRACE_RECORD_JOB)
+				{
+					num_jobs += 1;
+					snprintf(text, sizeof(text), "\"job\":%u,\"release_latency_us\":%.3f,\"response_time_us\":%.3f", record.job,
+					         (record.begin_ns - record.release_ns) / 1000.0, (record.end_ns - record.release_ns) / 1000.0);
+					const std::string args(text);
+					snprintf(text, sizeof(text), "job %u", record.job);
+					write_complete_event(out, task_pid, 0, "job", text, record.begin_ns, record.end_ns, origin_ns, args);
+
+					snprintf(text, sizeof(text), "%s job %u", header.task_name, record.job);
+					for (unsigned core = header.first_core; core <= header.last_core; ++core)
+					{
+						write_complete_event(out, cores_pid, core, "job", text, record.begin_ns, record.end_ns, origin_ns, args);
+					}
+
+					if (record.missed_deadline)
+					{
+						num_missed += 1;
+						begin_event(out);
+						fprintf(out, "{\"ph\":\"i\",\"s\":\"p\",\"cat\":\"deadline\",\"pid\":%d,\"tid\":0,\"ts\":%.3f,\"name\":\"deadline miss\"}",
+						        task_pid, (record.release_ns + header.deadline_ns - origin_ns) / 1000.0);
+					}
+				}
+				else if (record.type == TRACE_RECORD_SEGMENT && !jobs_only)
+				{
+					num_segments += 1;
+					const int tid = record.thread + 1;
+					if ((size_t) tid >= thread_named.size()) thread_named.resize(tid + 1, false);
+					if (!thread_named[tid])
+					{
+						thread_named[tid] = true;
+						snprintf(text, sizeof(text), "thread %u", record.thread);
+						write_track_name(out, task_pid, tid, "thread_name", text);
+					}
+
+					snprintf(text, sizeof(text), "\"job\":%u,\"thread\":%u,\"core\":%u", record.job, record.thread, record.core);
+					const std::string args(text);
+					snprintf(text, sizeof(text), "segment %u", record.id);
+					write_complete_event(out, task_pid, tid, "segment", text, record.begin_ns, record.end_ns, origin_ns, args);
+
+					snprintf(text, sizeof(text), "%s segment %u", header.task_name, record.id);
+					write_complete_event(out, cores_pid, record.core, "segment", text, record.begin_ns, record.end_ns, origin_ns, args);
+				}
+			}
+		}
+		fclose(inputs[f].file);
+	}
+
+	fputs("\n]}\n", out);
+	fclose(out);
+	fprintf(stderr, "Exported %lu jobs (%lu deadline misses) and %lu segments of %zu tasks to %s\n",
+	        num_jobs, num_missed, num_segments, inputs.size(), output_name);
+	return RT_GOMP_TRACE_EXPORT_SUCCESS;
+}
@@ -1,14 +1,27 @@
 // Usage: program_name first_core last_core bucket_width_sec bucket_width_ns num_repetitions arg1 arg2 ...
+// Prints the histogram of the running times of the task on standard output, and
+// on standard error the memory traffic of its worst job as a memory:mb
+// annotation for the .rtpt file, counted as last level cache misses of 64
+// byte lines if the machine has the counter.
 
 #include <stdio.h>
+#include <string.h>
 #include <iostream>
 #include <sstream>
 #include <map>
 #include <omp.h>
+#include <sys/mman.h>
+#include <linux/mempolicy.h>
 #include <unistd.h>
 #include "task.h"
 #include "timespec_functions.h"
+#include "first_touch.h"
 #include "histogram.h"
+#include "task_channel.h"
+#include "job_counters.h"
+
+// Bytes fetched from memory per last level cache miss
+static const double cache_line_size = 64;
 
 enum rt_gomp_utilization_calculator_error_codes
 {
@@ -98,6 +111,23 @@ int main(int argc, char *argv[])
 	omp_get_schedule(&omp_sched, &omp_mod);
 	fprintf(stderr, "OMP sched: %u %u\n", omp_sched, omp_mod);
 	
+	// Bind each OpenMP thread to its own core, as task_manager does
+	const int bind_error = bind_omp_threads(first_core, last_core);
+	if (bind_error != 0)
+	{
+		fprintf(stderr, "ERROR: Could not bind OpenMP threads to cores: %s\n", strerror(bind_error));
+		return RT_GOMP_UTILIZATION_CALCULATOR_CORE_BIND_ERROR;
+	}
+	
+	// Restrict memory to the NUMA nodes of the cores, as task_manager does
+	numa_node_mask_t memory_nodes;
+	if (numa_nodes_of_cores(first_core, last_core, &memory_nodes) != 0 ||
+	    (set_omp_memory_policy(MPOL_BIND, &memory_nodes) != 0 &&
+	     set_omp_memory_policy(MPOL_PREFERRED, &memory_nodes) != 0))
+	{
+		fprintf(stderr, "WARNING: Could not set NUMA memory policy\n");
+	}
+	
 	// Initialize a histogram to record the profiling results
 	const timespec start_with = { 0, 0 };
 	const timespec bucket_width = { bucket_width_sec, bucket_width_ns };
@@ -114,15 +144,38 @@ int main(int argc, char *argv[])
 		}
 	}
 	
+	// Keep the task's memory resident, as task_manager does
+	ret_val = mlockall(MCL_CURRENT | MCL_FUTURE);
+	if (ret_val != 0)
+	{
+		perror("WARNING: Could not lock task memory");
+	}
+	
+	// Count the cache misses of every job for its memory traffic
+	job_counters_t counters;
+	const bool counters_open = job_counters_open(&counters) == RT_GOMP_JOB_COUNTERS_SUCCESS &&
+		counters.available[JOB_COUNTER_LLC_MISSES];
+	job_counts_t counts_before, counts_after;
+	unsigned long long max_llc_misses = 0;
+	
 	// Repeatedly profile runs of the task
 	timespec start, finish, runtime;
 	for (unsigned i = 0; i < num_repetitions; ++i)
 	{
 		get_time(&start);
+		task_channels_sample(start);
+		if (counters_open) job_counters_read(&counters, &counts_before);
 		
 		ret_val = task.run(task_argc, task_argv);
 		
+		if (counters_open) job_counters_read(&counters, &counts_after);
 		get_time(&finish);
+		task_channels_publish(finish);
+		if (counters_open)
+		{
+			const unsigned long long misses = counts_after.values[JOB_COUNTER_LLC_MISSES] - counts_before.values[JOB_COUNTER_LLC_MISSES];
+			if (misses > max_llc_misses) max_llc_misses = misses;
+		}
 		
 		if (ret_val != 0)
 		{
@@ -147,6 +200,16 @@ int main(int argc, char *argv[])
 	// Print out the histogram of profiling results
 	std::cout << histogram << std::endl;
 	
+	if (counters_open)
+	{
+		fprintf(stderr, "Memory traffic of the worst job: memory:%.3f\n", max_llc_misses * cache_line_size / 1e6);
+	}
+	else
+	{
+		fprintf(stderr, "WARNING: No cache miss counter, memory traffic not measured\n");
+	}
+	job_counters_close(&counters);
+	
 	return 0;
 }
 